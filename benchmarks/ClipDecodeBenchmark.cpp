@@ -0,0 +1,157 @@
+#include "support/BenchmarkClips.h"
+#include "support/TestMedia.h"
+#include "core/TextEncoding.h"
+#include "video/ClipConverter.h"
+#include "video/ClipFormat.h"
+#include "video/ClipInput.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+const char* ENCODERS[] = {"mpeg4", "libx264"};
+
+/**
+ * Frames of a pre-converted clip, demuxed and decoded on one thread the way
+ * VideoDecoder reads them (ClipInput through the rawvideo demuxer)
+ */
+class ClipFrames {
+public:
+    ClipFrames() = default;
+    ~ClipFrames() {
+        av_packet_free(&m_packet);
+        avcodec_free_context(&m_decoder);
+        avformat_close_input(&m_input); // Before m_clip, which owns its I/O context
+    }
+
+    ClipFrames(const ClipFrames&) = delete;
+    ClipFrames& operator=(const ClipFrames&) = delete;
+
+    bool Open(const std::wstring& path) {
+        if (!m_clip.Open(path, 0) || !(m_input = avformat_alloc_context())) {
+            return false;
+        }
+        m_input->pb = m_clip.GetContext();
+        m_input->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+        AVDictionary* options = nullptr;
+        m_clip.GetDemuxerOptions(&options);
+        int ret = avformat_open_input(&m_input, ToUtf8(path).c_str(), av_find_input_format("rawvideo"), &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            return false;
+        }
+        m_clip.ApplyStreamInfo(m_input);
+
+        const AVCodecParameters* params = m_input->streams[0]->codecpar;
+        const AVCodec* codec = avcodec_find_decoder(params->codec_id);
+        m_decoder = codec ? avcodec_alloc_context3(codec) : nullptr;
+        m_packet = av_packet_alloc();
+        if (!m_decoder || !m_packet || avcodec_parameters_to_context(m_decoder, params) < 0) {
+            return false;
+        }
+        m_decoder->thread_count = 1;
+        return avcodec_open2(m_decoder, codec, nullptr) >= 0;
+    }
+
+    /**
+     * @return false at end of the clip or on error
+     */
+    bool ReadFrame(AVFrame* frame) {
+        for (;;) {
+            int ret = avcodec_receive_frame(m_decoder, frame);
+            if (ret != AVERROR(EAGAIN)) {
+                return ret >= 0;
+            }
+            if (av_read_frame(m_input, m_packet) < 0) {
+                avcodec_send_packet(m_decoder, nullptr);
+                continue;
+            }
+            avcodec_send_packet(m_decoder, m_packet);
+            av_packet_unref(m_packet);
+        }
+    }
+
+private:
+    ClipInput m_clip;
+    AVFormatContext* m_input = nullptr;
+    AVCodecContext* m_decoder = nullptr;
+    AVPacket* m_packet = nullptr;
+};
+
+/**
+ * Arguments: codec (0=MPEG-4, 1=H.264), input (0=source video, 1=its
+ * pre-converted clip)
+ * Demuxes and decodes a 1080p video or its clip on one thread and reports
+ * the CPU time per frame; color conversion is excluded from both
+ */
+void BM_ClipDecode(benchmark::State& state) {
+    const char* encoder = ENCODERS[state.range(0)];
+    bool clip = state.range(1) != 0;
+    if (!HasEncoder(encoder)) {
+        state.SkipWithError((std::string(encoder) + " encoder not available").c_str());
+        return;
+    }
+
+    ClipSpec spec;
+    spec.width = 1920;
+    spec.height = 1080;
+    spec.codec = encoder;
+    std::string sourcePath = GetBenchmarkClipPath(std::string("clip_source_") + encoder + ".mp4", spec);
+    if (sourcePath.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    std::filesystem::path clipPath = std::filesystem::path(sourcePath).replace_extension(CLIP_FILE_EXTENSION);
+    if (clip && !ClipConverter::Convert(std::filesystem::path(sourcePath).wstring(), clipPath.wstring(),
+                                        spec.width, spec.height, 0)) {
+        state.SkipWithError("Failed to convert clip");
+        return;
+    }
+
+    AVFrame* frame = av_frame_alloc();
+    int64_t frames = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ClipReader source;
+        ClipFrames converted;
+        bool opened = clip ? converted.Open(clipPath.wstring()) : source.Open(sourcePath, 1);
+        state.ResumeTiming();
+        if (!opened) {
+            state.SkipWithError("Failed to open input");
+            break;
+        }
+
+        while (clip ? converted.ReadFrame(frame) : source.ReadFrame(frame)) {
+            av_frame_unref(frame);
+            frames++;
+        }
+    }
+    av_frame_free(&frame);
+
+    std::error_code error;
+    std::filesystem::remove(clipPath, error);
+
+    state.SetItemsProcessed(frames);
+    state.counters["frames"] = benchmark::Counter(static_cast<double>(frames), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_ClipDecode)
+    ->ArgNames({"codec", "clip"})
+    ->ArgsProduct({{0, 1}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
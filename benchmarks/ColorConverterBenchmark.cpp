@@ -0,0 +1,130 @@
+#include "video/ColorConverter.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+using Format = ColorConverter::Format;
+using Kernel = ColorConverter::Kernel;
+
+AVPixelFormat ToPixelFormat(Format format) {
+    switch (format) {
+        case Format::NV12: return AV_PIX_FMT_NV12;
+        case Format::YUV420P: return AV_PIX_FMT_YUV420P;
+        default: return AV_PIX_FMT_P010LE;
+    }
+}
+
+/**
+ * Decoder-sized frame of noise plus a BGRA destination, shared by the runs below
+ */
+struct ConversionBuffers {
+    AVFrame* frame = nullptr;
+    std::vector<uint8_t> output;
+    int pitch = 0;
+
+    ConversionBuffers(Format format, int width, int height) {
+        frame = av_frame_alloc();
+        frame->format = ToPixelFormat(format);
+        frame->width = width;
+        frame->height = height;
+        av_frame_get_buffer(frame, 0);
+
+        std::mt19937 random(1);
+        for (int p = 0; p < 3 && frame->buf[p]; p++) {
+            for (size_t i = 0; i < frame->buf[p]->size; i++) {
+                frame->buf[p]->data[i] = static_cast<uint8_t>(random());
+            }
+        }
+
+        pitch = width * 4;
+        output.resize(static_cast<size_t>(pitch) * height);
+    }
+
+    ~ConversionBuffers() {
+        av_frame_free(&frame);
+    }
+};
+
+// Arguments: format, kernel, height (16:9)
+void BM_ColorConverter(benchmark::State& state) {
+    Format format = static_cast<Format>(state.range(0));
+    Kernel kernel = static_cast<Kernel>(state.range(1));
+    int height = static_cast<int>(state.range(2));
+    int width = height * 16 / 9;
+    if (!ColorConverter::IsSupported(kernel)) {
+        state.SkipWithError("Kernel not supported by this CPU");
+        return;
+    }
+
+    ConversionBuffers buffers(format, width, height);
+    state.SetLabel(ColorConverter::GetKernelName(kernel));
+    for (auto _ : state) {
+        ColorConverter::Convert(kernel, format, buffers.frame->data, buffers.frame->linesize, width, height,
+                                buffers.output.data(), buffers.pitch, ColorConverter::Matrix::BT709, false);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(width) * height);
+}
+
+// Same conversion through swscale, set up as VideoDecoder sets it up for scaled output
+void BM_Swscale(benchmark::State& state) {
+    Format format = static_cast<Format>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    int width = height * 16 / 9;
+
+    ConversionBuffers buffers(format, width, height);
+    SwsContext* context = sws_getContext(width, height, ToPixelFormat(format), width, height, AV_PIX_FMT_BGRA,
+                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!context) {
+        state.SkipWithError("Failed to create swscale context");
+        return;
+    }
+    sws_setColorspaceDetails(context, sws_getCoefficients(SWS_CS_ITU709), 0,
+                             sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+
+    uint8_t* dst[4] = {buffers.output.data(), nullptr, nullptr, nullptr};
+    int dstStride[4] = {buffers.pitch, 0, 0, 0};
+    state.SetLabel("swscale");
+    for (auto _ : state) {
+        sws_scale(context, buffers.frame->data, buffers.frame->linesize, 0, height, dst, dstStride);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(width) * height);
+    sws_freeContext(context);
+}
+
+void KernelArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"format", "kernel", "height"});
+    for (Format format : {Format::NV12, Format::YUV420P, Format::P010}) {
+        for (Kernel kernel : {Kernel::Scalar, Kernel::SSE41, Kernel::AVX2, Kernel::AVX512}) {
+            for (int height : {1080, 2160}) {
+                benchmark->Args({static_cast<int64_t>(format), static_cast<int64_t>(kernel), height});
+            }
+        }
+    }
+}
+
+void SwscaleArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"format", "height"});
+    for (Format format : {Format::NV12, Format::YUV420P, Format::P010}) {
+        for (int height : {1080, 2160}) {
+            benchmark->Args({static_cast<int64_t>(format), height});
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConverter)->Apply(KernelArguments)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Swscale)->Apply(SwscaleArguments)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
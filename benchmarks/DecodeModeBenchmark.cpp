@@ -0,0 +1,68 @@
+#include "support/DecoderPlayback.h"
+#include "support/TestMedia.h"
+#include "video/VideoDecoder.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 4;
+
+const char* ENCODERS[] = {"mpeg4", "libx264"};
+const DecodeMode MODES[] = {DecodeMode::Normal, DecodeMode::LowPower, DecodeMode::KeyframesOnly};
+
+/**
+ * Arguments: codec (0=MPEG-4, 1=H.264), decode mode (0=normal, 1=low power,
+ * 2=keyframes only)
+ * Plays a 1080p clip in real time for one loop after warming up and reports
+ * the process CPU time per displayed frame and per second of playback
+ */
+void BM_DecodeMode(benchmark::State& state) {
+    const char* encoder = ENCODERS[state.range(0)];
+    DecodeMode mode = MODES[state.range(1)];
+    if (!HasEncoder(encoder)) {
+        state.SkipWithError((std::string(encoder) + " encoder not available").c_str());
+        return;
+    }
+
+    std::wstring path = GetBenchmarkClip(std::string("mode_") + encoder + ".mp4", 1920, 1080, CLIP_SECONDS, 30,
+                                         encoder);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    double cpuTime = 0.0;
+    int frames = 0;
+    for (auto _ : state) {
+        VideoDecoder decoder;
+        decoder.SetDecodeMode(mode);
+        if (!decoder.Initialize(path, nullptr) || !decoder.DecodeNextFrame() || !decoder.StartDecodeThread()) {
+            state.SkipWithError("Failed to start decoder");
+            break;
+        }
+
+        PlayRealTime(decoder, 1.0);
+        PlaybackStats stats = PlayRealTime(decoder, CLIP_SECONDS);
+        cpuTime += stats.cpuTime;
+        frames += stats.framesShown;
+    }
+
+    if (frames > 0) {
+        state.counters["cpu_ms_per_frame"] = cpuTime * 1000.0 / frames;
+    }
+    state.counters["cpu_ms_per_s"] =
+        benchmark::Counter(cpuTime * 1000.0 / CLIP_SECONDS, benchmark::Counter::kAvgIterations);
+    state.counters["frames_shown"] = benchmark::Counter(frames, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_DecodeMode)
+    ->ArgNames({"codec", "mode"})
+    ->ArgsProduct({{0, 1}, {0, 1, 2}})
+    ->Iterations(3)
+    ->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,107 @@
+#include "video/ThreadingPolicy.h"
+#include "support/BenchmarkClips.h"
+#include "support/TestMedia.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_WIDTH = 1920;
+constexpr int CLIP_HEIGHT = 1080;
+constexpr int CLIP_FRAMES = 60;
+
+struct TestCodec {
+    const char* name;
+    const char* encoder;
+    const char* extension;
+};
+
+const TestCodec CODECS[] = {
+    {"H.264", "libx264", ".mp4"},
+    {"HEVC", "libx265", ".mp4"},
+    {"VP9", "libvpx-vp9", ".webm"},
+};
+
+const int THREAD_TYPES[] = {FF_THREAD_FRAME, FF_THREAD_SLICE};
+
+/**
+ * Arguments: codec (0=H.264, 1=HEVC, 2=VP9), decoder threads (0 = what
+ * ThreadingPolicy picks for a single stream on AC power), threading type
+ * (0=frame, 1=slice; ignored for the policy's choice)
+ * Decodes a generated 1080p clip end to end in software; frames_per_s is
+ * the decode throughput
+ */
+void BM_DecodeThreads(benchmark::State& state) {
+    const TestCodec& codec = CODECS[state.range(0)];
+    int threads = static_cast<int>(state.range(1));
+    int threadType = THREAD_TYPES[state.range(2)];
+    if (!HasEncoder(codec.encoder)) {
+        state.SkipWithError((std::string(codec.encoder) + " encoder not available").c_str());
+        return;
+    }
+
+    ClipSpec spec;
+    spec.width = CLIP_WIDTH;
+    spec.height = CLIP_HEIGHT;
+    spec.frameCount = CLIP_FRAMES;
+    spec.codec = codec.encoder;
+    std::string path = GetBenchmarkClipPath(std::string("threads_") + codec.encoder + codec.extension, spec);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    if (threads == 0) {
+        ClipReader probe;
+        if (!probe.Open(path)) {
+            state.SkipWithError("Failed to open clip");
+            return;
+        }
+        ThreadingPolicy::Choice choice = ThreadingPolicy::Choose(probe.GetCodec(), CLIP_WIDTH, CLIP_HEIGHT, 1, false);
+        threads = choice.threadCount;
+        threadType = choice.threadType;
+        state.SetLabel(std::string("policy: ") + std::to_string(threads) + " " +
+                       ThreadingPolicy::GetTypeName(threadType));
+    }
+
+    AVFrame* frame = av_frame_alloc();
+    int64_t frames = 0;
+    for (auto _ : state) {
+        ClipReader reader;
+        if (!reader.Open(path, threads, threadType)) {
+            state.SkipWithError("Failed to open clip");
+            break;
+        }
+        while (reader.ReadFrame(frame)) {
+            av_frame_unref(frame);
+            frames++;
+        }
+    }
+    av_frame_free(&frame);
+
+    state.counters["frames_per_s"] = benchmark::Counter(static_cast<double>(frames), benchmark::Counter::kIsRate);
+}
+
+void ThreadArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"codec", "threads", "type"});
+    for (int64_t codec = 0; codec < 3; codec++) {
+        benchmark->Args({codec, 0, 0});
+        for (int64_t threads : {1, 2, 4, 8, 16}) {
+            for (int64_t type = 0; type < 2; type++) {
+                benchmark->Args({codec, threads, type});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_DecodeThreads)->Apply(ThreadArguments)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
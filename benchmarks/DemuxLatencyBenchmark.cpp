@@ -0,0 +1,107 @@
+#include "support/DecoderPlayback.h"
+#include "video/MappedFileInput.h"
+#include "video/PresentationClock.h"
+
+#include <Windows.h>
+#include <timeapi.h>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 6;
+
+// Reads slower than this hold up the decode thread noticeably (seconds)
+constexpr double STALL_THRESHOLD = 0.002;
+
+/**
+ * Arguments: simulated storage latency per 64 KB block (ms), read-ahead on/off
+ * Demuxes a 1080p clip through MappedFileInput at playback speed, with every
+ * block of the file cold on slow storage, and reports how long the demuxer
+ * waited in av_read_frame
+ */
+void BM_DemuxLatency(benchmark::State& state) {
+    double blockLatency = static_cast<double>(state.range(0)) / 1000.0;
+    bool readAhead = state.range(1) != 0;
+    std::wstring path = GetBenchmarkClip("demux_1080.mp4", 1920, 1080, CLIP_SECONDS, 30);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+    std::string utf8Path = std::filesystem::path(path).string();
+
+    // Sleeps as short as the pacing needs
+    timeBeginPeriod(1);
+    double worstRead = 0.0;
+    double totalRead = 0.0;
+    int64_t reads = 0;
+    int64_t stalls = 0;
+    for (auto _ : state) {
+        MappedFileInput input;
+        input.SetReadAhead(readAhead);
+        input.SimulateSlowStorage(blockLatency);
+        AVFormatContext* formatContext = avformat_alloc_context();
+        if (!input.Open(path, 0) || !formatContext) {
+            avformat_free_context(formatContext);
+            state.SkipWithError("Failed to map clip");
+            break;
+        }
+        formatContext->pb = input.GetContext();
+        formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        if (avformat_open_input(&formatContext, utf8Path.c_str(), nullptr, nullptr) < 0) {
+            state.SkipWithError("Failed to open clip");
+            break;
+        }
+
+        // Ask for each packet when playback would, as the decode thread does
+        AVPacket* packet = av_packet_alloc();
+        double startTime = PresentationClock::Now();
+        while (true) {
+            double readStart = PresentationClock::Now();
+            if (av_read_frame(formatContext, packet) < 0) {
+                break;
+            }
+            double readTime = PresentationClock::Now() - readStart;
+            worstRead = std::max(worstRead, readTime);
+            totalRead += readTime;
+            reads++;
+            stalls += (readTime > STALL_THRESHOLD) ? 1 : 0;
+
+            AVStream* stream = formatContext->streams[packet->stream_index];
+            double packetTime = (packet->dts != AV_NOPTS_VALUE) ? packet->dts * av_q2d(stream->time_base) : 0.0;
+            av_packet_unref(packet);
+
+            double wait = startTime + packetTime - PresentationClock::Now();
+            if (wait > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+            }
+        }
+        av_packet_free(&packet);
+        avformat_close_input(&formatContext);
+    }
+    timeEndPeriod(1);
+
+    state.counters["worst_read_ms"] = worstRead * 1000.0;
+    if (reads > 0) {
+        state.counters["mean_read_ms"] = totalRead * 1000.0 / reads;
+    }
+    state.counters["stalls"] = benchmark::Counter(static_cast<double>(stalls), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_DemuxLatency)
+    ->ArgNames({"block_latency_ms", "read_ahead"})
+    ->ArgsProduct({{0, 5, 20}, {0, 1}})
+    ->Iterations(2)
+    ->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,59 @@
+#include "support/DecoderPlayback.h"
+#include "video/ProbeCache.h"
+#include "video/VideoDecoder.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace PixelMotion {
+namespace {
+
+// Containers that probe differently: sample tables, cues, an index chunk and none
+const char* CONTAINERS[] = {".mp4", ".mkv", ".avi", ".ts"};
+
+/**
+ * Arguments: container of a generated 1080p clip, probe cache warm/cold
+ * Times opening the file and decoding its first frame, as a wallpaper does
+ * at startup; a cold run probes the file with avformat_find_stream_info
+ */
+void BM_TimeToFirstFrame(benchmark::State& state) {
+    const char* container = CONTAINERS[state.range(0)];
+    bool warm = state.range(1) != 0;
+    std::wstring path = GetBenchmarkClip(std::string("first_frame") + container, 1920, 1080, 4, 30);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    // A warm cache is filled by any earlier open of the unchanged file
+    if (warm) {
+        VideoDecoder decoder;
+        decoder.Initialize(path, nullptr);
+    }
+
+    for (auto _ : state) {
+        if (!warm) {
+            ProbeCache::Invalidate(path);
+        }
+
+        double startTime = PresentationClock::Now();
+        VideoDecoder decoder;
+        if (!decoder.Initialize(path, nullptr) || !decoder.DecodeNextFrame()) {
+            state.SkipWithError("Failed to decode first frame");
+            break;
+        }
+        state.SetIterationTime(PresentationClock::Now() - startTime);
+    }
+
+    state.SetLabel(std::string(container + 1) + (warm ? ", probe cached" : ", probed"));
+}
+
+BENCHMARK(BM_TimeToFirstFrame)
+    ->ArgNames({"container", "warm"})
+    ->ArgsProduct({{0, 1, 2, 3}, {0, 1}})
+    ->UseManualTime()
+    ->Iterations(20)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
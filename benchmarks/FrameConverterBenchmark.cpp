@@ -0,0 +1,140 @@
+#include "video/ConversionPool.h"
+#include "video/FrameConverter.h"
+#include "video/ThreadingPolicy.h"
+#include "support/TestMedia.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int SOURCE_WIDTH = 3840;
+constexpr int SOURCE_HEIGHT = 2160;
+
+/**
+ * Arguments: crop width and height requested from a 4K NV12 frame, output size in percent of the crop
+ * Reports the source bytes read and BGRA bytes written per frame, so a crop
+ * shows up as less memory traffic as well as less time
+ */
+void BM_FrameConverterCrop(benchmark::State& state) {
+    int cropWidth = static_cast<int>(state.range(0));
+    int cropHeight = static_cast<int>(state.range(1));
+    int percent = static_cast<int>(state.range(2));
+
+    AVFrame* frame = MakeNoiseFrame(AV_PIX_FMT_NV12, SOURCE_WIDTH, SOURCE_HEIGHT, 1);
+    if (!frame) {
+        state.SkipWithError("Failed to allocate frame");
+        return;
+    }
+    frame->colorspace = AVCOL_SPC_BT709;
+
+    const uint8_t* planes[4];
+    FrameConverter::GetCroppedPlanes(frame, cropWidth, cropHeight, planes);
+    int outputWidth = std::max(1, cropWidth * percent / 100);
+    int outputHeight = std::max(1, cropHeight * percent / 100);
+    int pitch = outputWidth * 4;
+    std::vector<uint8_t> output(static_cast<size_t>(pitch) * outputHeight);
+
+    FrameConverter converter;
+    for (auto _ : state) {
+        if (!converter.Convert(frame, planes, cropWidth, cropHeight, output.data(), pitch,
+                               outputWidth, outputHeight, 1)) {
+            state.SkipWithError("Conversion failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    int64_t readBytes = av_image_get_buffer_size(AV_PIX_FMT_NV12, cropWidth, cropHeight, 1);
+    int64_t writtenBytes = static_cast<int64_t>(pitch) * outputHeight;
+    state.counters["read_MB"] = static_cast<double>(readBytes) / 1.0e6;
+    state.counters["written_MB"] = static_cast<double>(writtenBytes) / 1.0e6;
+    state.SetBytesProcessed(state.iterations() * (readBytes + writtenBytes));
+    av_frame_free(&frame);
+}
+
+// Whole frame, then what Fill leaves of it on a 21:9 and on a portrait 9:16 monitor
+void CropArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"crop_w", "crop_h", "scale_pct"});
+    const int crops[][2] = {
+        {SOURCE_WIDTH, SOURCE_HEIGHT},
+        {SOURCE_WIDTH, SOURCE_WIDTH * 9 / 21},
+        {SOURCE_HEIGHT * 9 / 16, SOURCE_HEIGHT},
+    };
+    for (const auto& crop : crops) {
+        for (int percent : {100, 50}) {
+            benchmark->Args({crop[0], crop[1], percent});
+        }
+    }
+}
+
+/**
+ * Arguments: output height (16:9), bands, scaled
+ * Unscaled frames go through the SIMD converter; scaled ones come from the
+ * next size up (1440p, 4K, 8K) through swscale. Each band runs on its own
+ * pool thread; policy_bands is what ThreadingPolicy picks for the size
+ */
+void BM_FrameConverterThreads(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    int bands = static_cast<int>(state.range(1));
+    bool scaled = state.range(2) != 0;
+    int width = height * 16 / 9;
+    int threads = ConversionPool::GetInstance().GetThreadCount();
+    if (bands > threads) {
+        state.SkipWithError("More bands than conversion threads");
+        return;
+    }
+
+    int sourceHeight = height;
+    if (scaled) {
+        sourceHeight = (height == 1080) ? 1440 : (height == 1440) ? 2160 : 4320;
+    }
+    int sourceWidth = sourceHeight * 16 / 9;
+    AVFrame* frame = MakeNoiseFrame(AV_PIX_FMT_NV12, sourceWidth, sourceHeight, 1);
+    if (!frame) {
+        state.SkipWithError("Failed to allocate frame");
+        return;
+    }
+    frame->colorspace = AVCOL_SPC_BT709;
+
+    int pitch = width * 4;
+    std::vector<uint8_t> output(static_cast<size_t>(pitch) * height);
+    FrameConverter converter;
+    for (auto _ : state) {
+        if (!converter.Convert(frame, frame->data, sourceWidth, sourceHeight, output.data(), pitch,
+                               width, height, bands)) {
+            state.SkipWithError("Conversion failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["policy_bands"] = ThreadingPolicy::ChooseConversionBands(width, height, threads, false);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(width) * height);
+    av_frame_free(&frame);
+}
+
+void ThreadArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"height", "bands", "scaled"});
+    for (int scaled : {0, 1}) {
+        for (int height : {1080, 1440, 2160}) {
+            for (int bands : {1, 2, 3, 4, 6, 8, 12, 16}) {
+                benchmark->Args({height, bands, scaled});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_FrameConverterCrop)->Apply(CropArguments)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FrameConverterThreads)->Apply(ThreadArguments)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,66 @@
+#include "support/DecoderPlayback.h"
+#include "video/VideoDecoder.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 2;
+constexpr int MEASURED_LOOPS = 2;
+constexpr size_t CACHE_BUDGET = 512 * 1024 * 1024;
+
+/**
+ * Arguments: height (16:9), loop cache on/off
+ * Plays one loop to warm up (the pass that fills the cache), then measures
+ * the process CPU time per displayed frame over the following loops and
+ * the memory the decoder holds on to
+ */
+void BM_LoopCache(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    int width = height * 16 / 9;
+    std::wstring path = GetBenchmarkClip("cache_" + std::to_string(height) + ".mp4", width, height,
+                                         CLIP_SECONDS, 30);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    DecoderOptions options;
+    options.loopCacheBudget = state.range(1) ? CACHE_BUDGET : 0;
+
+    double cpuTime = 0.0;
+    int frames = 0;
+    double committedBytes = 0.0;
+    for (auto _ : state) {
+        size_t startBytes = GetPrivateBytes();
+        VideoDecoder decoder;
+        if (!decoder.Initialize(path, nullptr, options) || !decoder.DecodeNextFrame() ||
+            !decoder.StartDecodeThread()) {
+            state.SkipWithError("Failed to start decoder");
+            break;
+        }
+
+        PlayRealTime(decoder, CLIP_SECONDS + 0.5);
+        PlaybackStats stats = PlayRealTime(decoder, CLIP_SECONDS * MEASURED_LOOPS);
+        cpuTime += stats.cpuTime;
+        frames += stats.framesShown;
+        committedBytes += static_cast<double>(GetPrivateBytes()) - static_cast<double>(startBytes);
+    }
+
+    if (frames > 0) {
+        state.counters["cpu_ms_per_frame"] = cpuTime * 1000.0 / frames;
+    }
+    state.counters["committed_MB"] =
+        benchmark::Counter(committedBytes / (1024.0 * 1024.0), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_LoopCache)
+    ->ArgNames({"height", "cache"})
+    ->ArgsProduct({{720, 1080}, {0, 1}})
+    ->Iterations(3)
+    ->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,63 @@
+#include "support/DecoderPlayback.h"
+#include "video/VideoDecoder.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <string>
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 2;
+constexpr int LOOPS = 3;
+
+/**
+ * Arguments: height (16:9), pre-rolled frames (0 = seek and refill the decoder at every loop)
+ * Plays a short clip for a few loops in real time and reports the longest
+ * time between two frames across a loop boundary, next to the longest
+ * anywhere else and the frames shown late
+ */
+void BM_LoopSeam(benchmark::State& state) {
+    int height = static_cast<int>(state.range(0));
+    int width = height * 16 / 9;
+    std::wstring path = GetBenchmarkClip("seam_" + std::to_string(height) + ".mp4", width, height,
+                                         CLIP_SECONDS, 30);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    DecoderOptions options;
+    options.loopPrerollFrames = static_cast<size_t>(state.range(1));
+    options.loopCacheBudget = 0; // Seek back at every loop, hidden by the pre-roll alone
+
+    PlaybackStats worst;
+    for (auto _ : state) {
+        VideoDecoder decoder;
+        if (!decoder.Initialize(path, nullptr, options) || !decoder.DecodeNextFrame() ||
+            !decoder.StartDecodeThread()) {
+            state.SkipWithError("Failed to start decoder");
+            break;
+        }
+
+        PlaybackStats stats = PlayRealTime(decoder, CLIP_SECONDS * LOOPS + 0.5);
+        worst.worstLoopGap = std::max(worst.worstLoopGap, stats.worstLoopGap);
+        worst.worstGap = std::max(worst.worstGap, stats.worstGap);
+        worst.lateFrames += stats.lateFrames;
+        worst.loops += stats.loops;
+    }
+
+    state.counters["loop_gap_ms"] = worst.worstLoopGap * 1000.0;
+    state.counters["worst_gap_ms"] = worst.worstGap * 1000.0;
+    state.counters["late_frames"] = benchmark::Counter(worst.lateFrames, benchmark::Counter::kAvgIterations);
+    state.counters["loops"] = benchmark::Counter(worst.loops, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_LoopSeam)
+    ->ArgNames({"height", "preroll"})
+    ->ArgsProduct({{1080, 2160}, {0, 6}})
+    ->Iterations(3)
+    ->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace PixelMotion
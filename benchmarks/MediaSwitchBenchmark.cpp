@@ -0,0 +1,161 @@
+#include "support/DecoderPlayback.h"
+#include "video/MediaLoader.h"
+#include "video/PresentationClock.h"
+#include "video/VideoDecoder.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+using Microsoft::WRL::ComPtr;
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 4;
+constexpr int MONITOR_WIDTH = 1920;
+constexpr int MONITOR_HEIGHT = 1080;
+
+// Playback before the switch and after the new video is on screen
+constexpr double SETTLE_SECONDS = 1.0;
+
+// Longest sleep between ticks, as in PlayRealTime
+constexpr double MAX_TICK_INTERVAL = 0.005;
+
+/**
+ * Main-loop work of one wallpaper window showing a video: advance playback
+ * and convert each new frame into the window's texture, as
+ * WallpaperWindow::Update and BindContent do
+ * @return time until the next tick is due
+ */
+double TickWindow(VideoDecoder& decoder, uint64_t& serial) {
+    double now = PresentationClock::Now();
+    decoder.UpdatePlayback(now);
+    if (decoder.GetFrameSerial() != serial) {
+        serial = decoder.GetFrameSerial();
+        decoder.GetFrameTexture(MONITOR_WIDTH, MONITOR_HEIGHT, 0);
+    }
+    return decoder.GetTimeToNextFrame(now);
+}
+
+/**
+ * Arguments: background (0 = load the next video and release the old one on
+ * the main thread, as switching did before MediaLoader; 1 = load and release
+ * on MediaLoader's worker while the current video keeps playing)
+ * Plays a 1080p video on a WARP device, switches to another one and reports
+ * the longest main-loop tick while switching next to the longest while
+ * playing normally; a tick is the work between two sleeps
+ */
+void BM_MediaSwitchTick(benchmark::State& state) {
+    bool background = state.range(0) != 0;
+    ComPtr<ID3D11Device> device;
+    if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                                 &device, nullptr, nullptr))) {
+        state.SkipWithError("WARP device not available");
+        return;
+    }
+
+    std::wstring paths[] = {
+        GetBenchmarkClip("switch_a_1080.mp4", 1920, 1080, CLIP_SECONDS, 30),
+        GetBenchmarkClip("switch_b_1080.mp4", 1920, 1080, CLIP_SECONDS, 30),
+    };
+    if (paths[0].empty() || paths[1].empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    MediaLoader::Request request;
+    request.device = device.Get();
+    request.targetWidth = MONITOR_WIDTH;
+    request.targetHeight = MONITOR_HEIGHT;
+
+    MediaLoader& loader = MediaLoader::GetInstance();
+    double longestPlayingTick = 0.0;
+    double longestSwitchTick = 0.0;
+    double switchTime = 0.0;
+    for (auto _ : state) {
+        request.path = paths[0];
+        LoadedMedia current = MediaLoader::Load(request);
+        if (!current.decoder) {
+            state.SkipWithError("Failed to open video");
+            break;
+        }
+
+        uint64_t serial = 0;
+        double wait = 0.0;
+        double startTime = PresentationClock::Now();
+        while (PresentationClock::Now() - startTime < SETTLE_SECONDS) {
+            double tickStart = PresentationClock::Now();
+            wait = TickWindow(*current.decoder, serial);
+            longestPlayingTick = std::max(longestPlayingTick, PresentationClock::Now() - tickStart);
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::clamp(wait, 0.0, MAX_TICK_INTERVAL)));
+        }
+
+        // Switch: the tick that starts it, every tick until the new video is
+        // current, and the tick that swaps it in all count
+        request.path = paths[1];
+        double switchStart = PresentationClock::Now();
+        if (background) {
+            uint64_t ticket = loader.Submit(request);
+            LoadedMedia next;
+            while (true) {
+                double tickStart = PresentationClock::Now();
+                bool loaded = loader.Poll(ticket, next);
+                if (loaded) {
+                    loader.Release(std::move(current));
+                    current = std::move(next);
+                    serial = 0;
+                }
+                wait = current.decoder ? TickWindow(*current.decoder, serial) : 0.0;
+                longestSwitchTick = std::max(longestSwitchTick, PresentationClock::Now() - tickStart);
+                if (loaded) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::duration<double>(std::clamp(wait, 0.0, MAX_TICK_INTERVAL)));
+            }
+        } else {
+            double tickStart = PresentationClock::Now();
+            LoadedMedia next = MediaLoader::Load(request);
+            current = std::move(next); // Joins the old decoder's thread here
+            serial = 0;
+            if (current.decoder) {
+                TickWindow(*current.decoder, serial);
+            }
+            longestSwitchTick = std::max(longestSwitchTick, PresentationClock::Now() - tickStart);
+        }
+        switchTime += PresentationClock::Now() - switchStart;
+        if (!current.decoder) {
+            state.SkipWithError("Failed to open next video");
+            break;
+        }
+
+        startTime = PresentationClock::Now();
+        while (PresentationClock::Now() - startTime < SETTLE_SECONDS) {
+            double tickStart = PresentationClock::Now();
+            wait = TickWindow(*current.decoder, serial);
+            longestPlayingTick = std::max(longestPlayingTick, PresentationClock::Now() - tickStart);
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::clamp(wait, 0.0, MAX_TICK_INTERVAL)));
+        }
+        loader.Release(std::move(current));
+    }
+
+    state.counters["longest_switch_tick_ms"] = longestSwitchTick * 1000.0;
+    state.counters["longest_playing_tick_ms"] = longestPlayingTick * 1000.0;
+    state.counters["switch_ms"] = benchmark::Counter(switchTime * 1000.0, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_MediaSwitchTick)
+    ->ArgNames({"background"})
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(3)
+    ->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,140 @@
+#include "support/DecoderPlayback.h"
+#include "video/FrameConverter.h"
+#include "video/MediaSourceRegistry.h"
+#include "video/VideoDecoder.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 4;
+constexpr int MONITOR_WIDTH = 1920;
+constexpr int MONITOR_HEIGHT = 1080;
+
+// Longest sleep between ticks, as in PlayRealTime
+constexpr double MAX_TICK_INTERVAL = 0.005;
+
+/**
+ * One wallpaper window: its own converter and output, like the texture
+ * each window scales into
+ */
+struct SimulatedMonitor {
+    std::shared_ptr<VideoDecoder> decoder;
+    FrameConverter converter;
+    std::vector<uint8_t> output = std::vector<uint8_t>(static_cast<size_t>(MONITOR_WIDTH) * MONITOR_HEIGHT * 4);
+    uint64_t serial = 0;
+    int framesShown = 0;
+};
+
+std::shared_ptr<VideoDecoder> OpenPrivateDecoder(const std::wstring& path) {
+    auto decoder = std::make_shared<VideoDecoder>();
+    if (!decoder->Initialize(path, nullptr) || !decoder->DecodeNextFrame() || !decoder->StartDecodeThread()) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+/**
+ * Arguments: monitors showing the same clip, shared decoder on/off
+ * Shared monitors get their decoder from MediaSourceRegistry, as
+ * WallpaperWindow does; otherwise each opens its own. Every monitor ticks
+ * UpdatePlayback and converts each new frame for a 1080p screen. Reports
+ * the process CPU time per second of playback, the decoders running and
+ * the memory committed while playing
+ */
+void BM_MonitorSharing(benchmark::State& state) {
+    int monitorCount = static_cast<int>(state.range(0));
+    bool shared = state.range(1) != 0;
+    std::wstring path = GetBenchmarkClip("monitors_1080.mp4", 1920, 1080, CLIP_SECONDS, 30);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    double cpuTime = 0.0;
+    double committedBytes = 0.0;
+    int framesShown = 0;
+    size_t decoders = 0;
+    for (auto _ : state) {
+        size_t startBytes = GetPrivateBytes();
+        std::vector<std::unique_ptr<SimulatedMonitor>> monitors;
+        for (int i = 0; i < monitorCount; i++) {
+            auto monitor = std::make_unique<SimulatedMonitor>();
+            monitor->decoder = shared ? MediaSourceRegistry::GetInstance().Acquire(path, nullptr, DecoderOptions())
+                                      : OpenPrivateDecoder(path);
+            if (!monitor->decoder) {
+                break;
+            }
+            monitors.push_back(std::move(monitor));
+        }
+        if (static_cast<int>(monitors.size()) != monitorCount) {
+            state.SkipWithError("Failed to open decoder");
+            break;
+        }
+
+        std::vector<const VideoDecoder*> distinct;
+        for (const auto& monitor : monitors) {
+            distinct.push_back(monitor->decoder.get());
+        }
+        std::sort(distinct.begin(), distinct.end());
+        decoders = std::unique(distinct.begin(), distinct.end()) - distinct.begin();
+
+        double cpuStartTime = GetProcessCpuTime();
+        double startTime = PresentationClock::Now();
+        for (double now = startTime; now - startTime < CLIP_SECONDS; now = PresentationClock::Now()) {
+            double wait = MAX_TICK_INTERVAL;
+            for (auto& monitor : monitors) {
+                VideoDecoder& decoder = *monitor->decoder;
+                decoder.UpdatePlayback(now);
+                if (decoder.GetFrameSerial() != monitor->serial) {
+                    monitor->serial = decoder.GetFrameSerial();
+                    monitor->framesShown++;
+
+                    const AVFrame* frame = decoder.GetCurrentFrame();
+                    int cropWidth = frame->width;
+                    int cropHeight = frame->height;
+                    const uint8_t* planes[4];
+                    FrameConverter::GetCroppedPlanes(frame, cropWidth, cropHeight, planes);
+                    monitor->converter.Convert(frame, planes, cropWidth, cropHeight, monitor->output.data(),
+                                               MONITOR_WIDTH * 4, MONITOR_WIDTH, MONITOR_HEIGHT, 1);
+                }
+                wait = std::min(wait, decoder.GetTimeToNextFrame(now));
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::max(wait, 0.0)));
+        }
+
+        cpuTime += GetProcessCpuTime() - cpuStartTime;
+        committedBytes += static_cast<double>(GetPrivateBytes()) - static_cast<double>(startBytes);
+        for (const auto& monitor : monitors) {
+            framesShown += monitor->framesShown;
+        }
+    }
+
+    state.counters["cpu_ms_per_s"] =
+        benchmark::Counter(cpuTime * 1000.0 / CLIP_SECONDS, benchmark::Counter::kAvgIterations);
+    state.counters["committed_MB"] =
+        benchmark::Counter(committedBytes / (1024.0 * 1024.0), benchmark::Counter::kAvgIterations);
+    state.counters["frames_shown"] = benchmark::Counter(framesShown, benchmark::Counter::kAvgIterations);
+    state.counters["decoders"] = static_cast<double>(decoders);
+}
+
+BENCHMARK(BM_MonitorSharing)
+    ->ArgNames({"monitors", "shared"})
+    ->ArgsProduct({{1, 2, 4, 8}, {0, 1}})
+    ->Iterations(2)
+    ->Unit(benchmark::kSecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,100 @@
+#include "video/FrameConverter.h"
+#include "video/OutputLayout.h"
+#include "support/TestMedia.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int SOURCE_WIDTH = 3840;
+constexpr int SOURCE_HEIGHT = 2160;
+
+// 1080p, then monitors whose shape makes Fill, Fit and Stretch differ
+const int MONITORS[][2] = {{1920, 1080}, {2560, 1080}, {1080, 1920}, {1920, 1200}};
+constexpr int64_t MONITOR_COUNT = sizeof(MONITORS) / sizeof(MONITORS[0]);
+
+const char* GetModeName(int scalingMode) {
+    switch (scalingMode) {
+        case 0: return "Fill";
+        case 1: return "Fit";
+        case 2: return "Stretch";
+        default: return "source size";
+    }
+}
+
+/**
+ * Arguments: scaling mode (0=Fill, 1=Fit, 2=Stretch, -1 = whole frame at the
+ * source size, as before the layout), monitor
+ * Converts a 4K frame for the monitor the way GetFrameTexture does (through
+ * OutputRequest, so Stretch keeps each axis' own scale), single
+ * threaded; reports the source bytes read and BGRA bytes produced per frame
+ */
+void BM_MonitorConversion(benchmark::State& state) {
+    int scalingMode = static_cast<int>(state.range(0));
+    const int* monitor = MONITORS[state.range(1)];
+
+    AVFrame* frame = MakeNoiseFrame(AV_PIX_FMT_NV12, SOURCE_WIDTH, SOURCE_HEIGHT, 1);
+    if (!frame) {
+        state.SkipWithError("Failed to allocate frame");
+        return;
+    }
+    frame->colorspace = AVCOL_SPC_BT709;
+
+    OutputLayout layout = (scalingMode < 0)
+        ? OutputLayout::Compute(SOURCE_WIDTH, SOURCE_HEIGHT, 0, 0, 0, false)
+        : OutputLayout::Compute(SOURCE_WIDTH, SOURCE_HEIGHT, monitor[0], monitor[1], scalingMode, true);
+    OutputRequest request;
+    request.Add(layout);
+    int cropWidth = layout.cropWidth;
+    int cropHeight = layout.cropHeight;
+    int outputWidth = 0;
+    int outputHeight = 0;
+    request.GetOutputSize(cropWidth, cropHeight, &outputWidth, &outputHeight);
+    const uint8_t* planes[4];
+    FrameConverter::GetCroppedPlanes(frame, cropWidth, cropHeight, planes);
+
+    int pitch = outputWidth * 4;
+    std::vector<uint8_t> output(static_cast<size_t>(pitch) * outputHeight);
+    FrameConverter converter;
+    for (auto _ : state) {
+        if (!converter.Convert(frame, planes, cropWidth, cropHeight, output.data(), pitch,
+                               outputWidth, outputHeight, 1)) {
+            state.SkipWithError("Conversion failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    int64_t readBytes = av_image_get_buffer_size(AV_PIX_FMT_NV12, cropWidth, cropHeight, 1);
+    int64_t writtenBytes = static_cast<int64_t>(pitch) * outputHeight;
+    state.SetLabel(std::string(GetModeName(scalingMode)) + " on " + std::to_string(monitor[0]) + "x" +
+                   std::to_string(monitor[1]) + " -> " + std::to_string(outputWidth) + "x" +
+                   std::to_string(outputHeight));
+    state.counters["read_MB"] = static_cast<double>(readBytes) / 1.0e6;
+    state.counters["written_MB"] = static_cast<double>(writtenBytes) / 1.0e6;
+    state.SetBytesProcessed(state.iterations() * (readBytes + writtenBytes));
+    av_frame_free(&frame);
+}
+
+void MonitorArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"mode", "monitor"});
+    for (int64_t monitor = 0; monitor < MONITOR_COUNT; monitor++) {
+        for (int scalingMode : {-1, 0, 1, 2}) {
+            benchmark->Args({scalingMode, monitor});
+        }
+    }
+}
+
+BENCHMARK(BM_MonitorConversion)->Apply(MonitorArguments)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,71 @@
+#include "support/DecoderPlayback.h"
+#include "video/VideoDecoder.h"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_SECONDS = 20;
+
+// Longest wait for the background keyframe scan of an unindexed container
+constexpr double INDEX_SCAN_TIMEOUT = 30.0;
+
+const char* CONTAINERS[] = {".mp4", ".ts"};
+
+/**
+ * Arguments: GOP length in frames, container (0 = MP4 with a sample table,
+ * 1 = MPEG-TS, which has no index and is scanned after opening)
+ * Times SeekExact to random points of a 1080p clip once the keyframe index
+ * is ready; each seek decodes forward from the enclosing keyframe
+ */
+void BM_SeekExact(benchmark::State& state) {
+    int gopSize = static_cast<int>(state.range(0));
+    const char* container = CONTAINERS[state.range(1)];
+    std::wstring path = GetBenchmarkClip("seek_gop" + std::to_string(gopSize) + container, 1920, 1080,
+                                         CLIP_SECONDS, gopSize);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write clip");
+        return;
+    }
+
+    VideoDecoder decoder;
+    if (!decoder.Initialize(path, nullptr) || !decoder.DecodeNextFrame()) {
+        state.SkipWithError("Failed to open clip");
+        return;
+    }
+
+    double scanStart = PresentationClock::Now();
+    while (!decoder.IsKeyframeIndexReady()) {
+        if (PresentationClock::Now() - scanStart > INDEX_SCAN_TIMEOUT) {
+            state.SkipWithError("Keyframe scan did not finish");
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    double scanTime = PresentationClock::Now() - scanStart;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> target(0.0, decoder.GetDuration() - 0.5);
+    for (auto _ : state) {
+        if (!decoder.SeekExact(target(random))) {
+            state.SkipWithError("Seek failed");
+            break;
+        }
+    }
+
+    state.counters["index_wait_ms"] = scanTime * 1000.0;
+}
+
+BENCHMARK(BM_SeekExact)
+    ->ArgNames({"gop", "container"})
+    ->ArgsProduct({{30, 300}, {0, 1}})
+    ->Iterations(20)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,113 @@
+#include "support/BenchmarkClips.h"
+#include "support/DecoderPlayback.h"
+#include "video/MediaLoader.h"
+#include "video/StillImageCache.h"
+#include "video/VideoDecoder.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+namespace PixelMotion {
+namespace {
+
+struct MonitorSize {
+    int width;
+    int height;
+};
+
+// Three monitors of different sizes showing the same wallpaper
+const MonitorSize MONITORS[] = {{3840, 2160}, {2560, 1440}, {1920, 1080}};
+
+/**
+ * Arguments: cached (0 = a decoder per monitor kept open for the
+ * wallpaper's lifetime, as still images were shown before StillImageCache;
+ * 1 = MediaLoader, which converts once per monitor and releases the decoder)
+ * Sets an 8K PNG as the wallpaper of three monitors on a WARP device, whose
+ * textures live in system memory, and reports how much the resident and
+ * committed memory of the process grew
+ */
+void BM_StillImageMemory(benchmark::State& state) {
+    bool cached = state.range(0) != 0;
+    ComPtr<ID3D11Device> device;
+    if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                                 &device, nullptr, nullptr))) {
+        state.SkipWithError("WARP device not available");
+        return;
+    }
+    if (!HasEncoder("png")) {
+        state.SkipWithError("png encoder not available");
+        return;
+    }
+
+    ClipSpec spec;
+    spec.width = 7680;
+    spec.height = 4320;
+    spec.frameCount = 1;
+    spec.codec = "png";
+    std::string path = GetBenchmarkClipPath("still_8k.png", spec);
+    if (path.empty()) {
+        state.SkipWithError("Failed to write image");
+        return;
+    }
+    std::wstring widePath = std::filesystem::path(path).wstring();
+
+    double residentBytes = 0.0;
+    double committedBytes = 0.0;
+    for (auto _ : state) {
+        size_t startResident = GetWorkingSetBytes();
+        size_t startCommitted = GetPrivateBytes();
+
+        std::vector<std::unique_ptr<VideoDecoder>> decoders;
+        std::vector<LoadedMedia> wallpapers;
+        for (const MonitorSize& monitor : MONITORS) {
+            if (cached) {
+                MediaLoader::Request request;
+                request.path = widePath;
+                request.device = device.Get();
+                request.targetWidth = monitor.width;
+                request.targetHeight = monitor.height;
+                wallpapers.push_back(MediaLoader::Load(request));
+                if (!wallpapers.back().image) {
+                    state.SkipWithError("Failed to load image");
+                    break;
+                }
+            } else {
+                auto decoder = std::make_unique<VideoDecoder>();
+                if (!decoder->Initialize(widePath, device.Get()) || !decoder->DecodeNextFrame() ||
+                    !decoder->GetFrameTexture(monitor.width, monitor.height, 0)) {
+                    state.SkipWithError("Failed to decode image");
+                    break;
+                }
+                decoders.push_back(std::move(decoder));
+            }
+        }
+
+        // Once every wallpaper is set, as DesktopManager does
+        StillImageCache::GetInstance().ReleaseSources();
+
+        residentBytes += static_cast<double>(GetWorkingSetBytes()) - static_cast<double>(startResident);
+        committedBytes += static_cast<double>(GetPrivateBytes()) - static_cast<double>(startCommitted);
+    }
+
+    state.counters["resident_MB"] =
+        benchmark::Counter(residentBytes / (1024.0 * 1024.0), benchmark::Counter::kAvgIterations);
+    state.counters["committed_MB"] =
+        benchmark::Counter(committedBytes / (1024.0 * 1024.0), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_StillImageMemory)
+    ->ArgNames({"cached"})
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace PixelMotion
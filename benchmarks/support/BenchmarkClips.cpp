@@ -0,0 +1,47 @@
+#include "BenchmarkClips.h"
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+
+namespace PixelMotion {
+
+/**
+ * Removes the generated clips when the benchmark binary exits
+ */
+class ClipStore {
+public:
+    ~ClipStore() {
+        std::error_code error;
+        for (const auto& clip : m_clips) {
+            std::filesystem::remove(clip.second, error);
+        }
+    }
+
+    std::string Get(const std::string& name, const ClipSpec& spec) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_clips.find(name);
+        if (found != m_clips.end()) {
+            return found->second;
+        }
+
+        std::string path = MakeTempPath(name);
+        if (!WriteClip(path, spec)) {
+            return {};
+        }
+        m_clips[name] = path;
+        return path;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<std::string, std::string> m_clips;
+};
+
+static ClipStore s_clipStore;
+
+std::string GetBenchmarkClipPath(const std::string& name, const ClipSpec& spec) {
+    return s_clipStore.Get(name, spec);
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "support/TestMedia.h"
+
+#include <string>
+
+namespace PixelMotion {
+
+/**
+ * Generated clip that stays on disk for the whole benchmark run
+ * Clips are cached by name, so every argument set shares one encode
+ * @return empty if the clip couldn't be written
+ */
+std::string GetBenchmarkClipPath(const std::string& name, const ClipSpec& spec);
+
+} // namespace PixelMotion
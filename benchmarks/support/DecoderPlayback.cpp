@@ -0,0 +1,113 @@
+#include "DecoderPlayback.h"
+#include "BenchmarkClips.h"
+#include "video/VideoDecoder.h"
+
+#include <Windows.h>
+#include <psapi.h>
+#include <timeapi.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+
+// Longest sleep between ticks; a window wakes at least this often
+constexpr double MAX_TICK_INTERVAL = 0.005;
+
+std::wstring GetBenchmarkClip(const std::string& name, int width, int height, int seconds, int gopSize,
+                              const char* codec) {
+    ClipSpec spec;
+    spec.width = width;
+    spec.height = height;
+    spec.frameCount = seconds * spec.frameRate;
+    spec.gopSize = gopSize;
+    spec.codec = codec;
+    std::string path = GetBenchmarkClipPath(name, spec);
+    return path.empty() ? std::wstring() : std::filesystem::path(path).wstring();
+}
+
+double GetProcessCpuTime() {
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0.0;
+    }
+
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return static_cast<double>(kernel.QuadPart + user.QuadPart) / 1.0e7; // 100ns units
+}
+
+size_t GetPrivateBytes() {
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                              sizeof(counters))) {
+        return 0;
+    }
+    return counters.PrivateUsage;
+}
+
+size_t GetWorkingSetBytes() {
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+}
+
+PlaybackStats PlayRealTime(VideoDecoder& decoder, double seconds) {
+    PlaybackStats stats;
+    double loopDuration = decoder.GetDuration();
+
+    // Sleeps as short as the frame schedule needs
+    timeBeginPeriod(1);
+    double cpuStartTime = GetProcessCpuTime();
+    double startTime = PresentationClock::Now();
+    double lastChange = startTime;
+    uint64_t serial = decoder.GetFrameSerial();
+    int64_t loop = 0;
+
+    for (double now = startTime; now - startTime < seconds; now = PresentationClock::Now()) {
+        decoder.UpdatePlayback(now);
+
+        if (decoder.GetFrameSerial() != serial) {
+            serial = decoder.GetFrameSerial();
+            double gap = now - lastChange;
+            lastChange = now;
+            stats.framesShown++;
+            stats.worstGap = std::max(stats.worstGap, gap);
+
+            // Frame times keep counting across loops
+            const AVFrame* frame = decoder.GetCurrentFrame();
+            if (loopDuration > 0.0 && frame) {
+                double streamTime = static_cast<double>(frame->pts) / AV_TIME_BASE;
+                int64_t frameLoop = static_cast<int64_t>(std::floor(streamTime / loopDuration + 1.0e-3));
+                if (frameLoop != loop) {
+                    loop = frameLoop;
+                    stats.loops++;
+                    stats.worstLoopGap = std::max(stats.worstLoopGap, gap);
+                }
+            }
+        }
+
+        double wait = std::min(decoder.GetTimeToNextFrame(now), MAX_TICK_INTERVAL);
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::max(wait, 0.0)));
+    }
+
+    stats.cpuTime = GetProcessCpuTime() - cpuStartTime;
+    stats.lateFrames = decoder.GetLateFrameCount();
+    timeEndPeriod(1);
+    return stats;
+}
+
+} // namespace PixelMotion
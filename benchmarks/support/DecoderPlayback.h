@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace PixelMotion {
+
+class VideoDecoder;
+
+/**
+ * What a window would have seen while playing a decoder in real time
+ */
+struct PlaybackStats {
+    int framesShown = 0;
+    int loops = 0;             // Loop boundaries crossed
+    int lateFrames = 0;        // VideoDecoder::GetLateFrameCount at the end
+    double worstGap = 0.0;     // Longest time between two new frames (seconds)
+    double worstLoopGap = 0.0; // Same, across a loop boundary only
+    double cpuTime = 0.0;      // Process CPU time over the run (seconds)
+};
+
+/**
+ * Play an initialized decoder with its decode thread running, ticking
+ * UpdatePlayback like WallpaperWindow does, until the time is up
+ */
+PlaybackStats PlayRealTime(VideoDecoder& decoder, double seconds);
+
+/**
+ * CPU time used by this process so far (seconds)
+ */
+double GetProcessCpuTime();
+
+/**
+ * Memory committed by this process (bytes)
+ */
+size_t GetPrivateBytes();
+
+/**
+ * Memory of this process resident in RAM (bytes)
+ */
+size_t GetWorkingSetBytes();
+
+/**
+ * GetBenchmarkClipPath for a clip of the given size and length
+ */
+std::wstring GetBenchmarkClip(const std::string& name, int width, int height, int seconds, int gopSize,
+                              const char* codec = "mpeg4");
+
+} // namespace PixelMotion
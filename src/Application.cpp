@@ -9,6 +9,7 @@
 
 #include <Windows.h>
 #include <objbase.h>
+#include <filesystem>
 
 namespace PixelMotion {
 
@@ -191,10 +192,22 @@ void Application::Update() {
 
     // Update desktop manager (handle monitor changes)
     bool isPaused = m_resourceManager ? m_resourceManager->IsPaused() : false;
+
+    if (m_desktopManager && m_resourceManager) {
+        m_desktopManager->SetPowerState(m_resourceManager->IsOnBattery(), m_resourceManager->IsLowBattery());
+    }
     
     if (m_desktopManager && !isPaused) {
         m_desktopManager->Update();
     }
+
+    // The old wallpaper stays up, so tell the user why the new one never appeared
+    if (m_desktopManager && m_trayIcon) {
+        for (const auto& path : m_desktopManager->TakeFailedWallpapers()) {
+            m_trayIcon->ShowNotification(L"Pixel Motion",
+                                         L"Could not load " + std::filesystem::path(path).filename().wstring());
+        }
+    }
 }
 
 void Application::Render() {
@@ -1,5 +1,6 @@
 #include "Configuration.h"
 #include "Logger.h"
+#include "TextEncoding.h"
 
 #include <Windows.h>
 #include <shlobj.h>
@@ -60,6 +61,18 @@ bool Configuration::Load() {
         if (j.contains("batteryThreshold")) {
             m_settings.batteryThreshold = j["batteryThreshold"].get<int>();
         }
+        if (j.contains("loopCacheBudgetMB")) {
+            m_settings.loopCacheBudgetMB = j["loopCacheBudgetMB"].get<int>();
+        }
+        if (j.contains("preloadLimitMB")) {
+            m_settings.preloadLimitMB = j["preloadLimitMB"].get<int>();
+        }
+        if (j.contains("proxyTranscoding")) {
+            m_settings.proxyTranscoding = j["proxyTranscoding"].get<bool>();
+        }
+        if (j.contains("crossfadeMs")) {
+            m_settings.crossfadeMs = j["crossfadeMs"].get<int>();
+        }
         if (j.contains("processBlocklist")) {
             m_settings.processBlocklist = j["processBlocklist"].get<std::vector<std::string>>();
         }
@@ -86,6 +99,17 @@ bool Configuration::Load() {
                 if (value.contains("scalingMode")) {
                     config.scalingMode = value["scalingMode"].get<int>();
                 }
+                if (value.contains("playlist")) {
+                    for (const auto& entry : value["playlist"]) {
+                        config.playlist.push_back(FromUtf8(entry.get<std::string>()));
+                    }
+                }
+                if (value.contains("playlistAdvance")) {
+                    config.playlistAdvance = value["playlistAdvance"].get<int>();
+                }
+                if (value.contains("playlistInterval")) {
+                    config.playlistInterval = value["playlistInterval"].get<int>();
+                }
                 
                 // Convert key from UTF-8 to wide string
                 int wideLen = MultiByteToWideChar(CP_UTF8, 0, key.c_str(), -1, nullptr, 0);
@@ -126,6 +150,10 @@ bool Configuration::Save() {
         j["batteryAwareEnabled"] = m_settings.batteryAwareEnabled;
         j["autoStart"] = m_settings.autoStart;
         j["batteryThreshold"] = m_settings.batteryThreshold;
+        j["loopCacheBudgetMB"] = m_settings.loopCacheBudgetMB;
+        j["preloadLimitMB"] = m_settings.preloadLimitMB;
+        j["proxyTranscoding"] = m_settings.proxyTranscoding;
+        j["crossfadeMs"] = m_settings.crossfadeMs;
         j["processBlocklist"] = m_settings.processBlocklist;
         
         // Apply startup setting to registry
@@ -149,6 +177,14 @@ bool Configuration::Save() {
             
             monitorJson["enabled"] = config.enabled;
             monitorJson["scalingMode"] = config.scalingMode;
+
+            json playlistJson = json::array();
+            for (const auto& entry : config.playlist) {
+                playlistJson.push_back(ToUtf8(entry));
+            }
+            monitorJson["playlist"] = playlistJson;
+            monitorJson["playlistAdvance"] = config.playlistAdvance;
+            monitorJson["playlistInterval"] = config.playlistInterval;
             
             // Convert device name to UTF-8 for JSON key
             int keyLen = WideCharToMultiByte(CP_UTF8, 0, deviceName.c_str(), -1, nullptr, 0, nullptr, nullptr);
@@ -22,6 +22,9 @@ public:
         std::wstring wallpaperPath;
         bool enabled = true;
         int scalingMode = 0; // 0=Fill, 1=Fit, 2=Stretch, 3=Tile
+        std::vector<std::wstring> playlist; // Files and folders shown in turn instead of wallpaperPath
+        int playlistAdvance = 0; // 0=Interval, 1=Loop end (stills still use the interval)
+        int playlistInterval = 300; // Seconds per item
     };
 
     struct Settings {
@@ -29,6 +32,10 @@ public:
         bool batteryAwareEnabled = true;
         bool autoStart = false;
         int batteryThreshold = 20; // Percentage
+        int loopCacheBudgetMB = 256; // Decoded frames kept per short clip, 0 = off
+        int preloadLimitMB = 64; // Files up to this size are read into memory, 0 = off
+        bool proxyTranscoding = false; // Make cheaper-to-decode copies of wallpapers in the background
+        int crossfadeMs = 1000; // Transition when a wallpaper or playlist item changes, 0 = cut
         std::map<std::wstring, MonitorConfig> monitors; // Key: monitor device name
         std::vector<std::string> processBlocklist;
     };
@@ -55,6 +62,18 @@ public:
     int GetBatteryThreshold() const { return m_settings.batteryThreshold; }
     void SetBatteryThreshold(int threshold) { m_settings.batteryThreshold = threshold; }
 
+    int GetLoopCacheBudgetMB() const { return m_settings.loopCacheBudgetMB; }
+    void SetLoopCacheBudgetMB(int megabytes) { m_settings.loopCacheBudgetMB = megabytes; }
+
+    int GetPreloadLimitMB() const { return m_settings.preloadLimitMB; }
+    void SetPreloadLimitMB(int megabytes) { m_settings.preloadLimitMB = megabytes; }
+
+    bool GetProxyTranscoding() const { return m_settings.proxyTranscoding; }
+    void SetProxyTranscoding(bool enabled) { m_settings.proxyTranscoding = enabled; }
+
+    int GetCrossfadeMs() const { return m_settings.crossfadeMs; }
+    void SetCrossfadeMs(int milliseconds) { m_settings.crossfadeMs = milliseconds; }
+
     // Monitor-specific configuration
     MonitorConfig* GetMonitorConfig(const std::wstring& deviceName);
     void SetMonitorConfig(const std::wstring& deviceName, const MonitorConfig& config);
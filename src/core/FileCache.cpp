@@ -0,0 +1,87 @@
+#include "FileCache.h"
+
+#include <Windows.h>
+#include <shlobj.h>
+#include <cwctype>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+namespace PixelMotion {
+
+// FNV-1a, 64-bit
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+std::filesystem::path FileCache::GetCacheDirectory() {
+    wchar_t* localAppData = nullptr;
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &localAppData))) {
+        std::filesystem::path cacheDir = std::filesystem::path(localAppData) / L"PixelMotion" / L"cache";
+        CoTaskMemFree(localAppData);
+
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        if (!ec) {
+            return cacheDir;
+        }
+    }
+    return {};
+}
+
+std::filesystem::path FileCache::GetEntryPath(const std::wstring& sourcePath, const std::wstring& extension) {
+    uint64_t key = ComputeKey(sourcePath);
+    if (key == 0) {
+        return {};
+    }
+
+    std::filesystem::path cacheDir = GetCacheDirectory();
+    if (cacheDir.empty()) {
+        return {};
+    }
+
+    std::wostringstream name;
+    name << std::hex << std::setw(16) << std::setfill(L'0') << key << extension;
+    return cacheDir / name.str();
+}
+
+uint64_t FileCache::ComputeKey(const std::wstring& sourcePath) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(sourcePath, ec);
+    if (ec) {
+        canonical = sourcePath;
+    }
+
+    uint64_t size = std::filesystem::file_size(canonical, ec);
+    if (ec) {
+        return 0;
+    }
+
+    auto writeTime = std::filesystem::last_write_time(canonical, ec);
+    if (ec) {
+        return 0;
+    }
+    int64_t ticks = writeTime.time_since_epoch().count();
+
+    // Paths are case-insensitive on Windows
+    std::wstring path = canonical.wstring();
+    for (auto& c : path) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = HashBytes(hash, path.data(), path.size() * sizeof(wchar_t));
+    hash = HashBytes(hash, &size, sizeof(size));
+    hash = HashBytes(hash, &ticks, sizeof(ticks));
+    return hash != 0 ? hash : 1;
+}
+
+} // namespace PixelMotion
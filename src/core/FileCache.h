@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace PixelMotion {
+
+/**
+ * Locates per-file cache entries (indexes, probe results) under
+ * %LOCALAPPDATA%\PixelMotion\cache
+ * Entries are keyed by path, size and modification time, so editing or
+ * replacing a file makes its old entries unreachable
+ */
+class FileCache {
+public:
+    /**
+     * Cache entry path for a source file, e.g. "<cache>\<key>.kfi"
+     * @return empty path if the source file can't be examined
+     */
+    static std::filesystem::path GetEntryPath(const std::wstring& sourcePath, const std::wstring& extension);
+
+    static std::filesystem::path GetCacheDirectory();
+
+    /**
+     * Identity of a file's current contents (path, size and modification time)
+     * @return 0 if the file can't be examined
+     */
+    static uint64_t ComputeKey(const std::wstring& sourcePath);
+};
+
+} // namespace PixelMotion
@@ -1,8 +1,12 @@
 #include "Logger.h"
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <shlobj.h>
+#endif
+
 #include <chrono>
+#include <cstdio>
 #include <iomanip>
 #include <sstream>
 #include <filesystem>
@@ -16,6 +20,7 @@ bool Logger::s_initialized = false;
 void Logger::Initialize() {
     if (s_initialized) return;
 
+#ifdef _WIN32
     // Get AppData\Local\PixelMotion\logs directory
     wchar_t* localAppData = nullptr;
     if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &localAppData))) {
@@ -39,6 +44,7 @@ void Logger::Initialize() {
         std::filesystem::path logPath = logDir / filename.str();
         s_logFile.open(logPath, std::ios::out | std::ios::app);
     }
+#endif
 
     s_initialized = true;
 }
@@ -75,8 +81,12 @@ void Logger::Log(Level level, const std::string& message) {
         s_logFile.flush();
     }
 
-    // Write to debug output
+    // Write to debug output (stderr where the playback core runs headless)
+#ifdef _WIN32
     OutputDebugStringA(fullMessage.c_str());
+#else
+    std::fputs(fullMessage.c_str(), stderr);
+#endif
 }
 
 std::string Logger::GetTimestamp() {
@@ -86,7 +96,11 @@ std::string Logger::GetTimestamp() {
         now.time_since_epoch()) % 1000;
 
     std::tm tm;
+#ifdef _WIN32
     localtime_s(&tm, &time_t);
+#else
+    localtime_r(&time_t, &tm);
+#endif
 
     std::ostringstream oss;
     oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S")
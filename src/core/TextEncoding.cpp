@@ -0,0 +1,29 @@
+#include "TextEncoding.h"
+
+#include <Windows.h>
+
+namespace PixelMotion {
+
+std::string ToUtf8(const std::wstring& text) {
+    int utf8Len = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, nullptr, 0, nullptr, nullptr);
+    if (utf8Len <= 0) {
+        return std::string();
+    }
+    std::string utf8(utf8Len, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, &utf8[0], utf8Len, nullptr, nullptr);
+    utf8.resize(utf8Len - 1); // Remove null terminator
+    return utf8;
+}
+
+std::wstring FromUtf8(const std::string& text) {
+    int wideLen = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+    if (wideLen <= 0) {
+        return std::wstring();
+    }
+    std::wstring wide(wideLen, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &wide[0], wideLen);
+    wide.resize(wideLen - 1); // Remove null terminator
+    return wide;
+}
+
+} // namespace PixelMotion
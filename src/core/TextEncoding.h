@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace PixelMotion {
+
+/**
+ * UTF-8 form of a wide string, e.g. a path for FFmpeg or a JSON value
+ * @return empty string if the text can't be converted
+ */
+std::string ToUtf8(const std::wstring& text);
+
+/**
+ * Wide form of a UTF-8 string
+ * @return empty string if the text can't be converted
+ */
+std::wstring FromUtf8(const std::string& text);
+
+} // namespace PixelMotion
@@ -1,10 +1,18 @@
 #include "DesktopManager.h"
 #include "WallpaperWindow.h"
 #include "MonitorInfo.h"
+#include "Playlist.h"
 #include "core/Logger.h"
 #include "core/Configuration.h"
+#include "core/FileCache.h"
+#include "core/TextEncoding.h"
+#include "video/MediaLoader.h"
+#include "video/MediaSourceRegistry.h"
+#include "video/ProxyTranscoder.h"
+#include "video/StillImageCache.h"
 
 #include <algorithm>
+#include <chrono>
 
 namespace PixelMotion {
 
@@ -54,7 +62,10 @@ void DesktopManager::Shutdown() {
 
     Logger::Info("Shutting down Desktop Manager...");
     
+    ProxyTranscoder::GetInstance().Shutdown();
+    MediaLoader::GetInstance().Shutdown();
     DestroyWallpaperWindows();
+    StillImageCache::GetInstance().ReleaseSources();
     
     m_workerW = nullptr;
     m_progman = nullptr;
@@ -123,9 +134,7 @@ bool DesktopManager::CreateWallpaperWindows() {
         auto wallpaperWindow = std::make_unique<WallpaperWindow>();
         
         if (!wallpaperWindow->Create(m_workerW, monitor)) {
-            std::wstring wDeviceName = monitor.deviceName;
-            std::string deviceName(wDeviceName.begin(), wDeviceName.end());
-            Logger::Error("Failed to create wallpaper window for monitor: " + deviceName);
+            Logger::Error("Failed to create wallpaper window for monitor: " + ToUtf8(monitor.deviceName));
             continue;
         }
 
@@ -139,30 +148,85 @@ void DesktopManager::DestroyWallpaperWindows() {
     m_wallpaperWindows.clear();
 }
 
-bool DesktopManager::SetWallpaper(int monitorIndex, const std::wstring& videoPath) {
+bool DesktopManager::BeginSetWallpaper(int monitorIndex, const std::wstring& videoPath) {
     if (monitorIndex < 0 || monitorIndex >= static_cast<int>(m_wallpaperWindows.size())) {
         Logger::Error("Invalid monitor index: " + std::to_string(monitorIndex));
         return false;
     }
 
-    std::wstring wPath = videoPath;
-    std::string path(wPath.begin(), wPath.end());
-    Logger::Info("Setting wallpaper for monitor " + std::to_string(monitorIndex) + ": " + path);
+    Logger::Info("Setting wallpaper for monitor " + std::to_string(monitorIndex) + ": " + ToUtf8(videoPath));
 
+    auto setStart = std::chrono::steady_clock::now();
     auto* window = m_wallpaperWindows[monitorIndex].get();
-    
+    window->ClearPlaylist();
+    ApplyMonitorSettings(window);
+    RequestProxy(window, videoPath);
+
+    // The current wallpaper keeps playing until the new one is ready
+    bool started = window->LoadVideoAsync(videoPath);
+
+    double setMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setStart).count();
+    Logger::Info("BeginSetWallpaper held the main loop for " + std::to_string(setMs) + " ms");
+    return started;
+}
+
+bool DesktopManager::SetPlaylist(int monitorIndex, const Playlist& playlist, int advanceMode, int intervalSeconds) {
+    if (monitorIndex < 0 || monitorIndex >= static_cast<int>(m_wallpaperWindows.size())) {
+        Logger::Error("Invalid monitor index: " + std::to_string(monitorIndex));
+        return false;
+    }
+
+    if (playlist.IsEmpty()) {
+        Logger::Warning("Playlist for monitor " + std::to_string(monitorIndex) + " has nothing to show");
+        return false;
+    }
+
+    Logger::Info("Setting playlist for monitor " + std::to_string(monitorIndex) + ": " +
+                 std::to_string(playlist.GetCount()) + " items");
+
+    auto* window = m_wallpaperWindows[monitorIndex].get();
+    window->ClearPlaylist();
+    ApplyMonitorSettings(window);
+    for (const auto& item : playlist.GetItems()) {
+        RequestProxy(window, item);
+    }
+
+    // Every item is loaded in the background, the first one right away
+    bool started = window->LoadVideoAsync(playlist.GetCurrent());
+    window->SetPlaylist(playlist, advanceMode, std::max(1, intervalSeconds));
+    return started;
+}
+
+void DesktopManager::ApplyMonitorSettings(WallpaperWindow* window) {
+    if (!m_config) {
+        return;
+    }
+
+    window->SetCrossfadeDuration(std::max(0, m_config->GetCrossfadeMs()) / 1000.0);
+
     // Get scaling mode from configuration
-    if (m_config) {
-        const auto& monitor = window->GetMonitor();
-        auto* monitorConfig = m_config->GetMonitorConfig(monitor.deviceName);
-        if (monitorConfig) {
-            int scalingMode = monitorConfig->scalingMode;
-            window->SetScalingMode(scalingMode);
-            Logger::Info("Applied scaling mode: " + std::to_string(scalingMode));
-        }
+    const auto& monitor = window->GetMonitor();
+    auto* monitorConfig = m_config->GetMonitorConfig(monitor.deviceName);
+    if (monitorConfig) {
+        int scalingMode = monitorConfig->scalingMode;
+        window->SetScalingMode(scalingMode);
+        Logger::Info("Applied scaling mode: " + std::to_string(scalingMode));
     }
 
-    return window->LoadVideo(videoPath);
+    DecoderOptions options;
+    options.loopCacheBudget = static_cast<size_t>(std::max(0, m_config->GetLoopCacheBudgetMB())) * 1024 * 1024;
+    options.preloadLimit = static_cast<size_t>(std::max(0, m_config->GetPreloadLimitMB())) * 1024 * 1024;
+    if (m_config->GetProxyTranscoding()) {
+        // Opens the proxy if it's ready; otherwise it is made and swapped in later
+        options.proxyHeight = ProxyTranscoder::GetRung(monitor.height);
+    }
+    window->SetDecoderOptions(options);
+}
+
+void DesktopManager::RequestProxy(WallpaperWindow* window, const std::wstring& videoPath) {
+    if (m_config && m_config->GetProxyTranscoding()) {
+        ProxyTranscoder::GetInstance().Request(videoPath, ProxyTranscoder::GetRung(window->GetMonitor().height));
+    }
 }
 
 void DesktopManager::RestoreWallpapers() {
@@ -179,14 +243,20 @@ void DesktopManager::RestoreWallpapers() {
             // Apply scaling mode regardless of wallpaper (in case they want to set it before invalid wallpaper)
             window->SetScalingMode(monitorConfig->scalingMode);
 
+            // A playlist takes the place of the single wallpaper
+            if (monitorConfig->enabled && !monitorConfig->playlist.empty()) {
+                SetPlaylist(static_cast<int>(i), Playlist(monitorConfig->playlist),
+                            monitorConfig->playlistAdvance, monitorConfig->playlistInterval);
+                continue;
+            }
+
             // Restore wallpaper if enabled and path exists
             if (monitorConfig->enabled && !monitorConfig->wallpaperPath.empty()) {
                 if (std::filesystem::exists(monitorConfig->wallpaperPath)) {
-                    // Use SetWallpaper to handle logging and any future logic
-                    SetWallpaper(static_cast<int>(i), monitorConfig->wallpaperPath);
+                    // Use BeginSetWallpaper to handle logging and any future logic
+                    BeginSetWallpaper(static_cast<int>(i), monitorConfig->wallpaperPath);
                 } else {
-                    std::string pathUtf8(monitorConfig->wallpaperPath.begin(), monitorConfig->wallpaperPath.end());
-                    Logger::Warning("Saved wallpaper path not found: " + pathUtf8);
+                    Logger::Warning("Saved wallpaper path not found: " + ToUtf8(monitorConfig->wallpaperPath));
                 }
             }
         }
@@ -209,6 +279,48 @@ void DesktopManager::Update() {
     for (auto& window : m_wallpaperWindows) {
         window->Update();
     }
+
+    // Wallpapers set since the last tick have all converted their still images
+    // (once every background load has finished)
+    bool loading = std::any_of(m_wallpaperWindows.begin(), m_wallpaperWindows.end(),
+                               [](const auto& window) { return window->IsLoading(); });
+    if (!loading) {
+        StillImageCache::GetInstance().ReleaseSources();
+    }
+
+    for (const auto& sourcePath : ProxyTranscoder::GetInstance().TakeFinished()) {
+        ReloadWallpapers(sourcePath);
+    }
+}
+
+std::vector<std::wstring> DesktopManager::TakeFailedWallpapers() {
+    std::vector<std::wstring> failed;
+    for (auto& window : m_wallpaperWindows) {
+        std::wstring path = window->TakeFailedLoad();
+        if (!path.empty()) {
+            failed.push_back(std::move(path));
+        }
+    }
+    return failed;
+}
+
+void DesktopManager::ReloadWallpapers(const std::wstring& sourcePath) {
+    uint64_t key = FileCache::ComputeKey(sourcePath);
+    if (key == 0) {
+        return;
+    }
+
+    // The registry keys proxies apart from their sources, so these loads open
+    // the proxy while the source keeps playing until the handover
+    for (auto& window : m_wallpaperWindows) {
+        if (window->HasVideo() && !window->IsLoading() && FileCache::ComputeKey(window->GetMediaPath()) == key) {
+            window->LoadVideoAsync(window->GetMediaPath());
+        }
+    }
+}
+
+void DesktopManager::SetPowerState(bool onBattery, bool lowBattery) {
+    MediaSourceRegistry::GetInstance().SetPowerState(onBattery, lowBattery);
 }
 
 double DesktopManager::GetTimeToNextUpdate() const {
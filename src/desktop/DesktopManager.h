@@ -7,6 +7,7 @@
 
 namespace PixelMotion {
 
+class Playlist;
 class WallpaperWindow;
 class RendererContext;
 
@@ -22,19 +23,37 @@ public:
     bool Initialize();
     void Shutdown();
 
-    bool SetWallpaper(int monitorIndex, const std::wstring& videoPath);
+    /**
+     * Start loading a wallpaper in the background; the current one keeps
+     * playing until the new one has its first frame
+     * @return false if the load couldn't be started. A load that fails later
+     *         leaves the current wallpaper up and is reported by TakeFailedWallpapers
+     */
+    bool BeginSetWallpaper(int monitorIndex, const std::wstring& videoPath);
+
+    /**
+     * Wallpapers whose background load failed since the last call
+     */
+    std::vector<std::wstring> TakeFailedWallpapers();
+
+    bool SetPlaylist(int monitorIndex, const Playlist& playlist, int advanceMode, int intervalSeconds); // 0=Interval, 1=Loop end
     void RestoreWallpapers();
 
     void Update();
     void Render();
     double GetTimeToNextUpdate() const;
 
+    void SetPowerState(bool onBattery, bool lowBattery); // Selects decode mode and threading
+
     void SetConfiguration(class Configuration* config) { m_config = config; }
 
 private:
     bool FindWorkerW();
     bool CreateWallpaperWindows();
     void DestroyWallpaperWindows();
+    void ApplyMonitorSettings(WallpaperWindow* window); // Scaling mode and decoder options from the configuration
+    void RequestProxy(WallpaperWindow* window, const std::wstring& videoPath);
+    void ReloadWallpapers(const std::wstring& sourcePath); // Reopen every window showing this file, in the background
     
     static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam);
 
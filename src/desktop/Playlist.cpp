@@ -0,0 +1,86 @@
+#include "Playlist.h"
+#include "core/Logger.h"
+#include "core/TextEncoding.h"
+#include "video/ClipFormat.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <filesystem>
+#include <system_error>
+
+namespace PixelMotion {
+
+static std::wstring ToLower(std::wstring text) {
+    for (auto& c : text) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+    return text;
+}
+
+Playlist::Playlist()
+    : m_position(0)
+{
+}
+
+Playlist::Playlist(const std::vector<std::wstring>& entries)
+    : m_position(0)
+{
+    for (const auto& entry : entries) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(entry, ec)) {
+            if (std::filesystem::exists(entry, ec)) {
+                m_items.push_back(entry);
+            } else {
+                Logger::Warning("Playlist entry not found: " + ToUtf8(entry));
+            }
+            continue;
+        }
+
+        std::vector<std::wstring> files;
+        for (const auto& file : std::filesystem::directory_iterator(entry, ec)) {
+            if (file.is_regular_file(ec) && IsMediaFile(file.path().wstring())) {
+                files.push_back(file.path().wstring());
+            }
+        }
+        std::sort(files.begin(), files.end(), [](const std::wstring& a, const std::wstring& b) {
+            return ToLower(a) < ToLower(b);
+        });
+        m_items.insert(m_items.end(), files.begin(), files.end());
+    }
+
+    Logger::Info("Playlist has " + std::to_string(m_items.size()) + " items");
+}
+
+bool Playlist::IsMediaFile(const std::wstring& filePath) {
+    static const wchar_t* extensions[] = {
+        L".mp4", L".mkv", L".avi", L".mov", L".wmv", L".webm",
+        L".jpg", L".jpeg", L".png", L".bmp", L".gif", L".apng", L".webp",
+        CLIP_FILE_EXTENSION
+    };
+
+    std::wstring extension = ToLower(std::filesystem::path(filePath).extension().wstring());
+    for (const wchar_t* candidate : extensions) {
+        if (extension == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::wstring& Playlist::GetCurrent() const {
+    static const std::wstring empty;
+    return m_items.empty() ? empty : m_items[m_position];
+}
+
+const std::wstring& Playlist::PeekNext() const {
+    static const std::wstring empty;
+    return m_items.empty() ? empty : m_items[(m_position + 1) % m_items.size()];
+}
+
+void Playlist::Advance() {
+    if (!m_items.empty()) {
+        m_position = (m_position + 1) % m_items.size();
+    }
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace PixelMotion {
+
+/**
+ * Ordered list of wallpapers shown in turn on one monitor
+ * Folders are expanded into the media files directly inside them, sorted
+ * by name; the list wraps around at the end
+ */
+class Playlist {
+public:
+    Playlist();
+    explicit Playlist(const std::vector<std::wstring>& entries);
+
+    /**
+     * Whether a file looks like something a wallpaper can show (by extension)
+     */
+    static bool IsMediaFile(const std::wstring& filePath);
+
+    bool IsEmpty() const { return m_items.empty(); }
+    size_t GetCount() const { return m_items.size(); }
+    const std::vector<std::wstring>& GetItems() const { return m_items; }
+
+    const std::wstring& GetCurrent() const;
+    const std::wstring& PeekNext() const;
+    void Advance();
+
+private:
+    std::vector<std::wstring> m_items;
+    size_t m_position;
+};
+
+} // namespace PixelMotion
@@ -1,20 +1,52 @@
 #include "WallpaperWindow.h"
 #include "rendering/RendererContext.h"
 #include "video/VideoDecoder.h"
+#include "video/AnimatedImage.h"
+#include "video/MediaSourceRegistry.h"
+#include "video/StillImageCache.h"
+#include "video/PresentationClock.h"
 #include "core/Logger.h"
+#include "core/TextEncoding.h"
+
+#include <algorithm>
+#include <chrono>
 
 namespace PixelMotion {
 
+// How long before an item is due the next one starts loading
+constexpr double PREFETCH_LEAD_SECONDS = 5.0;
+
+// Repaint rate while crossfading
+constexpr double CROSSFADE_FRAME_INTERVAL = 1.0 / 60.0;
+
+// How often a due item that is still loading is checked for
+constexpr double PREFETCH_POLL_INTERVAL = 0.05;
+
+// How often a wallpaper loading in the background is checked for, so it
+// shows promptly even when the current content is static
+constexpr double LOAD_POLL_INTERVAL = 0.01;
+
 const wchar_t* WallpaperWindow::s_className = L"PixelMotionWallpaperWindow";
 bool WallpaperWindow::s_classRegistered = false;
 
 WallpaperWindow::WallpaperWindow()
     : m_hwnd(nullptr)
     , m_parent(nullptr)
-    , m_frameInterval(1.0 / 30.0) // Default 30 FPS
+    , m_frameSerial(0)
+    , m_scalingMode(0)
+    , m_imageStale(false)
     , m_needsRepaint(false)
+    , m_loadTicket(0)
+    , m_loadStart(0.0)
+    , m_playlistAdvance(0)
+    , m_playlistInterval(0.0)
+    , m_advanceAt(0.0)
+    , m_prefetchTicket(0)
+    , m_failedItems(0)
+    , m_crossfadeDuration(0.0)
+    , m_fadeStart(0.0)
+    , m_switchMs(0.0)
 {
-    m_lastFrameTime = std::chrono::steady_clock::now();
 }
 
 WallpaperWindow::~WallpaperWindow() {
@@ -109,21 +141,25 @@ bool WallpaperWindow::Create(HWND parentWorkerW, const MonitorInfo& monitor) {
         return false;
     }
 
-    std::wstring wDeviceName = monitor.deviceName;
-    std::string deviceName(wDeviceName.begin(), wDeviceName.end());
-    Logger::Info("Created wallpaper window for monitor: " + deviceName);
+    Logger::Info("Created wallpaper window for monitor: " + ToUtf8(monitor.deviceName));
     return true;
 }
 
 void WallpaperWindow::Destroy() {
+    CancelLoad();
+    ClearPlaylist();
+
     if (m_renderer) {
         m_renderer->Shutdown();
         m_renderer.reset();
     }
 
+    m_presentedFrame.Reset();
     if (m_videoDecoder) {
         m_videoDecoder.reset();
     }
+    m_image.reset();
+    m_animation.reset();
 
     if (m_hwnd) {
         DestroyWindow(m_hwnd);
@@ -134,8 +170,9 @@ void WallpaperWindow::Destroy() {
 bool WallpaperWindow::LoadVideo(const std::wstring& videoPath) {
     Logger::Info("Loading video for wallpaper...");
 
-    // Create video decoder
-    m_videoDecoder = std::make_unique<VideoDecoder>();
+    // Release the previous source (closed if no other window uses it)
+    Install(LoadedMedia());
+    m_mediaPath = videoPath;
 
     // Get D3D11 device from renderer
     if (!m_renderer) {
@@ -143,43 +180,207 @@ bool WallpaperWindow::LoadVideo(const std::wstring& videoPath) {
         return false;
     }
 
-    ID3D11Device* device = m_renderer->GetDevice();
-    if (!device) {
-        Logger::Error("Could not get D3D11 device");
+    LoadedMedia media = MediaLoader::Load(MakeLoadRequest(videoPath));
+    if (!media.IsValid()) {
         return false;
     }
 
-    // Initialize decoder
-    if (!m_videoDecoder->Initialize(videoPath, device)) {
-        Logger::Error("Failed to initialize video decoder");
-        m_videoDecoder.reset();
+    Install(std::move(media));
+    return true;
+}
+
+bool WallpaperWindow::LoadVideoAsync(const std::wstring& videoPath) {
+    CancelLoad();
+
+    if (!m_renderer) {
+        Logger::Error("Renderer not initialized");
         return false;
     }
 
-    // Update frame interval based on video frame rate
-    double fps = m_videoDecoder->GetFrameRate();
-    if (fps > 0) {
-        m_frameInterval = 1.0 / fps;
+    m_loadPath = videoPath;
+    m_loadStart = PresentationClock::Now();
+    m_loadTicket = MediaLoader::GetInstance().Submit(MakeLoadRequest(videoPath));
+    return m_loadTicket != 0;
+}
+
+void WallpaperWindow::CancelLoad() {
+    if (m_loadTicket != 0) {
+        MediaLoader::GetInstance().Cancel(m_loadTicket);
+        m_loadTicket = 0;
     }
+}
 
-    // Decode first frame
-    if (!m_videoDecoder->DecodeNextFrame()) {
-        Logger::Error("Failed to decode first frame");
-        m_videoDecoder.reset();
-        return false;
+void WallpaperWindow::UpdatePendingLoad(double now) {
+    LoadedMedia media;
+    if (!MediaLoader::GetInstance().Poll(m_loadTicket, media)) {
+        return;
     }
+    m_loadTicket = 0;
 
-    m_lastFrameTime = std::chrono::steady_clock::now();
+    double loadMs = (now - m_loadStart) * 1000.0;
+    std::string path = ToUtf8(m_loadPath);
+    if (!media.IsValid()) {
+        Logger::Warning("Failed to load wallpaper, keeping the current one: " + path);
+        m_failedLoadPath = m_loadPath;
+        return;
+    }
 
-    std::wstring wPath = videoPath;
-    std::string path(wPath.begin(), wPath.end());
-    Logger::Info("Video loaded successfully: " + path);
-    return true;
+    // Until now the old content kept playing; the handover is a pointer swap
+    SwitchTo(std::move(media), now);
+    Logger::Info("Wallpaper loaded in the background in " + std::to_string(loadMs) +
+                 " ms, main loop held for " + std::to_string(m_switchMs) + " ms by the handover");
+}
+
+std::wstring WallpaperWindow::TakeFailedLoad() {
+    std::wstring path;
+    path.swap(m_failedLoadPath);
+    return path;
+}
+
+MediaLoader::Request WallpaperWindow::MakeLoadRequest(const std::wstring& path) const {
+    MediaLoader::Request request;
+    request.path = path;
+    request.device = m_renderer ? m_renderer->GetDevice() : nullptr;
+    request.targetWidth = m_monitor.width;
+    request.targetHeight = m_monitor.height;
+    request.scalingMode = m_scalingMode;
+    request.options = m_decoderOptions;
+    return request;
+}
+
+LoadedMedia WallpaperWindow::Install(LoadedMedia media) {
+    LoadedMedia previous;
+    previous.path = m_mediaPath;
+    previous.decoder = std::move(m_videoDecoder);
+    previous.image = std::move(m_image);
+    previous.animation = std::move(m_animation);
+
+    m_presentedFrame.Reset();
+    m_videoDecoder = std::move(media.decoder);
+    m_image = std::move(media.image);
+    m_animation = std::move(media.animation);
+    m_mediaPath = media.path;
+    m_frameSerial = 0;
+    m_imageStale = false;
+    m_needsRepaint = HasVideo();
+    return previous;
+}
+
+void WallpaperWindow::SetPlaylist(const Playlist& playlist, int advanceMode, double intervalSeconds) {
+    CancelPrefetch();
+    m_playlist = playlist;
+    m_playlistAdvance = advanceMode;
+    m_playlistInterval = intervalSeconds;
+    m_failedItems = 0;
+
+    // Restarted when the first item is swapped in; with nothing to show, move on right away
+    double now = PresentationClock::Now();
+    m_advanceAt = HasVideo() ? now + GetItemDuration() : now;
+}
+
+void WallpaperWindow::ClearPlaylist() {
+    CancelPrefetch();
+    m_playlist = Playlist();
+}
+
+void WallpaperWindow::CancelPrefetch() {
+    if (m_prefetchTicket != 0) {
+        MediaLoader::GetInstance().Cancel(m_prefetchTicket);
+        m_prefetchTicket = 0;
+    }
+}
+
+double WallpaperWindow::GetItemDuration() const {
+    if (m_playlistAdvance == 1) {
+        if (m_videoDecoder && !m_videoDecoder->IsImage() && m_videoDecoder->GetDuration() > 0.0) {
+            return m_videoDecoder->GetDuration();
+        }
+        if (m_animation && m_animation->GetLoopDuration() > 0) {
+            return m_animation->GetLoopDuration() / 1000000.0;
+        }
+    }
+    return m_playlistInterval;
+}
+
+bool WallpaperWindow::IsPlaylistActive() const {
+    // A single item that loaded has nothing to advance to
+    return !m_playlist.IsEmpty() && (m_playlist.GetCount() > 1 || !HasVideo());
+}
+
+void WallpaperWindow::UpdatePlaylist(double now) {
+    // Open the next item ahead of time so the switch only swaps pointers
+    if (m_prefetchTicket == 0 && now >= m_advanceAt - PREFETCH_LEAD_SECONDS) {
+        m_prefetchTicket = MediaLoader::GetInstance().Submit(MakeLoadRequest(m_playlist.PeekNext()));
+        if (m_prefetchTicket == 0) {
+            return;
+        }
+    }
+
+    if (now < m_advanceAt) {
+        return;
+    }
+
+    // Still loading: the current item keeps playing
+    LoadedMedia next;
+    if (!MediaLoader::GetInstance().Poll(m_prefetchTicket, next)) {
+        return;
+    }
+    m_prefetchTicket = 0;
+    m_playlist.Advance();
+
+    if (!next.IsValid()) {
+        Logger::Warning("Skipping playlist item that failed to load: " + ToUtf8(next.path));
+
+        // Try the following item now, unless the whole list has failed
+        m_failedItems++;
+        if (m_failedItems < m_playlist.GetCount()) {
+            m_advanceAt = now;
+        } else {
+            m_failedItems = 0;
+            m_advanceAt = now + m_playlistInterval;
+        }
+        return;
+    }
+
+    m_failedItems = 0;
+    SwitchTo(std::move(next), now);
+}
+
+void WallpaperWindow::SwitchTo(LoadedMedia media, double now) {
+    auto switchStart = std::chrono::steady_clock::now();
+
+    // Keep the picture now on screen to fade out from
+    if (m_crossfadeDuration > 0.0 && m_renderer && HasVideo()) {
+        BindContent();
+        m_renderer->BeginCrossfade();
+    }
+
+    // Closing the old decoder joins its decode thread, so that happens on the loader
+    MediaLoader::GetInstance().Release(Install(std::move(media)));
+    m_advanceAt = now + GetItemDuration();
+    m_fadeStart = now;
+
+    m_switchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - switchStart).count();
+
+    Logger::Info("Switched to: " + ToUtf8(m_mediaPath));
+}
+
+void WallpaperWindow::UpdateCrossfade(double now) {
+    if (!m_renderer || !m_renderer->IsCrossfading()) {
+        return;
+    }
+
+    double amount = (m_crossfadeDuration > 0.0) ? (now - m_fadeStart) / m_crossfadeDuration : 1.0;
+    m_renderer->SetCrossfade(static_cast<float>(amount));
+    m_needsRepaint = true;
 }
 
 void WallpaperWindow::UnloadVideo() {
-    if (m_videoDecoder) {
+    if (m_videoDecoder || m_image || m_animation) {
+        m_presentedFrame.Reset();
         m_videoDecoder.reset();
+        m_image.reset();
+        m_animation.reset();
         Logger::Info("Video unloaded");
     }
 }
@@ -234,6 +435,29 @@ LRESULT CALLBACK WallpaperWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LP
 }
 
 void WallpaperWindow::Update() {
+    double now = PresentationClock::Now();
+    if (IsLoading()) {
+        UpdatePendingLoad(now);
+    } else if (IsPlaylistActive()) {
+        UpdatePlaylist(now);
+    }
+    UpdateCrossfade(now);
+
+    // Convert the image again for the new scaling mode, showing the old one meanwhile
+    if (m_image && m_imageStale && !IsLoading()) {
+        m_imageStale = false;
+        LoadVideoAsync(m_mediaPath);
+        return;
+    }
+
+    if (m_animation) {
+        m_animation->UpdatePlayback(now);
+        if (m_animation->GetFrameSerial() != m_frameSerial) {
+            m_needsRepaint = true;
+        }
+        return;
+    }
+
     if (!m_videoDecoder) {
         return;
     }
@@ -243,35 +467,48 @@ void WallpaperWindow::Update() {
         return;
     }
 
-    // Check if it's time for the next frame
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed = now - m_lastFrameTime;
-
-    if (elapsed.count() >= m_frameInterval) {
-        // Decode next frame
-        if (!m_videoDecoder->DecodeNextFrame()) {
-            // End of file - loop back to beginning
-            if (m_videoDecoder->IsEndOfFile()) {
-                m_videoDecoder->Reset();
-                m_videoDecoder->DecodeNextFrame();
-            }
-        }
-        
-        m_lastFrameTime = now;
+    // Frames are scheduled from their timestamps; the decoder picks the one that is due.
+    // Another window sharing the decoder may already have advanced it this tick
+    m_videoDecoder->UpdatePlayback(now);
+    if (m_videoDecoder->GetFrameSerial() != m_frameSerial) {
         m_needsRepaint = true;
     }
+
+    // The last good frame stays up; a playlist moves on instead of showing it
+    if (m_videoDecoder->HasDecodeFailed() && IsPlaylistActive() && m_advanceAt > now) {
+        m_advanceAt = now;
+    }
 }
 
 double WallpaperWindow::GetTimeToNextFrame() const {
-    if (!m_videoDecoder || m_videoDecoder->IsImage()) {
-        return 1.0; // Static content, check infrequently
+    double now = PresentationClock::Now();
+    double timeToNext = 1.0; // Static content, check infrequently
+
+    if (m_animation) {
+        timeToNext = m_animation->GetTimeToNextFrame(now);
+    } else if (m_videoDecoder && !m_videoDecoder->IsImage()) {
+        timeToNext = m_videoDecoder->GetTimeToNextFrame(now);
     }
-    
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed = now - m_lastFrameTime;
-    double remaining = m_frameInterval - elapsed.count();
-    
-    return (remaining > 0.0) ? remaining : 0.0;
+
+    if (m_renderer && m_renderer->IsCrossfading()) {
+        timeToNext = std::min(timeToNext, CROSSFADE_FRAME_INTERVAL);
+    }
+    if (IsLoading()) {
+        timeToNext = std::min(timeToNext, LOAD_POLL_INTERVAL);
+    }
+    if (IsPlaylistActive()) {
+        double timeToAdvance = m_advanceAt - now;
+        timeToNext = std::min(timeToNext, (timeToAdvance > 0.0) ? timeToAdvance : PREFETCH_POLL_INTERVAL);
+    }
+    return timeToNext;
+}
+
+bool WallpaperWindow::IsCrossfading() const {
+    return m_renderer && m_renderer->IsCrossfading();
+}
+
+int WallpaperWindow::GetLateFrameCount() const {
+    return m_videoDecoder ? m_videoDecoder->GetLateFrameCount() : 0;
 }
 
 void WallpaperWindow::Render() {
@@ -279,21 +516,46 @@ void WallpaperWindow::Render() {
         return;
     }
 
-    if (m_videoDecoder) {
+    BindContent();
+    m_renderer->Render();
+    m_renderer->Present(); // Display the frame
+    m_needsRepaint = false;
+}
+
+void WallpaperWindow::BindContent() {
+    if (m_image) {
+        m_renderer->SetVideoTexture(m_image->GetTexture(), 0, m_image->GetWidth(), m_image->GetHeight());
+    } else if (m_animation) {
+        m_renderer->SetVideoTexture(m_animation->GetTexture(), 0, m_animation->GetWidth(), m_animation->GetHeight());
+        m_frameSerial = m_animation->GetFrameSerial();
+    } else if (m_videoDecoder) {
         // Get current frame texture and array index
-        ID3D11Texture2D* frameTexture = m_videoDecoder->GetFrameTexture();
+        ID3D11Texture2D* frameTexture = m_videoDecoder->GetFrameTexture(m_monitor.width, m_monitor.height, m_scalingMode);
         int arrayIndex = m_videoDecoder->GetFrameArrayIndex();
         if (frameTexture) {
-            m_renderer->SetVideoTexture(frameTexture, arrayIndex, m_videoDecoder->GetWidth(), m_videoDecoder->GetHeight());
+            m_presentedFrame = m_videoDecoder->AcquireFrame();
+            m_renderer->SetVideoTexture(frameTexture, arrayIndex,
+                                        m_videoDecoder->GetVisibleWidth(), m_videoDecoder->GetVisibleHeight());
         }
+        m_frameSerial = m_videoDecoder->GetFrameSerial();
     }
-
-    m_renderer->Render();
-    m_renderer->Present(); // Display the frame
-    m_needsRepaint = false;
 }
 
 void WallpaperWindow::SetScalingMode(int mode) {
+    // Still images are cropped and scaled for the mode when converted
+    if (m_image && mode != m_scalingMode) {
+        m_imageStale = true;
+    }
+    // Prefetched or loading images would be converted for the old mode
+    bool changed = (mode != m_scalingMode);
+    if (changed) {
+        CancelPrefetch();
+    }
+    m_scalingMode = mode;
+    if (changed && IsLoading()) {
+        LoadVideoAsync(m_loadPath);
+    }
+
     if (m_renderer) {
         m_renderer->SetScalingMode(mode);
     }
@@ -1,14 +1,20 @@
 #pragma once
 
 #include "MonitorInfo.h"
+#include "Playlist.h"
+#include "video/DecoderOptions.h"
+#include "video/FrameHandle.h"
+#include "video/MediaLoader.h"
 #include <Windows.h>
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <chrono>
 
 namespace PixelMotion {
 
+class AnimatedImage;
 class RendererContext;
+class StillImage;
 class VideoDecoder;
 
 /**
@@ -23,36 +29,107 @@ public:
     bool Create(HWND parentWorkerW, const MonitorInfo& monitor);
     void Destroy();
 
-    bool LoadVideo(const std::wstring& videoPath);
+    bool LoadVideo(const std::wstring& videoPath); // Blocks until loaded; the old content is released first
     void UnloadVideo();
 
+    /**
+     * Load a file in the background while the current content keeps playing
+     * The new content replaces it in one step once its first frame is ready;
+     * if the load fails, the current content stays
+     * @return false if the load couldn't be started
+     */
+    bool LoadVideoAsync(const std::wstring& videoPath);
+    bool IsLoading() const { return m_loadTicket != 0; }
+
+    /**
+     * Path of a LoadVideoAsync that failed since the last call, empty if none
+     */
+    std::wstring TakeFailedLoad();
+
+    /**
+     * Show the items of a playlist in turn, starting from the content loaded
+     * (or loading) for its current item. Each item plays for intervalSeconds,
+     * or once through with advanceMode 1 (videos and animations); the next
+     * item is loaded in the background ahead of time
+     * @param advanceMode 0=Interval, 1=Loop end
+     */
+    void SetPlaylist(const Playlist& playlist, int advanceMode, double intervalSeconds);
+    void ClearPlaylist();
+
+    void SetCrossfadeDuration(double seconds) { m_crossfadeDuration = seconds; } // Between contents, 0 = cut
+
     void Update();
     void Render();
 
     void SetScalingMode(int mode); // 0=Fill, 1=Fit, 2=Stretch, 3=Center
+    void SetDecoderOptions(const DecoderOptions& options) { m_decoderOptions = options; } // Applies to the next load
 
     HWND GetHandle() const { return m_hwnd; }
     const MonitorInfo& GetMonitor() const { return m_monitor; }
-    bool HasVideo() const { return m_videoDecoder != nullptr; }
+    const std::wstring& GetMediaPath() const { return m_mediaPath; }
+    bool HasVideo() const { return m_videoDecoder != nullptr || m_image != nullptr || m_animation != nullptr; }
     
     // Optimization methods
     bool NeedsRepaint() const { return m_needsRepaint; }
     double GetTimeToNextFrame() const;
 
+    /**
+     * The previous content is still fading out
+     */
+    bool IsCrossfading() const;
+
+    /**
+     * Late frames of the video shown, 0 for other content
+     */
+    int GetLateFrameCount() const;
+
 private:
     static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
     bool RegisterWindowClass();
 
+    MediaLoader::Request MakeLoadRequest(const std::wstring& path) const;
+    LoadedMedia Install(LoadedMedia media); // Returns the content it replaces
+    void BindContent(); // Hand the current picture to the renderer
+    bool IsPlaylistActive() const;
+    void UpdatePendingLoad(double now);
+    void CancelLoad();
+    void UpdatePlaylist(double now);
+    void UpdateCrossfade(double now);
+    void SwitchTo(LoadedMedia media, double now);
+    void CancelPrefetch();
+    double GetItemDuration() const;
+
     HWND m_hwnd;
     HWND m_parent;
     MonitorInfo m_monitor;
     std::unique_ptr<RendererContext> m_renderer;
-    std::unique_ptr<VideoDecoder> m_videoDecoder;
+    std::shared_ptr<VideoDecoder> m_videoDecoder; // Shared with windows showing the same file
+    uint64_t m_frameSerial; // Decoder frame last drawn
+    FrameHandle m_presentedFrame; // Keeps the surface on screen from being reused by the decoder
+    std::shared_ptr<StillImage> m_image; // Converted once for this monitor, no decoder kept
+    std::shared_ptr<AnimatedImage> m_animation; // Played from memory, shared like decoders
+    std::wstring m_mediaPath;
+    int m_scalingMode;
+    bool m_imageStale; // Scaling mode changed since the image was converted
 
-    // Video playback timing
-    std::chrono::steady_clock::time_point m_lastFrameTime;
-    double m_frameInterval; // Time between frames in seconds
     bool m_needsRepaint;
+    DecoderOptions m_decoderOptions;
+
+    uint64_t m_loadTicket; // Background load replacing the content, 0 if none
+    std::wstring m_loadPath;
+    double m_loadStart;
+    std::wstring m_failedLoadPath; // Until TakeFailedLoad
+
+    Playlist m_playlist;
+    int m_playlistAdvance; // 0=Interval, 1=Loop end
+    double m_playlistInterval;
+    double m_advanceAt; // When the next item is due (PresentationClock time)
+    uint64_t m_prefetchTicket; // Background load of the next item, 0 if none
+    size_t m_failedItems; // Items in a row that failed to load
+
+    double m_crossfadeDuration;
+    double m_fadeStart;
+    double m_switchMs; // Main thread time of the last switch
 
     static const wchar_t* s_className;
     static bool s_classRegistered;
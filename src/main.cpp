@@ -1,10 +1,48 @@
 #include "Application.h"
 #include "core/Logger.h"
+#include "video/ClipConverter.h"
 
 #include <Windows.h>
+#include <shellapi.h>
+#include <cstdlib>
+#include <string>
 
 using namespace PixelMotion;
 
+/**
+ * Convert a video to a pre-converted clip without starting the app
+ * PixelMotion.exe --convert-clip <source> <clip> [width height [scaling mode]]
+ * The size defaults to the primary monitor's and the scaling mode to Fill
+ * @return true if the command line asked for a conversion
+ */
+static bool RunClipConversion(int* exitCode) {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) {
+        return false;
+    }
+
+    if (argc < 4 || std::wstring(argv[1]) != L"--convert-clip") {
+        LocalFree(argv);
+        return false;
+    }
+
+    std::wstring sourcePath = argv[2];
+    std::wstring clipPath = argv[3];
+    int width = (argc >= 6) ? _wtoi(argv[4]) : GetSystemMetrics(SM_CXSCREEN);
+    int height = (argc >= 6) ? _wtoi(argv[5]) : GetSystemMetrics(SM_CYSCREEN);
+    int scalingMode = (argc >= 7) ? _wtoi(argv[6]) : 0;
+    LocalFree(argv);
+
+    Logger::Initialize();
+    Logger::Info("=== Pixel Motion Clip Conversion ===");
+    bool converted = ClipConverter::Convert(sourcePath, clipPath, width, height, scalingMode);
+    Logger::Shutdown();
+
+    *exitCode = converted ? 0 : 1;
+    return true;
+}
+
 /**
  * Application entry point
  */
@@ -18,6 +56,12 @@ int WINAPI WinMain(
     UNREFERENCED_PARAMETER(lpCmdLine);
     UNREFERENCED_PARAMETER(nShowCmd);
 
+    // Conversion runs alongside a running instance, so it comes before the instance check
+    int conversionExitCode = 0;
+    if (RunClipConversion(&conversionExitCode)) {
+        return conversionExitCode;
+    }
+
     // Ensure single instance
     HANDLE hMutex = CreateMutex(nullptr, TRUE, L"PixelMotion_SingleInstance");
     if (GetLastError() == ERROR_ALREADY_EXISTS) {
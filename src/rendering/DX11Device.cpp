@@ -2,6 +2,7 @@
 #include "core/Logger.h"
 
 #include <dxgi1_2.h>
+#include <d3d11_4.h>
 
 namespace PixelMotion {
 
@@ -40,11 +41,26 @@ bool DX11Device::Initialize() {
         &m_context                  // Context output
     );
 
+    // Machines without a usable GPU driver (remote sessions, VMs) render in software
+    if (FAILED(hr)) {
+        Logger::Warning("No D3D11 hardware device, falling back to WARP");
+        hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, createDeviceFlags, featureLevels,
+                               ARRAYSIZE(featureLevels), D3D11_SDK_VERSION, &m_device, &m_featureLevel, &m_context);
+    }
+
     if (FAILED(hr)) {
         Logger::Error("Failed to create D3D11 device");
         return false;
     }
 
+    // Decoder threads share this device with the render loop
+    ComPtr<ID3D11Multithread> multithread;
+    if (SUCCEEDED(m_device.As(&multithread))) {
+        multithread->SetMultithreadProtected(TRUE);
+    } else {
+        Logger::Warning("Failed to enable D3D11 multithread protection");
+    }
+
     // Get DXGI factory
     ComPtr<IDXGIDevice> dxgiDevice;
     hr = m_device.As(&dxgiDevice);
@@ -21,6 +21,9 @@ RendererContext::RendererContext()
     , m_scalingMode(2) // Default to Stretch
     , m_videoWidth(0)
     , m_videoHeight(0)
+    , m_fadeWidth(0)
+    , m_fadeHeight(0)
+    , m_fadeAmount(0.0f)
     , m_initialized(false)
 {
 }
@@ -64,12 +67,17 @@ bool RendererContext::Initialize(HWND hwnd, int width, int height) {
         return false;
     }
 
-    // Create vertex buffer
-    if (!CreateVertexBuffer()) {
+    // Create vertex buffers
+    if (!CreateVertexBuffer(m_vertexBuffer) || !CreateVertexBuffer(m_fadeVertexBuffer)) {
         Logger::Error("Failed to create vertex buffer");
         return false;
     }
 
+    if (!CreateBlendState()) {
+        Logger::Error("Failed to create blend state");
+        return false;
+    }
+
     // Create sampler state
     D3D11_SAMPLER_DESC samplerDesc = {};
     samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -98,6 +106,10 @@ void RendererContext::Shutdown() {
     }
 
     m_samplerState.Reset();
+    m_fadeBlendState.Reset();
+    m_fadeSRV.Reset();
+    m_fadeTexture.Reset();
+    m_fadeVertexBuffer.Reset();
     m_videoSRV.Reset();
     m_videoTexture.Reset();
     m_vertexBuffer.Reset();
@@ -238,7 +250,7 @@ bool RendererContext::LoadShaders() {
     return SUCCEEDED(hr);
 }
 
-bool RendererContext::CreateVertexBuffer() {
+bool RendererContext::CreateVertexBuffer(ComPtr<ID3D11Buffer>& buffer) {
     // Fullscreen quad vertices (will be updated by UpdateVertexBuffer)
     Vertex vertices[] = {
         { { -1.0f,  1.0f, 0.0f }, { 0.0f, 0.0f } },  // Top-left
@@ -257,11 +269,28 @@ bool RendererContext::CreateVertexBuffer() {
     initData.pSysMem = vertices;
 
     HRESULT hr = DX11Device::GetInstance().GetDevice()->CreateBuffer(
-        &bufferDesc, &initData, &m_vertexBuffer);
+        &bufferDesc, &initData, &buffer);
 
     return SUCCEEDED(hr);
 }
 
+bool RendererContext::CreateBlendState() {
+    // result = source * factor + destination, so drawing the old and the new
+    // content with factors (1 - t) and t over black mixes them
+    D3D11_BLEND_DESC blendDesc = {};
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_BLEND_FACTOR;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_BLEND_FACTOR;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+    HRESULT hr = DX11Device::GetInstance().GetDevice()->CreateBlendState(&blendDesc, &m_fadeBlendState);
+    return SUCCEEDED(hr);
+}
+
 void RendererContext::Render() {
     if (!m_initialized) {
         return;
@@ -284,22 +313,45 @@ void RendererContext::Render() {
     viewport.MaxDepth = 1.0f;
     context->RSSetViewports(1, &viewport);
 
+    // Crossfade: two blended draws, no extra passes or CPU work
+    if (m_fadeSRV) {
+        float oldFactor[4] = { 1.0f - m_fadeAmount, 1.0f - m_fadeAmount, 1.0f - m_fadeAmount, 1.0f - m_fadeAmount };
+        float newFactor[4] = { m_fadeAmount, m_fadeAmount, m_fadeAmount, m_fadeAmount };
+
+        context->OMSetBlendState(m_fadeBlendState.Get(), oldFactor, 0xFFFFFFFF);
+        DrawQuad(m_fadeVertexBuffer.Get(), m_fadeSRV.Get());
+        if (m_videoSRV) {
+            context->OMSetBlendState(m_fadeBlendState.Get(), newFactor, 0xFFFFFFFF);
+            DrawQuad(m_vertexBuffer.Get(), m_videoSRV.Get());
+        }
+
+        // The context is shared with the other monitors
+        context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
+        return;
+    }
+
     // If we have a video texture, render it
     if (m_videoSRV) {
-        context->IASetInputLayout(m_inputLayout.Get());
-        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        
-        UINT stride = sizeof(Vertex);
-        UINT offset = 0;
-        context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+        DrawQuad(m_vertexBuffer.Get(), m_videoSRV.Get());
+    }
+}
+
+void RendererContext::DrawQuad(ID3D11Buffer* buffer, ID3D11ShaderResourceView* srv) {
+    auto* context = DX11Device::GetInstance().GetContext();
 
-        context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
-        context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
-        context->PSSetShaderResources(0, 1, m_videoSRV.GetAddressOf());
-        context->PSSetSamplers(0, 1, m_samplerState.GetAddressOf());
+    context->IASetInputLayout(m_inputLayout.Get());
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 
-        context->Draw(4, 0);
-    }
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+
+    context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+    context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+    context->PSSetShaderResources(0, 1, &srv);
+    context->PSSetSamplers(0, 1, m_samplerState.GetAddressOf());
+
+    context->Draw(4, 0);
 }
 
 void RendererContext::Present() {
@@ -518,22 +570,97 @@ ID3D11Device* RendererContext::GetDevice() {
     return DX11Device::GetInstance().GetDevice();
 }
 
+bool RendererContext::BeginCrossfade() {
+    if (!m_initialized || !m_videoTexture || m_videoWidth == 0 || m_videoHeight == 0) {
+        return false;
+    }
+
+    auto* device = DX11Device::GetInstance().GetDevice();
+    auto* context = DX11Device::GetInstance().GetContext();
+
+    // The texture on screen may be shared (decoder output, converted video
+    // shared by all monitors), so the picture is copied before it changes
+    D3D11_TEXTURE2D_DESC videoDesc;
+    m_videoTexture->GetDesc(&videoDesc);
+
+    m_fadeSRV.Reset();
+    m_fadeTexture.Reset();
+
+    D3D11_TEXTURE2D_DESC fadeDesc = {};
+    fadeDesc.Width = videoDesc.Width;
+    fadeDesc.Height = videoDesc.Height;
+    fadeDesc.MipLevels = 1;
+    fadeDesc.ArraySize = 1;
+    fadeDesc.Format = videoDesc.Format;
+    fadeDesc.SampleDesc.Count = 1;
+    fadeDesc.Usage = D3D11_USAGE_DEFAULT;
+    fadeDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    HRESULT hr = device->CreateTexture2D(&fadeDesc, nullptr, &m_fadeTexture);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create crossfade texture: " + std::to_string(hr));
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = fadeDesc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+
+    hr = device->CreateShaderResourceView(m_fadeTexture.Get(), &srvDesc, &m_fadeSRV);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create crossfade SRV: " + std::to_string(hr));
+        m_fadeTexture.Reset();
+        return false;
+    }
+
+    context->CopySubresourceRegion(m_fadeTexture.Get(), 0, 0, 0, 0, m_videoTexture.Get(), 0, nullptr);
+
+    m_fadeWidth = m_videoWidth;
+    m_fadeHeight = m_videoHeight;
+    WriteQuad(m_fadeVertexBuffer.Get(), m_fadeWidth, m_fadeHeight);
+    m_fadeAmount = 0.0f;
+    return true;
+}
+
+void RendererContext::SetCrossfade(float amount) {
+    if (amount >= 1.0f) {
+        // Done; the copy isn't kept between transitions
+        m_fadeSRV.Reset();
+        m_fadeTexture.Reset();
+        m_fadeAmount = 0.0f;
+        return;
+    }
+    m_fadeAmount = (amount > 0.0f) ? amount : 0.0f;
+}
+
 void RendererContext::SetScalingMode(int mode) {
     if (m_scalingMode != mode) {
         m_scalingMode = mode;
         if (m_videoWidth > 0 && m_videoHeight > 0) {
             UpdateVertexBuffer();
         }
+        if (m_fadeSRV) {
+            WriteQuad(m_fadeVertexBuffer.Get(), m_fadeWidth, m_fadeHeight);
+        }
     }
 }
 
 void RendererContext::UpdateVertexBuffer() {
-    if (!m_initialized || m_videoWidth == 0 || m_videoHeight == 0) {
+    if (m_videoWidth == 0 || m_videoHeight == 0) {
+        return;
+    }
+
+    WriteQuad(m_vertexBuffer.Get(), m_videoWidth, m_videoHeight);
+}
+
+void RendererContext::WriteQuad(ID3D11Buffer* buffer, int contentWidth, int contentHeight) {
+    if (!m_initialized || contentWidth == 0 || contentHeight == 0) {
         return;
     }
 
     float monitorAspect = static_cast<float>(m_width) / static_cast<float>(m_height);
-    float videoAspect = static_cast<float>(m_videoWidth) / static_cast<float>(m_videoHeight);
+    float videoAspect = static_cast<float>(contentWidth) / static_cast<float>(contentHeight);
 
     float quadLeft = -1.0f, quadRight = 1.0f;
     float quadTop = 1.0f, quadBottom = -1.0f;
@@ -575,8 +702,8 @@ void RendererContext::UpdateVertexBuffer() {
         }
 
         case 3: { // Center - original size, centered
-            float scaleX = static_cast<float>(m_videoWidth) / static_cast<float>(m_width);
-            float scaleY = static_cast<float>(m_videoHeight) / static_cast<float>(m_height);
+            float scaleX = static_cast<float>(contentWidth) / static_cast<float>(m_width);
+            float scaleY = static_cast<float>(contentHeight) / static_cast<float>(m_height);
             quadLeft = -scaleX;
             quadRight = scaleX;
             quadTop = scaleY;
@@ -595,12 +722,12 @@ void RendererContext::UpdateVertexBuffer() {
 
     // Update vertex buffer
     auto* context = DX11Device::GetInstance().GetContext();
-    if (context && m_vertexBuffer) {
+    if (context && buffer) {
         D3D11_MAPPED_SUBRESOURCE mapped;
-        HRESULT hr = context->Map(m_vertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+        HRESULT hr = context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
         if (SUCCEEDED(hr)) {
             memcpy(mapped.pData, vertices, sizeof(vertices));
-            context->Unmap(m_vertexBuffer.Get(), 0);
+            context->Unmap(buffer, 0);
         }
     }
 }
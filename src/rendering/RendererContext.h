@@ -31,12 +31,29 @@ public:
     void SetScalingMode(int mode); // 0=Fill, 1=Fit, 2=Stretch, 3=Center
     ID3D11Device* GetDevice();
 
+    /**
+     * Keep a copy of the current content to fade out from
+     * Call while the outgoing content is still set; the copy is made on the
+     * GPU, and both pictures are blended by the output merger while drawing
+     * @return false if there is nothing on screen to fade from
+     */
+    bool BeginCrossfade();
+
+    /**
+     * Progress of the crossfade from 0 (old content) to 1, which ends it
+     */
+    void SetCrossfade(float amount);
+    bool IsCrossfading() const { return m_fadeSRV.Get() != nullptr; }
+
 private:
     bool CreateSwapChain(HWND hwnd, int width, int height);
     bool CreateRenderTarget();
     bool LoadShaders();
-    bool CreateVertexBuffer();
+    bool CreateVertexBuffer(ComPtr<ID3D11Buffer>& buffer);
+    bool CreateBlendState();
     void UpdateVertexBuffer(); // Recalculate vertices based on scaling mode
+    void WriteQuad(ID3D11Buffer* buffer, int contentWidth, int contentHeight);
+    void DrawQuad(ID3D11Buffer* buffer, ID3D11ShaderResourceView* srv);
 
     HWND m_hwnd;
     int m_width;
@@ -58,6 +75,15 @@ private:
     int m_videoWidth;
     int m_videoHeight;
 
+    // Outgoing content during a crossfade, drawn with its own quad
+    ComPtr<ID3D11Texture2D> m_fadeTexture;
+    ComPtr<ID3D11ShaderResourceView> m_fadeSRV;
+    ComPtr<ID3D11Buffer> m_fadeVertexBuffer;
+    ComPtr<ID3D11BlendState> m_fadeBlendState; // Adds source * blend factor
+    int m_fadeWidth;
+    int m_fadeHeight;
+    float m_fadeAmount;
+
     bool m_initialized;
 };
 
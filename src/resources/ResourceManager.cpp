@@ -8,6 +8,7 @@ namespace PixelMotion {
 ResourceManager::ResourceManager()
     : m_paused(false)
     , m_manualPause(false)
+    , m_lowBattery(false)
     , m_fpsMultiplier(1.0f)
     , m_initialized(false)
 {
@@ -49,6 +50,10 @@ void ResourceManager::SetProcessBlocklist(const std::vector<std::string>& list)
     }
 }
 
+bool ResourceManager::IsOnBattery() const {
+    return m_batteryMonitor ? m_batteryMonitor->IsOnBattery() : false;
+}
+
 void ResourceManager::Shutdown() {
     if (!m_initialized) {
         return;
@@ -101,12 +106,15 @@ void ResourceManager::UpdatePauseState() {
         m_paused = false;
         
         int batteryPercent = m_batteryMonitor->GetBatteryPercent();
-        if (batteryPercent < 20) {
-            m_fpsMultiplier = 0.0f; // Pause completely
-            m_paused = true;
+        bool wasLowBattery = m_lowBattery;
+        m_lowBattery = batteryPercent < 20;
+
+        if (m_lowBattery) {
+            // Not paused: wallpapers show keyframes only (each held for its GOP) at the reduced battery rate
+            m_fpsMultiplier = 0.25f;
             
-            if (!wasPaused) {
-                Logger::Info("Low battery - pausing wallpapers");
+            if (!wasLowBattery) {
+                Logger::Info("Low battery - showing keyframes only");
             }
         } else if (batteryPercent < 50) {
             m_fpsMultiplier = 0.25f; // 15 FPS
@@ -124,6 +132,7 @@ void ResourceManager::UpdatePauseState() {
     } else {
         // On AC power - full speed
         m_paused = false;
+        m_lowBattery = false;
         m_fpsMultiplier = 1.0f;
         
         if (wasPaused) {
@@ -32,6 +32,9 @@ public:
     void SetPaused(bool paused) { m_manualPause = paused; }
     float GetFPSMultiplier() const { return m_fpsMultiplier; }
 
+    bool IsOnBattery() const;
+    bool IsLowBattery() const { return m_lowBattery; } // Wallpapers fall back to keyframes only
+
 private:
     void UpdatePauseState();
 
@@ -40,6 +43,7 @@ private:
 
     bool m_paused;
     bool m_manualPause;
+    bool m_lowBattery;
     bool m_pauseOnBattery = true;
     bool m_pauseOnFullscreen = true;
     
@@ -738,8 +738,12 @@ void SettingsWindow::ApplySettings() {
     
     // Apply to desktop manager
     if (m_desktopManager && wcslen(wPath) > 0) {
-        m_desktopManager->SetWallpaper(m_selectedMonitorIndex, wPath);
-        Logger::Info("Wallpaper applied to monitor");
+        // Applied once loaded; Application reports a load that fails
+        if (m_desktopManager->BeginSetWallpaper(m_selectedMonitorIndex, wPath)) {
+            Logger::Info("Wallpaper loading for monitor " + std::to_string(m_selectedMonitorIndex));
+        } else {
+            Logger::Error("Could not start loading the wallpaper");
+        }
     }
 }
 
@@ -752,7 +756,7 @@ std::wstring SettingsWindow::OpenFileDialog() {
     ofn.hwndOwner = m_hwnd; // Modal to settings window
     ofn.lpstrFile = szFile;
     ofn.nMaxFile = sizeof(szFile);
-    ofn.lpstrFilter = L"Media Files\0*.mp4;*.mkv;*.avi;*.mov;*.wmv;*.jpg;*.jpeg;*.png;*.bmp\0All Files\0*.*\0";
+    ofn.lpstrFilter = L"Media Files\0*.mp4;*.mkv;*.avi;*.mov;*.wmv;*.pmclip;*.jpg;*.jpeg;*.png;*.bmp;*.gif;*.apng;*.webp\0All Files\0*.*\0";
     ofn.nFilterIndex = 1;
     ofn.lpstrFileTitle = nullptr;
     ofn.nMaxFileTitle = 0;
@@ -177,8 +177,8 @@ void TrayIcon::UpdateIcon() {
 
 void TrayIcon::ShowNotification(const std::wstring& title, const std::wstring& message) {
     m_nid.uFlags = NIF_INFO;
-    wcscpy_s(m_nid.szInfoTitle, ARRAYSIZE(m_nid.szInfoTitle), title.c_str());
-    wcscpy_s(m_nid.szInfo, ARRAYSIZE(m_nid.szInfo), message.c_str());
+    wcsncpy_s(m_nid.szInfoTitle, ARRAYSIZE(m_nid.szInfoTitle), title.c_str(), _TRUNCATE);
+    wcsncpy_s(m_nid.szInfo, ARRAYSIZE(m_nid.szInfo), message.c_str(), _TRUNCATE); // File names can be long
     m_nid.dwInfoFlags = NIIF_INFO;
 
     Shell_NotifyIcon(NIM_MODIFY, &m_nid);
@@ -0,0 +1,259 @@
+#include "AnimatedImage.h"
+#include "VideoDecoder.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+
+// Shorter delays the demuxer let through are played at 100 ms, as browsers do
+constexpr int64_t MIN_FRAME_DELAY = 20000;
+constexpr int64_t DEFAULT_FRAME_DELAY = 100000;
+
+// Frames past this much stored pixel data are dropped; the animation loops early
+constexpr size_t MAX_STORE_BYTES = 256 * 1024 * 1024;
+
+AnimatedImage::AnimatedImage(int width, int height)
+    : m_width(width)
+    , m_height(height)
+    , m_loopDuration(0)
+    , m_currentFrame(0)
+    , m_frameSerial(0)
+{
+}
+
+std::shared_ptr<AnimatedImage> AnimatedImage::Decode(VideoDecoder& decoder, ID3D11Device* device) {
+    const AVFrame* frame = decoder.GetCurrentFrame();
+    if (!frame || !frame->data[0] || !device) {
+        return nullptr;
+    }
+
+    std::shared_ptr<AnimatedImage> image(new AnimatedImage(frame->width, frame->height));
+    int width = frame->width;
+    int height = frame->height;
+    size_t frameBytes = static_cast<size_t>(width) * height * 4;
+
+    // Frames are compared after conversion to BGRA, so each delta is exact
+    std::vector<uint8_t> first(frameBytes);
+    std::vector<uint8_t> previous(frameBytes);
+    std::vector<uint8_t> current(frameBytes);
+    SwsContext* swsContext = nullptr;
+    bool truncated = false;
+
+    do {
+        frame = decoder.GetCurrentFrame();
+        if (frame->width != width || frame->height != height) {
+            Logger::Warning("Animated image changed size mid-stream, ignoring remaining frames");
+            break;
+        }
+
+        swsContext = sws_getCachedContext(
+            swsContext,
+            width, height, static_cast<AVPixelFormat>(frame->format),
+            width, height, AV_PIX_FMT_BGRA,
+            SWS_POINT, nullptr, nullptr, nullptr
+        );
+        if (!swsContext) {
+            Logger::Error("Failed to create swscale context for animated image");
+            break;
+        }
+
+        uint8_t* dstData[1] = { current.data() };
+        int dstLinesize[1] = { width * 4 };
+        sws_scale(swsContext, frame->data, frame->linesize, 0, height, dstData, dstLinesize);
+
+        Frame stored;
+        if (image->m_frames.empty()) {
+            // Frame 0 is stored as the change from the last frame once that is known
+            first = current;
+        } else {
+            stored = image->StoreDelta(current.data(), previous.data());
+        }
+        stored.duration = (frame->duration >= MIN_FRAME_DELAY) ? frame->duration : DEFAULT_FRAME_DELAY;
+        image->m_frames.push_back(stored);
+
+        std::swap(previous, current);
+
+        if (image->m_pixels.size() > MAX_STORE_BYTES) {
+            truncated = true;
+            break;
+        }
+    } while (decoder.DecodeNextFrame());
+
+    sws_freeContext(swsContext);
+
+    if (image->m_frames.empty()) {
+        return nullptr;
+    }
+
+    // Looping back to frame 0 is a delta from the last frame like any other
+    Frame& wrap = image->m_frames.front();
+    int64_t firstDuration = wrap.duration;
+    wrap = image->StoreDelta(first.data(), previous.data());
+    wrap.duration = firstDuration;
+
+    for (auto& stored : image->m_frames) {
+        stored.start = image->m_loopDuration;
+        image->m_loopDuration += stored.duration;
+    }
+
+    if (!image->CreateTexture(device, first.data())) {
+        return nullptr;
+    }
+
+    Logger::Info("Animated image decoded: " + std::to_string(image->GetFrameCount()) + " frames, " +
+                 std::to_string(image->m_loopDuration / 1000) + " ms loop, " +
+                 std::to_string(image->m_pixels.size() / 1024) + " KB of changed pixels (" +
+                 std::to_string(frameBytes * image->m_frames.size() / 1024) + " KB as full frames)" +
+                 (truncated ? ", truncated to fit the store" : ""));
+    return image;
+}
+
+AnimatedImage::Frame AnimatedImage::StoreDelta(const uint8_t* pixels, const uint8_t* previous) {
+    Frame delta;
+    size_t stride = static_cast<size_t>(m_width) * 4;
+
+    // Bounding box of the pixels that changed
+    int top = m_height;
+    int bottom = -1;
+    int left = m_width;
+    int right = -1;
+    for (int y = 0; y < m_height; y++) {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(pixels + y * stride);
+        const uint32_t* previousRow = reinterpret_cast<const uint32_t*>(previous + y * stride);
+        if (std::memcmp(row, previousRow, stride) == 0) {
+            continue;
+        }
+
+        top = std::min(top, y);
+        bottom = y;
+
+        int x = 0;
+        while (row[x] == previousRow[x]) {
+            x++;
+        }
+        left = std::min(left, x);
+
+        x = m_width - 1;
+        while (row[x] == previousRow[x]) {
+            x--;
+        }
+        right = std::max(right, x);
+    }
+
+    if (bottom < 0) {
+        return delta; // Identical frames only extend the display time
+    }
+
+    delta.x = left;
+    delta.y = top;
+    delta.width = right - left + 1;
+    delta.height = bottom - top + 1;
+    delta.offset = m_pixels.size();
+
+    size_t rowBytes = static_cast<size_t>(delta.width) * 4;
+    m_pixels.resize(m_pixels.size() + rowBytes * delta.height);
+    uint8_t* dst = m_pixels.data() + delta.offset;
+    for (int y = top; y <= bottom; y++) {
+        std::memcpy(dst, pixels + y * stride + left * 4, rowBytes);
+        dst += rowBytes;
+    }
+
+    return delta;
+}
+
+bool AnimatedImage::CreateTexture(ID3D11Device* device, const uint8_t* firstFrame) {
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width = m_width;
+    texDesc.Height = m_height;
+    texDesc.MipLevels = 1;
+    texDesc.ArraySize = 1;
+    texDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Usage = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = firstFrame;
+    initData.SysMemPitch = m_width * 4;
+
+    HRESULT hr = device->CreateTexture2D(&texDesc, &initData, &m_texture);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create animated image texture: " + std::to_string(hr));
+        return false;
+    }
+
+    device->GetImmediateContext(&m_context);
+    return true;
+}
+
+void AnimatedImage::ApplyFrame(int index) {
+    const Frame& frame = m_frames[index];
+    if (frame.width == 0) {
+        return;
+    }
+
+    D3D11_BOX box = {};
+    box.left = frame.x;
+    box.top = frame.y;
+    box.right = frame.x + frame.width;
+    box.bottom = frame.y + frame.height;
+    box.front = 0;
+    box.back = 1;
+    m_context->UpdateSubresource(m_texture.Get(), 0, &box, m_pixels.data() + frame.offset, frame.width * 4, 0);
+}
+
+int AnimatedImage::FindFrame(int64_t position) const {
+    auto it = std::upper_bound(m_frames.begin(), m_frames.end(), position,
+                               [](int64_t value, const Frame& frame) { return value < frame.start; });
+    return static_cast<int>(it - m_frames.begin()) - 1;
+}
+
+bool AnimatedImage::UpdatePlayback(double now) {
+    if (m_frames.size() < 2) {
+        return false;
+    }
+
+    if (!m_clock.IsStarted()) {
+        // Frame 0 is in the texture as of now
+        m_clock.Start(now, 0.0);
+        return false;
+    }
+
+    int64_t position = static_cast<int64_t>(m_clock.GetStreamTime(now) * 1000000.0) % m_loopDuration;
+    int target = FindFrame(std::max<int64_t>(position, 0));
+    if (target == m_currentFrame) {
+        return false;
+    }
+
+    // Deltas build on each other, so skipped frames are still applied in order
+    while (m_currentFrame != target) {
+        m_currentFrame = (m_currentFrame + 1) % GetFrameCount();
+        ApplyFrame(m_currentFrame);
+    }
+
+    m_frameSerial++;
+    return true;
+}
+
+double AnimatedImage::GetTimeToNextFrame(double now) const {
+    if (m_frames.size() < 2) {
+        return 1.0; // Static content, check infrequently
+    }
+
+    if (!m_clock.IsStarted()) {
+        return 0.0;
+    }
+
+    int64_t position = std::max<int64_t>(static_cast<int64_t>(m_clock.GetStreamTime(now) * 1000000.0) % m_loopDuration, 0);
+    const Frame& frame = m_frames[FindFrame(position)];
+    return static_cast<double>(frame.start + frame.duration - position) / 1000000.0;
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PresentationClock.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace PixelMotion {
+
+class VideoDecoder;
+
+/**
+ * Animated GIF/APNG/WebP played from memory
+ * Every frame is decoded once and stored as the rectangle that changed since
+ * the previous frame, so playback only copies small regions into a texture
+ * and never runs the decoder again
+ */
+class AnimatedImage {
+public:
+    /**
+     * Decode all remaining frames of an animation (the decoder's current frame first)
+     * @return nullptr if no frame could be decoded or the texture can't be created
+     */
+    static std::shared_ptr<AnimatedImage> Decode(VideoDecoder& decoder, ID3D11Device* device);
+
+    /**
+     * Advance playback to the given time (main thread only)
+     * Safe to call once per consumer per tick when the animation is shared
+     * @return true if a new frame became current
+     */
+    bool UpdatePlayback(double now);
+    double GetTimeToNextFrame(double now) const;
+    uint64_t GetFrameSerial() const { return m_frameSerial; }
+
+    ID3D11Texture2D* GetTexture() const { return m_texture.Get(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetFrameCount() const { return static_cast<int>(m_frames.size()); }
+    int64_t GetFrameStart(int index) const { return m_frames[index].start; } // Microseconds
+    int64_t GetFrameDuration(int index) const { return m_frames[index].duration; }
+    int64_t GetLoopDuration() const { return m_loopDuration; }
+    size_t GetStoreBytes() const { return m_pixels.size(); }
+
+private:
+    // Region that differs from the previous frame (the last one, for frame 0)
+    struct Frame {
+        int x = 0;
+        int y = 0;
+        int width = 0;  // 0 if identical to the previous frame
+        int height = 0;
+        size_t offset = 0; // BGRA rows of the region in m_pixels
+        int64_t start = 0;
+        int64_t duration = 0;
+    };
+
+    AnimatedImage(int width, int height);
+
+    Frame StoreDelta(const uint8_t* pixels, const uint8_t* previous);
+    bool CreateTexture(ID3D11Device* device, const uint8_t* firstFrame);
+    void ApplyFrame(int index);
+    int FindFrame(int64_t position) const;
+
+    int m_width;
+    int m_height;
+    std::vector<Frame> m_frames;
+    std::vector<uint8_t> m_pixels;
+    int64_t m_loopDuration;
+
+    ComPtr<ID3D11Texture2D> m_texture;
+    ComPtr<ID3D11DeviceContext> m_context;
+    PresentationClock m_clock;
+    int m_currentFrame;
+    uint64_t m_frameSerial;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,256 @@
+#include "ClipConverter.h"
+#include "ClipFormat.h"
+#include "OutputLayout.h"
+#include "PresentationClock.h"
+#include "core/Logger.h"
+#include "core/TextEncoding.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <lz4hc.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+
+/**
+ * FFmpeg objects of one conversion, freed together
+ */
+struct ClipContext {
+    AVFormatContext* input = nullptr;
+    AVCodecContext* decoder = nullptr;
+    SwsContext* scaler = nullptr;
+    AVFrame* decoded = nullptr;
+    AVFrame* scaled = nullptr;
+    AVPacket* packet = nullptr;
+    int streamIndex = -1;
+
+    ~ClipContext() {
+        av_packet_free(&packet);
+        av_frame_free(&scaled);
+        av_frame_free(&decoded);
+        sws_freeContext(scaler);
+        avcodec_free_context(&decoder);
+        avformat_close_input(&input);
+    }
+
+    /**
+     * Open the best video stream's decoder on an opened input
+     * @param threads Decoder threads, 0 lets FFmpeg choose
+     */
+    bool OpenDecoder(int threads) {
+        if (avformat_find_stream_info(input, nullptr) < 0) {
+            return false;
+        }
+
+        const AVCodec* codec = nullptr;
+        streamIndex = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+        if (streamIndex < 0 || !codec) {
+            return false;
+        }
+
+        decoder = avcodec_alloc_context3(codec);
+        decoded = av_frame_alloc();
+        packet = av_packet_alloc();
+        if (!decoder || !decoded || !packet ||
+            avcodec_parameters_to_context(decoder, input->streams[streamIndex]->codecpar) < 0) {
+            return false;
+        }
+        decoder->thread_count = threads;
+        return avcodec_open2(decoder, codec, nullptr) >= 0;
+    }
+};
+
+bool ClipConverter::Convert(const std::wstring& sourcePath, const std::wstring& clipPath,
+                            int targetWidth, int targetHeight, int scalingMode) {
+    std::string sourceUtf8 = ToUtf8(sourcePath);
+    double startTime = PresentationClock::Now();
+
+    ClipContext ctx;
+    if (avformat_open_input(&ctx.input, sourceUtf8.c_str(), nullptr, nullptr) < 0 || !ctx.OpenDecoder(0)) {
+        Logger::Error("Clip: could not open " + sourceUtf8);
+        return false;
+    }
+
+    const AVCodecParameters* params = ctx.input->streams[ctx.streamIndex]->codecpar;
+    if (params->width <= 0 || params->height <= 0) {
+        Logger::Error("Clip: " + sourceUtf8 + " has no frame size");
+        return false;
+    }
+
+    // 4:2:0 needs even dimensions
+    OutputLayout layout = OutputLayout::Compute(params->width, params->height, targetWidth, targetHeight, scalingMode, true);
+    int width = std::max(2, layout.width & ~1);
+    int height = std::max(2, layout.height & ~1);
+
+    // Keep the source's matrix and range; untagged sources get the one playback would assume for them
+    AVColorSpace colorSpace = params->color_space;
+    if (colorSpace != AVCOL_SPC_BT709 && colorSpace != AVCOL_SPC_BT470BG && colorSpace != AVCOL_SPC_SMPTE170M) {
+        colorSpace = (params->height >= 720) ? AVCOL_SPC_BT709 : AVCOL_SPC_SMPTE170M;
+    }
+    bool fullRange = params->color_range == AVCOL_RANGE_JPEG || params->format == AV_PIX_FMT_YUVJ420P;
+    const int* coefficients = sws_getCoefficients(colorSpace == AVCOL_SPC_BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+
+    AVStream* stream = ctx.input->streams[ctx.streamIndex];
+    AVRational frameRate = stream->avg_frame_rate;
+    if (frameRate.num <= 0 || frameRate.den <= 0) {
+        frameRate = stream->r_frame_rate;
+    }
+    if (frameRate.num <= 0 || frameRate.den <= 0) {
+        frameRate = AVRational{ 30, 1 };
+    }
+
+    int frameSize = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, width, height, 1);
+    ctx.scaled = av_frame_alloc();
+    if (frameSize <= 0 || !ctx.scaled) {
+        return false;
+    }
+    ctx.scaled->format = AV_PIX_FMT_YUV420P;
+    ctx.scaled->width = width;
+    ctx.scaled->height = height;
+    if (av_frame_get_buffer(ctx.scaled, 0) < 0) {
+        return false;
+    }
+
+    std::vector<uint8_t> frame(frameSize);
+    std::vector<uint8_t> compressed(LZ4_compressBound(frameSize));
+    std::vector<ClipFrameEntry> index;
+
+    // Written under a temporary name and renamed once complete
+    std::filesystem::path partPath = clipPath;
+    partPath += L".part";
+    std::ofstream file(partPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Logger::Error("Clip: could not create " + ToUtf8(partPath.wstring()));
+        return false;
+    }
+
+    ClipFileHeader header = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Filled in at the end
+    uint64_t offset = sizeof(header);
+    bool failed = false;
+
+    auto writeFrame = [&]() {
+        // Crop to what the monitor shows, so the clip is exactly the visible picture
+        OutputLayout frameLayout = OutputLayout::Compute(ctx.decoded->width, ctx.decoded->height,
+                                                         targetWidth, targetHeight, scalingMode, true);
+        ctx.decoded->crop_left = frameLayout.cropX & ~1;
+        ctx.decoded->crop_top = frameLayout.cropY & ~1;
+        ctx.decoded->crop_right = ctx.decoded->width - ctx.decoded->crop_left - frameLayout.cropWidth;
+        ctx.decoded->crop_bottom = ctx.decoded->height - ctx.decoded->crop_top - frameLayout.cropHeight;
+        if (av_frame_apply_cropping(ctx.decoded, AV_FRAME_CROP_UNALIGNED) < 0) {
+            failed = true;
+            return;
+        }
+
+        SwsContext* scaler = sws_getCachedContext(ctx.scaler,
+                                                  ctx.decoded->width, ctx.decoded->height,
+                                                  static_cast<AVPixelFormat>(ctx.decoded->format),
+                                                  width, height, AV_PIX_FMT_YUV420P,
+                                                  SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (!scaler) {
+            failed = true;
+            return;
+        }
+        if (scaler != ctx.scaler) {
+            sws_setColorspaceDetails(scaler, coefficients, fullRange, coefficients, fullRange, 0, 1 << 16, 1 << 16);
+            ctx.scaler = scaler;
+        }
+
+        sws_scale(ctx.scaler, ctx.decoded->data, ctx.decoded->linesize, 0, ctx.decoded->height,
+                  ctx.scaled->data, ctx.scaled->linesize);
+        av_image_copy_to_buffer(frame.data(), frameSize, ctx.scaled->data, ctx.scaled->linesize,
+                                AV_PIX_FMT_YUV420P, width, height, 1);
+
+        // Converting is done once, so spend the time on the high-compression
+        // mode; decompression runs at the same speed either way
+        int compressedSize = LZ4_compress_HC(reinterpret_cast<const char*>(frame.data()),
+                                             reinterpret_cast<char*>(compressed.data()),
+                                             frameSize, static_cast<int>(compressed.size()), LZ4HC_CLEVEL_DEFAULT);
+        ClipFrameEntry entry = {};
+        entry.offset = offset;
+        if (compressedSize > 0 && compressedSize < frameSize) {
+            entry.compressedSize = static_cast<uint32_t>(compressedSize);
+            file.write(reinterpret_cast<const char*>(compressed.data()), compressedSize);
+        } else {
+            entry.compressedSize = static_cast<uint32_t>(frameSize);
+            file.write(reinterpret_cast<const char*>(frame.data()), frameSize);
+        }
+        offset += entry.compressedSize;
+        index.push_back(entry);
+    };
+
+    auto decode = [&](const AVPacket* packet) {
+        if (avcodec_send_packet(ctx.decoder, packet) < 0 && packet) {
+            return; // Damaged packets are skipped like during playback
+        }
+        while (!failed && avcodec_receive_frame(ctx.decoder, ctx.decoded) >= 0) {
+            writeFrame();
+            av_frame_unref(ctx.decoded);
+        }
+    };
+
+    while (!failed && av_read_frame(ctx.input, ctx.packet) >= 0) {
+        if (ctx.packet->stream_index == ctx.streamIndex) {
+            decode(ctx.packet);
+        }
+        av_packet_unref(ctx.packet);
+    }
+    if (!failed) {
+        decode(nullptr);
+    }
+
+    // Index after the frames, 8-byte aligned
+    uint64_t padding = (8 - offset % 8) % 8;
+    const char zeros[8] = {};
+    file.write(zeros, static_cast<std::streamsize>(padding));
+
+    header.magic = CLIP_FILE_MAGIC;
+    header.version = CLIP_FILE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.frameRateNum = frameRate.num;
+    header.frameRateDen = frameRate.den;
+    header.colorSpace = colorSpace;
+    header.colorRange = fullRange ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+    header.frameCount = static_cast<uint32_t>(index.size());
+    header.frameSize = static_cast<uint64_t>(frameSize);
+    header.indexOffset = offset + padding;
+
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(ClipFrameEntry)));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    std::error_code ec;
+    if (failed || index.empty() || !file) {
+        std::filesystem::remove(partPath, ec);
+        Logger::Error("Clip: converting " + sourceUtf8 + " failed");
+        return false;
+    }
+
+    std::filesystem::rename(partPath, clipPath, ec);
+    if (ec) {
+        std::filesystem::remove(partPath, ec);
+        Logger::Error("Clip: could not write " + ToUtf8(clipPath));
+        return false;
+    }
+
+    uint64_t rawBytes = header.frameSize * header.frameCount;
+    Logger::Info("Clip: converted " + sourceUtf8 + " to " + std::to_string(width) + "x" + std::to_string(height) +
+                 ", " + std::to_string(index.size()) + " frames, " + std::to_string(offset / (1024 * 1024)) + " MB (" +
+                 std::to_string(offset * 100 / std::max<uint64_t>(1, rawBytes)) + "% of raw) in " +
+                 std::to_string(PresentationClock::Now() - startTime) + " s");
+    return true;
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace PixelMotion {
+
+/**
+ * Converts videos into pre-converted clips (see ClipFormat.h)
+ * Frames are cropped and scaled the way a monitor shows them (OutputLayout),
+ * so the clip plays on that monitor without scaling. Sources are read at
+ * their frame rate as a constant-rate sequence of frames
+ */
+class ClipConverter {
+public:
+    /**
+     * Convert any FFmpeg-readable video
+     * @param scalingMode 0=Fill, 1=Fit, 2=Stretch, 3=Center
+     */
+    static bool Convert(const std::wstring& sourcePath, const std::wstring& clipPath,
+                        int targetWidth, int targetHeight, int scalingMode);
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PixelMotion {
+
+/**
+ * Pre-converted clip file (.pmclip)
+ *
+ * Header, then every frame as one LZ4 block, then the frame index. Frames
+ * are YUV 4:2:0 with the Y, U and V planes packed back to back without row
+ * padding (FFmpeg's rawvideo layout), already cropped and scaled to the
+ * size they are shown at, so playback only decompresses and converts.
+ * All fields are little-endian
+ */
+constexpr uint32_t CLIP_FILE_MAGIC = 0x4C434D50; // "PMCL"
+constexpr uint32_t CLIP_FILE_VERSION = 1;
+constexpr wchar_t CLIP_FILE_EXTENSION[] = L".pmclip";
+
+struct ClipFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t frameRateNum;
+    int32_t frameRateDen;
+    int32_t colorSpace; // AVColorSpace of the stored samples
+    int32_t colorRange; // AVColorRange of the stored samples
+    uint32_t frameCount;
+    uint32_t reserved;
+    uint64_t frameSize;   // Decompressed bytes per frame
+    uint64_t indexOffset; // ClipFrameEntry[frameCount]
+};
+
+struct ClipFrameEntry {
+    uint64_t offset;
+    uint32_t compressedSize; // Equal to frameSize when the frame is stored uncompressed
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ClipFileHeader) == 56, "Clip header layout is part of the file format");
+static_assert(sizeof(ClipFrameEntry) == 16, "Clip index layout is part of the file format");
+
+} // namespace PixelMotion
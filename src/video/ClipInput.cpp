@@ -0,0 +1,235 @@
+#include "ClipInput.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+
+#include <lz4.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mem.h>
+}
+
+namespace PixelMotion {
+
+// Smaller than any frame, so whole-frame reads bypass the buffer
+constexpr int IO_BUFFER_SIZE = 4096;
+
+ClipInput::ClipInput()
+    : m_header{}
+    , m_size(0)
+    , m_position(0)
+    , m_partialFrameIndex(-1)
+    , m_ioContext(nullptr)
+{
+}
+
+ClipInput::~ClipInput() {
+    Close();
+}
+
+bool ClipInput::IsClip(const std::wstring& filePath) {
+    std::wstring extension = std::filesystem::path(filePath).extension().wstring();
+    for (auto& c : extension) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+    return extension == CLIP_FILE_EXTENSION;
+}
+
+bool ClipInput::Open(const std::wstring& filePath, size_t preloadLimit) {
+    Close();
+
+    // Frames are decompressed from wherever the index points, not streamed
+    if (!m_file.Map(filePath, preloadLimit)) {
+        return false;
+    }
+
+    const uint8_t* data = m_file.GetData();
+    uint64_t fileSize = static_cast<uint64_t>(m_file.GetSize());
+    if (fileSize < sizeof(ClipFileHeader)) {
+        Logger::Error("Clip file is truncated");
+        Close();
+        return false;
+    }
+    std::memcpy(&m_header, data, sizeof(m_header));
+
+    // Frames must be what the rawvideo demuxer will cut the stream into
+    int expectedSize = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, m_header.width, m_header.height, 1);
+    if (m_header.magic != CLIP_FILE_MAGIC || m_header.version != CLIP_FILE_VERSION ||
+        m_header.width <= 0 || m_header.height <= 0 || m_header.frameCount == 0 ||
+        m_header.frameRateNum <= 0 || m_header.frameRateDen <= 0 ||
+        expectedSize <= 0 || m_header.frameSize != static_cast<uint64_t>(expectedSize)) {
+        Logger::Error("Not a supported clip file");
+        Close();
+        return false;
+    }
+
+    uint64_t indexSize = static_cast<uint64_t>(m_header.frameCount) * sizeof(ClipFrameEntry);
+    if (m_header.indexOffset > fileSize || indexSize > fileSize - m_header.indexOffset) {
+        Logger::Error("Clip index is truncated");
+        Close();
+        return false;
+    }
+
+    m_index.resize(m_header.frameCount);
+    std::memcpy(m_index.data(), data + m_header.indexOffset, indexSize);
+    for (const ClipFrameEntry& entry : m_index) {
+        if (entry.offset > fileSize || entry.compressedSize > fileSize - entry.offset ||
+            entry.compressedSize > m_header.frameSize) {
+            Logger::Error("Clip index points outside the file");
+            Close();
+            return false;
+        }
+    }
+    m_size = static_cast<int64_t>(m_header.frameSize) * m_header.frameCount;
+
+    uint8_t* ioBuffer = static_cast<uint8_t*>(av_malloc(IO_BUFFER_SIZE));
+    if (!ioBuffer) {
+        Close();
+        return false;
+    }
+
+    m_ioContext = avio_alloc_context(ioBuffer, IO_BUFFER_SIZE, 0, this, ReadPacket, nullptr, Seek);
+    if (!m_ioContext) {
+        av_free(ioBuffer);
+        Close();
+        return false;
+    }
+
+    Logger::Info("Opened clip: " + std::to_string(m_header.width) + "x" + std::to_string(m_header.height) + ", " +
+                 std::to_string(m_header.frameCount) + " frames, " + std::to_string(fileSize / 1024) + " KB for " +
+                 std::to_string(m_size / 1024) + " KB of frames");
+    return true;
+}
+
+void ClipInput::Close() {
+    if (m_ioContext) {
+        // The context may have replaced the buffer it was given
+        av_freep(&m_ioContext->buffer);
+        avio_context_free(&m_ioContext);
+    }
+
+    m_file.Close();
+    m_index.clear();
+    m_partialFrame.clear();
+    m_partialFrame.shrink_to_fit();
+    m_partialFrameIndex = -1;
+    m_header = {};
+    m_size = 0;
+    m_position = 0;
+}
+
+void ClipInput::GetDemuxerOptions(AVDictionary** options) const {
+    std::string size = std::to_string(m_header.width) + "x" + std::to_string(m_header.height);
+    std::string rate = std::to_string(m_header.frameRateNum) + "/" + std::to_string(m_header.frameRateDen);
+    av_dict_set(options, "video_size", size.c_str(), 0);
+    av_dict_set(options, "pixel_format", "yuv420p", 0);
+    av_dict_set(options, "framerate", rate.c_str(), 0);
+}
+
+void ClipInput::ApplyStreamInfo(AVFormatContext* formatContext) const {
+    if (!formatContext || formatContext->nb_streams == 0) {
+        return;
+    }
+
+    // Timestamps are frame numbers (time base 1/frame rate)
+    AVStream* stream = formatContext->streams[0];
+    stream->codecpar->color_space = static_cast<AVColorSpace>(m_header.colorSpace);
+    stream->codecpar->color_range = static_cast<AVColorRange>(m_header.colorRange);
+    stream->duration = m_header.frameCount;
+    stream->nb_frames = m_header.frameCount;
+    formatContext->duration = av_rescale(m_header.frameCount, static_cast<int64_t>(AV_TIME_BASE) * m_header.frameRateDen,
+                                         m_header.frameRateNum);
+
+    for (uint32_t i = 0; i < m_header.frameCount; i++) {
+        av_add_index_entry(stream, static_cast<int64_t>(i) * m_header.frameSize, i,
+                           static_cast<int>(m_header.frameSize), 0, AVINDEX_KEYFRAME);
+    }
+}
+
+bool ClipInput::DecompressFrame(uint32_t frame, uint8_t* dst) const {
+    const ClipFrameEntry& entry = m_index[frame];
+    const uint8_t* src = m_file.GetData() + entry.offset;
+
+    if (entry.compressedSize == m_header.frameSize) {
+        std::memcpy(dst, src, entry.compressedSize);
+        return true;
+    }
+
+    int frameSize = static_cast<int>(m_header.frameSize);
+    int decompressed = LZ4_decompress_safe(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+                                           static_cast<int>(entry.compressedSize), frameSize);
+    if (decompressed != frameSize) {
+        Logger::Error("Clip frame " + std::to_string(frame) + " is corrupt");
+        return false;
+    }
+    return true;
+}
+
+int ClipInput::ReadPacket(void* opaque, uint8_t* buffer, int bufferSize) {
+    auto* input = static_cast<ClipInput*>(opaque);
+
+    if (input->m_position >= input->m_size) {
+        return AVERROR_EOF;
+    }
+
+    int64_t frameSize = static_cast<int64_t>(input->m_header.frameSize);
+    uint32_t frame = static_cast<uint32_t>(input->m_position / frameSize);
+    int64_t offset = input->m_position % frameSize;
+
+    // Whole frame: decompress straight into the demuxer's packet
+    if (offset == 0 && bufferSize >= frameSize) {
+        if (!input->DecompressFrame(frame, buffer)) {
+            return AVERROR_INVALIDDATA;
+        }
+        input->m_position += frameSize;
+        return static_cast<int>(frameSize);
+    }
+
+    if (input->m_partialFrameIndex != frame) {
+        input->m_partialFrame.resize(static_cast<size_t>(frameSize));
+        if (!input->DecompressFrame(frame, input->m_partialFrame.data())) {
+            input->m_partialFrameIndex = -1;
+            return AVERROR_INVALIDDATA;
+        }
+        input->m_partialFrameIndex = frame;
+    }
+
+    int count = static_cast<int>(std::min<int64_t>(bufferSize, frameSize - offset));
+    std::memcpy(buffer, input->m_partialFrame.data() + offset, count);
+    input->m_position += count;
+    return count;
+}
+
+int64_t ClipInput::Seek(void* opaque, int64_t offset, int whence) {
+    auto* input = static_cast<ClipInput*>(opaque);
+
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return input->m_size;
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            offset += input->m_position;
+            break;
+        case SEEK_END:
+            offset += input->m_size;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+
+    if (offset < 0 || offset > input->m_size) {
+        return AVERROR(EINVAL);
+    }
+
+    input->m_position = offset;
+    return offset;
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ClipFormat.h"
+#include "MappedFileInput.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AVDictionary;
+struct AVFormatContext;
+struct AVIOContext;
+
+namespace PixelMotion {
+
+/**
+ * FFmpeg input for a pre-converted clip (see ClipFormat.h)
+ * The file is memory-mapped and presented to FFmpeg's rawvideo demuxer as
+ * a stream of uncompressed frames. A read of a whole frame decompresses it
+ * straight into the packet, and the rawvideo decoder passes the packet on
+ * without copying, so a frame costs one LZ4 decompression
+ */
+class ClipInput {
+public:
+    ClipInput();
+    ~ClipInput();
+
+    ClipInput(const ClipInput&) = delete;
+    ClipInput& operator=(const ClipInput&) = delete;
+
+    /**
+     * Whether a path names a clip (by extension)
+     */
+    static bool IsClip(const std::wstring& filePath);
+
+    /**
+     * Map the clip, check its header and index, and create the I/O context
+     * @param preloadLimit Copy clips up to this size into memory (0 = never)
+     */
+    bool Open(const std::wstring& filePath, size_t preloadLimit);
+    void Close();
+
+    /**
+     * I/O context for AVFormatContext::pb (owned by this object)
+     */
+    AVIOContext* GetContext() const { return m_ioContext; }
+
+    /**
+     * Options telling the rawvideo demuxer the frame size, format and rate
+     */
+    void GetDemuxerOptions(AVDictionary** options) const;
+
+    /**
+     * Fill in what the rawvideo demuxer can't know: color tags, duration,
+     * and an index entry per frame so every seek lands without reading ahead
+     */
+    void ApplyStreamInfo(AVFormatContext* formatContext) const;
+
+    const ClipFileHeader& GetHeader() const { return m_header; }
+
+private:
+    static int ReadPacket(void* opaque, uint8_t* buffer, int bufferSize);
+    static int64_t Seek(void* opaque, int64_t offset, int whence);
+
+    bool DecompressFrame(uint32_t frame, uint8_t* dst) const;
+
+    MappedFileInput m_file;
+    ClipFileHeader m_header;
+    std::vector<ClipFrameEntry> m_index;
+    int64_t m_size;     // Decompressed stream size
+    int64_t m_position; // Position in the decompressed stream
+
+    // Frame read in pieces (probing, reads that straddle frames)
+    std::vector<uint8_t> m_partialFrame;
+    int64_t m_partialFrameIndex;
+
+    AVIOContext* m_ioContext;
+};
+
+} // namespace PixelMotion
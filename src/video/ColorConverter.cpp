@@ -0,0 +1,209 @@
+#include "ColorConverter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define PIXELMOTION_X64 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace PixelMotion {
+
+constexpr int COEFFICIENT_BITS = 13;
+
+#ifdef PIXELMOTION_X64
+static void Cpuid(int leaf, int subleaf, int regs[4]) {
+#ifdef _MSC_VER
+    __cpuidex(regs, leaf, subleaf);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    regs[0] = static_cast<int>(a);
+    regs[1] = static_cast<int>(b);
+    regs[2] = static_cast<int>(c);
+    regs[3] = static_cast<int>(d);
+#endif
+}
+
+static uint64_t ReadXcr0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0, edx = 0;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static ColorConverter::Kernel DetectKernel() {
+#ifdef PIXELMOTION_X64
+    int regs[4] = {};
+    Cpuid(0, 0, regs);
+    int maxLeaf = regs[0];
+
+    Cpuid(1, 0, regs);
+    bool sse41 = (regs[2] & (1 << 19)) != 0;
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+
+    bool avx2 = false;
+    bool avx512 = false;
+    if (maxLeaf >= 7 && osxsave) {
+        // The OS must save the wider registers on context switches
+        uint64_t xcr0 = ReadXcr0();
+        Cpuid(7, 0, regs);
+        avx2 = (regs[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        avx512 = (regs[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+    }
+
+    if (avx512) return ColorConverter::Kernel::AVX512;
+    if (avx2) return ColorConverter::Kernel::AVX2;
+    if (sse41) return ColorConverter::Kernel::SSE41;
+#endif
+    return ColorConverter::Kernel::Scalar;
+}
+
+ColorConverter::Kernel ColorConverter::GetBestKernel() {
+    static const Kernel kernel = DetectKernel();
+    return kernel;
+}
+
+bool ColorConverter::IsSupported(Kernel kernel) {
+    return static_cast<int>(kernel) <= static_cast<int>(GetBestKernel());
+}
+
+const char* ColorConverter::GetKernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SSE41: return "SSE4.1";
+        case Kernel::AVX2: return "AVX2";
+        case Kernel::AVX512: return "AVX-512";
+        default: return "scalar";
+    }
+}
+
+ColorConverter::Coefficients ColorConverter::GetCoefficients(Format format, Matrix matrix, bool fullRange) {
+    double kr = (matrix == Matrix::BT709) ? 0.2126 : 0.299;
+    double kb = (matrix == Matrix::BT709) ? 0.0722 : 0.114;
+    double kg = 1.0 - kr - kb;
+
+    // Limited range stretches 16-235 luma and 16-240 chroma to 0-255
+    double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+    double uvScale = fullRange ? 1.0 : 255.0 / 224.0;
+
+    int bitDepth = (format == Format::P010) ? 10 : 8;
+    int extraBits = bitDepth - 8;
+    double one = static_cast<double>(1 << COEFFICIENT_BITS);
+
+    Coefficients c;
+    c.yOffset = fullRange ? 0 : (16 << extraBits);
+    c.uvOffset = 128 << extraBits;
+    c.yScale = static_cast<int>(std::lround(yScale * one));
+    c.rv = static_cast<int>(std::lround(2.0 * (1.0 - kr) * uvScale * one));
+    c.gu = static_cast<int>(std::lround(2.0 * (1.0 - kb) * kb / kg * uvScale * one));
+    c.gv = static_cast<int>(std::lround(2.0 * (1.0 - kr) * kr / kg * uvScale * one));
+    c.bu = static_cast<int>(std::lround(2.0 * (1.0 - kb) * uvScale * one));
+    c.shift = COEFFICIENT_BITS + extraBits;
+    c.round = 1 << (c.shift - 1);
+    return c;
+}
+
+static inline uint32_t ClampChannel(int value) {
+    return static_cast<uint32_t>(std::clamp(value, 0, 255));
+}
+
+static inline uint32_t ConvertPixel(int y, int u, int v, const ColorConverter::Coefficients& c) {
+    int luma = (y - c.yOffset) * c.yScale + c.round;
+    u -= c.uvOffset;
+    v -= c.uvOffset;
+
+    int r = (luma + c.rv * v) >> c.shift;
+    int g = (luma - c.gu * u - c.gv * v) >> c.shift;
+    int b = (luma + c.bu * u) >> c.shift;
+    return ClampChannel(b) | (ClampChannel(g) << 8) | (ClampChannel(r) << 16) | 0xFF000000u;
+}
+
+void ColorConverter::ConvertRowScalar(Format format, const Row& row, int start, int width, const Coefficients& c) {
+    switch (format) {
+        case Format::NV12:
+            for (int x = start; x < width; x++) {
+                int uv = (x / 2) * 2;
+                row.dst[x] = ConvertPixel(row.y[x], row.u[uv], row.u[uv + 1], c);
+            }
+            break;
+
+        case Format::YUV420P:
+            for (int x = start; x < width; x++) {
+                row.dst[x] = ConvertPixel(row.y[x], row.u[x / 2], row.v[x / 2], c);
+            }
+            break;
+
+        case Format::P010: {
+            const uint16_t* y = reinterpret_cast<const uint16_t*>(row.y);
+            const uint16_t* uv = reinterpret_cast<const uint16_t*>(row.u);
+            for (int x = start; x < width; x++) {
+                int i = (x / 2) * 2;
+                row.dst[x] = ConvertPixel(y[x] >> 6, uv[i] >> 6, uv[i + 1] >> 6, c);
+            }
+            break;
+        }
+    }
+}
+
+void ColorConverter::Convert(Format format, const uint8_t* const planes[], const int linesizes[], int width, int height,
+                             uint8_t* dst, int dstPitch, Matrix matrix, bool fullRange) {
+    ConvertRows(format, planes, linesizes, width, 0, height, dst, dstPitch, matrix, fullRange);
+}
+
+void ColorConverter::ConvertRows(Format format, const uint8_t* const planes[], const int linesizes[], int width,
+                                 int firstRow, int lastRow, uint8_t* dst, int dstPitch, Matrix matrix, bool fullRange) {
+    ConvertRows(GetBestKernel(), format, planes, linesizes, width, firstRow, lastRow, dst, dstPitch,
+                GetCoefficients(format, matrix, fullRange));
+}
+
+bool ColorConverter::Convert(Kernel kernel, Format format, const uint8_t* const planes[], const int linesizes[],
+                             int width, int height, uint8_t* dst, int dstPitch, Matrix matrix, bool fullRange) {
+    if (!IsSupported(kernel)) {
+        return false;
+    }
+
+    ConvertRows(kernel, format, planes, linesizes, width, 0, height, dst, dstPitch,
+                GetCoefficients(format, matrix, fullRange));
+    return true;
+}
+
+void ColorConverter::ConvertRows(Kernel kernel, Format format, const uint8_t* const planes[], const int linesizes[],
+                                 int width, int firstRow, int lastRow, uint8_t* dst, int dstPitch,
+                                 const Coefficients& c) {
+    for (int y = firstRow; y < lastRow; y++) {
+        // 4:2:0 chroma rows cover two luma rows
+        Row row;
+        row.y = planes[0] + static_cast<ptrdiff_t>(y) * linesizes[0];
+        row.u = planes[1] + static_cast<ptrdiff_t>(y / 2) * linesizes[1];
+        row.v = (format == Format::YUV420P) ? planes[2] + static_cast<ptrdiff_t>(y / 2) * linesizes[2] : nullptr;
+        row.dst = reinterpret_cast<uint32_t*>(dst + static_cast<ptrdiff_t>(y) * dstPitch);
+
+        int done = 0;
+        switch (kernel) {
+            case Kernel::AVX512: done = ConvertRowAVX512(format, row, width, c); break;
+            case Kernel::AVX2: done = ConvertRowAVX2(format, row, width, c); break;
+            case Kernel::SSE41: done = ConvertRowSSE41(format, row, width, c); break;
+            default: break;
+        }
+        ConvertRowScalar(format, row, done, width, c);
+    }
+}
+
+#ifndef PIXELMOTION_X64
+// No vector kernels on this architecture; rows are converted by the scalar path
+int ConvertRowSSE41(ColorConverter::Format, const ColorConverter::Row&, int, const ColorConverter::Coefficients&) { return 0; }
+int ConvertRowAVX2(ColorConverter::Format, const ColorConverter::Row&, int, const ColorConverter::Coefficients&) { return 0; }
+int ConvertRowAVX512(ColorConverter::Format, const ColorConverter::Row&, int, const ColorConverter::Coefficients&) { return 0; }
+#endif
+
+} // namespace PixelMotion
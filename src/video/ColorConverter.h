@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PixelMotion {
+
+/**
+ * YUV to BGRA conversion for software frames shown at their decoded size
+ * Rows are converted with SSE4.1, AVX2 or AVX-512 kernels picked from the
+ * CPU features at startup; every kernel produces the same output as the
+ * scalar reference (integer math with 13-bit coefficients)
+ */
+class ColorConverter {
+public:
+    enum class Format {
+        NV12,    // 8-bit Y plane, interleaved UV plane
+        YUV420P, // 8-bit Y, U and V planes
+        P010     // 16-bit little-endian samples, 10 significant bits at the top
+    };
+
+    enum class Matrix {
+        BT601,
+        BT709
+    };
+
+    enum class Kernel {
+        Scalar,
+        SSE41,
+        AVX2,
+        AVX512
+    };
+
+    // Fixed-point conversion constants, shared by all kernels
+    struct Coefficients {
+        int yOffset;
+        int uvOffset;
+        int yScale;
+        int rv;  // V contribution to red
+        int gu;  // U and V contributions subtracted from green
+        int gv;
+        int bu;  // U contribution to blue
+        int round;
+        int shift;
+    };
+
+    // One row of input planes and output pixels
+    struct Row {
+        const uint8_t* y;
+        const uint8_t* u; // Interleaved UV for NV12 and P010
+        const uint8_t* v; // YUV420P only
+        uint32_t* dst;
+    };
+
+    /**
+     * Convert a frame with the fastest kernel the CPU supports
+     * @param planes Plane pointers and strides as in AVFrame::data/linesize
+     * @param dst BGRA output with the given row pitch (bytes)
+     */
+    static void Convert(Format format, const uint8_t* const planes[], const int linesizes[], int width, int height,
+                        uint8_t* dst, int dstPitch, Matrix matrix, bool fullRange);
+
+    /**
+     * Convert with a specific kernel (for comparing kernels)
+     * @return false if the CPU doesn't support the kernel
+     */
+    static bool Convert(Kernel kernel, Format format, const uint8_t* const planes[], const int linesizes[],
+                        int width, int height, uint8_t* dst, int dstPitch, Matrix matrix, bool fullRange);
+
+    /**
+     * Convert rows [firstRow, lastRow) of a frame, for splitting a conversion
+     * into bands. Planes and dst point at row 0
+     */
+    static void ConvertRows(Format format, const uint8_t* const planes[], const int linesizes[], int width,
+                            int firstRow, int lastRow, uint8_t* dst, int dstPitch, Matrix matrix, bool fullRange);
+
+    static Kernel GetBestKernel();
+    static bool IsSupported(Kernel kernel);
+    static const char* GetKernelName(Kernel kernel);
+
+    static Coefficients GetCoefficients(Format format, Matrix matrix, bool fullRange);
+
+private:
+    static void ConvertRows(Kernel kernel, Format format, const uint8_t* const planes[], const int linesizes[],
+                            int width, int firstRow, int lastRow, uint8_t* dst, int dstPitch, const Coefficients& c);
+    static void ConvertRowScalar(Format format, const Row& row, int start, int width, const Coefficients& c);
+};
+
+// Vectorized row kernels; each converts a multiple of its vector width and
+// returns the number of pixels done, the caller finishes the row
+int ConvertRowSSE41(ColorConverter::Format format, const ColorConverter::Row& row, int width,
+                    const ColorConverter::Coefficients& c);
+int ConvertRowAVX2(ColorConverter::Format format, const ColorConverter::Row& row, int width,
+                   const ColorConverter::Coefficients& c);
+int ConvertRowAVX512(ColorConverter::Format format, const ColorConverter::Row& row, int width,
+                     const ColorConverter::Coefficients& c);
+
+} // namespace PixelMotion
@@ -0,0 +1,122 @@
+#include "ConversionPool.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <string>
+
+namespace PixelMotion {
+
+// Conversions are memory bound; more threads than this only add contention
+constexpr int MAX_CONVERSION_THREADS = 16;
+
+ConversionPool& ConversionPool::GetInstance() {
+    static ConversionPool instance;
+    return instance;
+}
+
+ConversionPool::~ConversionPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+int ConversionPool::GetThreadCount() {
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(cores, 1, MAX_CONVERSION_THREADS);
+}
+
+void ConversionPool::Start() {
+    m_started = true;
+
+    // The thread calling Run works on bands as well
+    int workers = GetThreadCount() - 1;
+    for (int i = 0; i < workers; i++) {
+        m_workers.emplace_back(&ConversionPool::WorkerMain, this);
+    }
+    Logger::Info("Started " + std::to_string(workers) + " frame conversion workers");
+}
+
+void ConversionPool::Run(int bands, const std::function<void(int band)>& task) {
+    if (bands <= 1) {
+        task(0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_started) {
+            Start();
+        }
+        m_task = &task;
+        m_bands = bands;
+        m_nextBand = 0;
+        m_pendingBands = bands;
+        m_generation++;
+    }
+    m_workAvailable.notify_all();
+
+    RunBands(task, bands);
+
+    // Workers still inside the job would pick bands of the next one
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this] { return m_pendingBands == 0 && m_activeWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ConversionPool::RunBands(const std::function<void(int)>& task, int bands) {
+    for (;;) {
+        int band = m_nextBand.fetch_add(1);
+        if (band >= bands) {
+            return;
+        }
+
+        task(band);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pendingBands == 0) {
+            m_workDone.notify_all();
+        }
+    }
+}
+
+void ConversionPool::WorkerMain() {
+    uint64_t seenGeneration = 0;
+
+    for (;;) {
+        // The job is read under the lock; Run doesn't return (and can't
+        // start another job) while this worker is counted as active
+        const std::function<void(int)>* task = nullptr;
+        int bands = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+            task = m_task;
+            bands = m_bands;
+            m_activeWorkers++;
+        }
+
+        if (task) {
+            RunBands(*task, bands);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_activeWorkers == 0) {
+            m_workDone.notify_all();
+        }
+    }
+}
+
+} // namespace PixelMotion
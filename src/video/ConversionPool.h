@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PixelMotion {
+
+/**
+ * Worker threads shared by all decoders for converting software frames in
+ * horizontal bands. The calling thread works on bands too and Run returns
+ * once every band is done, so results can go straight into a mapped texture
+ */
+class ConversionPool {
+public:
+    static ConversionPool& GetInstance();
+
+    /**
+     * Run task(band) for every band in [0, bands) in parallel
+     * Workers are started on first use
+     */
+    void Run(int bands, const std::function<void(int band)>& task);
+
+    /**
+     * Threads available for one conversion, including the caller
+     */
+    int GetThreadCount();
+
+private:
+    ConversionPool() = default;
+    ~ConversionPool();
+
+    void Start();
+    void WorkerMain();
+    void RunBands(const std::function<void(int)>& task, int bands);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_runMutex; // One conversion at a time
+
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+    const std::function<void(int)>* m_task = nullptr;
+    int m_bands = 0;
+    std::atomic<int> m_nextBand{0};
+    int m_pendingBands = 0;
+    int m_activeWorkers = 0;
+    uint64_t m_generation = 0; // Bumped for each Run so workers join every job once
+    bool m_started = false;
+    bool m_stopping = false;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+namespace PixelMotion {
+
+/**
+ * Decoder tuning, fixed for the lifetime of an opened file
+ */
+struct DecoderOptions {
+    // Frames from the start of the clip kept decoded to hide the seek back
+    // at the end of each loop; 0 disables
+    size_t loopPrerollFrames = 6;
+
+    // Keep a whole short loop decoded (in the decoder's YUV format) and replay it
+    // instead of decoding again, if it fits in this many bytes; 0 disables.
+    // Software decoding only: hardware frames stay in the decoder's surface pool.
+    // Same default as Configuration's loopCacheBudgetMB
+    size_t loopCacheBudget = 256 * 1024 * 1024;
+
+    // Read files up to this size into memory instead of mapping them; 0 disables
+    size_t preloadLimit = 0;
+
+    // Open the file's proxy for this ladder rung (ProxyTranscoder) when one
+    // has been made; 0 always opens the file itself
+    int proxyHeight = 0;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,224 @@
+#include "FrameConverter.h"
+#include "ColorConverter.h"
+#include "ConversionPool.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+
+static bool GetConverterFormat(int pixelFormat, ColorConverter::Format& format) {
+    switch (pixelFormat) {
+        case AV_PIX_FMT_NV12: format = ColorConverter::Format::NV12; return true;
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P: format = ColorConverter::Format::YUV420P; return true;
+        case AV_PIX_FMT_P010LE: format = ColorConverter::Format::P010; return true;
+        default: return false;
+    }
+}
+
+// Untagged content follows the usual convention: HD is BT.709, SD is BT.601
+static bool IsBT709(const AVFrame* frame) {
+    switch (frame->colorspace) {
+        case AVCOL_SPC_BT709: return true;
+        case AVCOL_SPC_BT470BG:
+        case AVCOL_SPC_SMPTE170M: return false;
+        default: return frame->height >= 720;
+    }
+}
+
+static bool IsFullRange(const AVFrame* frame) {
+    return frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P;
+}
+
+FrameConverter::FrameConverter()
+    : m_rgbaFrame(nullptr)
+    , m_sliceSource(nullptr)
+{
+}
+
+FrameConverter::~FrameConverter() {
+    if (m_rgbaFrame) {
+        av_frame_free(&m_rgbaFrame);
+    }
+    if (m_sliceSource) {
+        av_frame_free(&m_sliceSource);
+    }
+    for (SwsContext* swsContext : m_swsContexts) {
+        sws_freeContext(swsContext);
+    }
+}
+
+bool FrameConverter::GetCroppedPlanes(const AVFrame* frame, int& cropWidth, int& cropHeight, const uint8_t* planes[4]) {
+    for (int i = 0; i < 4; i++) {
+        planes[i] = frame->data[i];
+    }
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        return false;
+    }
+
+    int alignX = 1 << desc->log2_chroma_w;
+    int alignY = 1 << desc->log2_chroma_h;
+    int cropX = ((frame->width - cropWidth) / 2) & ~(alignX - 1);
+    int cropY = ((frame->height - cropHeight) / 2) & ~(alignY - 1);
+    cropWidth = frame->width - 2 * cropX;
+    cropHeight = frame->height - 2 * cropY;
+
+    for (int c = 0; c < desc->nb_components; c++) {
+        const AVComponentDescriptor& comp = desc->comp[c];
+        bool chroma = (c == 1 || c == 2);
+        int x = chroma ? (cropX >> desc->log2_chroma_w) : cropX;
+        int y = chroma ? (cropY >> desc->log2_chroma_h) : cropY;
+        planes[comp.plane] = frame->data[comp.plane] + static_cast<ptrdiff_t>(y) * frame->linesize[comp.plane] +
+                             static_cast<ptrdiff_t>(x) * comp.step;
+    }
+    return true;
+}
+
+bool FrameConverter::Convert(const AVFrame* frame, const uint8_t* const planes[4], int cropWidth, int cropHeight,
+                             uint8_t* dst, int dstPitch, int outputWidth, int outputHeight, int bands) {
+    ColorConverter::Format directFormat = ColorConverter::Format::NV12;
+    bool direct = outputWidth == cropWidth && outputHeight == cropHeight &&
+                  GetConverterFormat(frame->format, directFormat);
+    if (!direct) {
+        return PrepareScalers(frame, cropWidth, cropHeight, outputWidth, outputHeight, bands) &&
+               ScaleInBands(frame, planes, cropWidth, cropHeight, dst, dstPitch, outputWidth, outputHeight, bands);
+    }
+
+    static bool logged = false;
+    if (!logged) {
+        Logger::Info(std::string("Using ") + ColorConverter::GetKernelName(ColorConverter::GetBestKernel()) +
+                     " YUV to BGRA conversion");
+        logged = true;
+    }
+
+    ColorConverter::Matrix matrix = IsBT709(frame) ? ColorConverter::Matrix::BT709 : ColorConverter::Matrix::BT601;
+    bool fullRange = IsFullRange(frame);
+    ConversionPool::GetInstance().Run(bands, [&](int band) {
+        ColorConverter::ConvertRows(directFormat, planes, frame->linesize, cropWidth,
+                                    cropHeight * band / bands, cropHeight * (band + 1) / bands,
+                                    dst, dstPitch, matrix, fullRange);
+    });
+    return true;
+}
+
+bool FrameConverter::PrepareScalers(const AVFrame* frame, int cropWidth, int cropHeight,
+                                    int outputWidth, int outputHeight, int bands) {
+    // Each band has its own context over the whole frame, so bands line up
+    // exactly with what a single pass would produce
+    while (static_cast<int>(m_swsContexts.size()) > bands) {
+        sws_freeContext(m_swsContexts.back());
+        m_swsContexts.pop_back();
+    }
+    m_swsContexts.resize(bands, nullptr);
+
+    for (SwsContext*& swsContext : m_swsContexts) {
+        // Set up swscale context if needed (scale the crop to the output size and
+        // convert any format to BGRA in one pass); reused while the sizes are unchanged
+        SwsContext* cached = sws_getCachedContext(
+            swsContext,
+            cropWidth, cropHeight, (AVPixelFormat)frame->format,
+            outputWidth, outputHeight, AV_PIX_FMT_BGRA,
+            SWS_BILINEAR, nullptr, nullptr, nullptr
+        );
+        if (!cached) {
+            Logger::Error("Failed to create swscale context");
+            return false;
+        }
+        if (cached == swsContext) {
+            continue;
+        }
+
+        bool first = (&swsContext == &m_swsContexts.front());
+        swsContext = cached;
+        if (first) {
+            Logger::Info("Created swscale context for format " + std::to_string(frame->format) + " -> BGRA");
+        }
+
+        // Match the matrix and range the SIMD path uses, so colors don't shift
+        // when a window starts or stops scaling
+        int colorspace = IsBT709(frame) ? SWS_CS_ITU709 : SWS_CS_ITU601;
+        sws_setColorspaceDetails(swsContext, sws_getCoefficients(colorspace), IsFullRange(frame),
+                                 sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+    }
+
+    return true;
+}
+
+// The destination belongs to the caller (usually a mapped texture); wrapping it only lends it to swscale
+static void KeepCallerMemory(void*, uint8_t*) {}
+
+bool FrameConverter::ScaleInBands(const AVFrame* frame, const uint8_t* const planes[4], int cropWidth, int cropHeight,
+                                  uint8_t* dst, int dstPitch, int outputWidth, int outputHeight, int bands) {
+    if (!m_sliceSource) {
+        m_sliceSource = av_frame_alloc();
+    }
+    if (!m_rgbaFrame) {
+        m_rgbaFrame = av_frame_alloc();
+    }
+    if (!m_sliceSource || !m_rgbaFrame) {
+        return false;
+    }
+
+    // Source is a reference to the frame narrowed to the crop (no copy)
+    if (av_frame_ref(m_sliceSource, frame) < 0) {
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        m_sliceSource->data[i] = const_cast<uint8_t*>(planes[i]);
+    }
+    m_sliceSource->width = cropWidth;
+    m_sliceSource->height = cropHeight;
+
+    m_rgbaFrame->buf[0] = av_buffer_create(dst, static_cast<size_t>(dstPitch) * outputHeight,
+                                           KeepCallerMemory, nullptr, 0);
+    m_rgbaFrame->data[0] = dst;
+    m_rgbaFrame->linesize[0] = dstPitch;
+    m_rgbaFrame->width = outputWidth;
+    m_rgbaFrame->height = outputHeight;
+    m_rgbaFrame->format = AV_PIX_FMT_BGRA;
+
+    std::atomic<bool> failed = !m_rgbaFrame->buf[0];
+    if (!failed) {
+        int alignment = static_cast<int>(std::max(1u, sws_receive_slice_alignment(m_swsContexts[0])));
+        ConversionPool::GetInstance().Run(bands, [&](int band) {
+            int firstRow = outputHeight * band / bands / alignment * alignment;
+            int lastRow = (band == bands - 1) ? outputHeight : outputHeight * (band + 1) / bands / alignment * alignment;
+            if (lastRow <= firstRow) {
+                return;
+            }
+
+            SwsContext* swsContext = m_swsContexts[band];
+            if (sws_frame_start(swsContext, m_rgbaFrame, m_sliceSource) < 0) {
+                failed = true;
+                return;
+            }
+            if (sws_send_slice(swsContext, 0, cropHeight) < 0 ||
+                sws_receive_slice(swsContext, firstRow, lastRow - firstRow) < 0) {
+                failed = true;
+            }
+            sws_frame_end(swsContext);
+        });
+    }
+
+    av_frame_unref(m_sliceSource);
+    av_frame_unref(m_rgbaFrame);
+
+    if (failed) {
+        Logger::Error("Failed to scale frame");
+        return false;
+    }
+    return true;
+}
+
+} // namespace PixelMotion
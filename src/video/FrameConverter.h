@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct AVFrame;
+struct SwsContext;
+
+namespace PixelMotion {
+
+/**
+ * CPU conversion of decoded software frames to BGRA
+ * Crops shown at their decoded size in a common YUV layout go through the
+ * SIMD ColorConverter; everything else (and any scaling) goes through
+ * swscale. Large conversions are split into bands run on the ConversionPool
+ */
+class FrameConverter {
+public:
+    FrameConverter();
+    ~FrameConverter();
+
+    FrameConverter(const FrameConverter&) = delete;
+    FrameConverter& operator=(const FrameConverter&) = delete;
+
+    /**
+     * Plane pointers for a centered crop of a frame (as av_frame_apply_cropping
+     * computes them, without touching the frame); the crop is widened to whole
+     * chroma samples. Returns false for formats that can't be cropped in place
+     */
+    static bool GetCroppedPlanes(const AVFrame* frame, int& cropWidth, int& cropHeight, const uint8_t* planes[4]);
+
+    /**
+     * Convert a crop of a frame (planes from GetCroppedPlanes, or the frame's own)
+     * to BGRA at the output size, straight into dst
+     * @param bands Horizontal bands converted in parallel; the result doesn't depend on it
+     */
+    bool Convert(const AVFrame* frame, const uint8_t* const planes[4], int cropWidth, int cropHeight,
+                 uint8_t* dst, int dstPitch, int outputWidth, int outputHeight, int bands);
+
+private:
+    bool PrepareScalers(const AVFrame* frame, int cropWidth, int cropHeight, int outputWidth, int outputHeight, int bands);
+    bool ScaleInBands(const AVFrame* frame, const uint8_t* const planes[4], int cropWidth, int cropHeight,
+                      uint8_t* dst, int dstPitch, int outputWidth, int outputHeight, int bands);
+
+    std::vector<SwsContext*> m_swsContexts; // One per conversion band
+    AVFrame* m_rgbaFrame;   // Destination lent to swscale while converting
+    AVFrame* m_sliceSource; // Cropped reference to the frame while converting
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,67 @@
+#include "FrameHandle.h"
+
+#include <utility>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+
+std::atomic<int64_t> FrameHandle::s_liveCount{0};
+
+FrameHandle::FrameHandle(const AVFrame* frame) {
+    // av_frame_ref would copy the pixels of a frame it can't reference
+    if (!frame || !frame->buf[0]) {
+        return;
+    }
+
+    m_frame = av_frame_alloc();
+    if (m_frame && av_frame_ref(m_frame, frame) < 0) {
+        av_frame_free(&m_frame);
+    }
+    if (m_frame) {
+        s_liveCount++;
+    }
+}
+
+FrameHandle::~FrameHandle() {
+    Reset();
+}
+
+FrameHandle::FrameHandle(const FrameHandle& other)
+    : FrameHandle(other.m_frame)
+{
+}
+
+FrameHandle& FrameHandle::operator=(const FrameHandle& other) {
+    if (this != &other) {
+        FrameHandle copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept
+    : m_frame(other.m_frame)
+{
+    other.m_frame = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        m_frame = other.m_frame;
+        other.m_frame = nullptr;
+    }
+    return *this;
+}
+
+void FrameHandle::Reset() {
+    if (m_frame) {
+        av_frame_free(&m_frame);
+        s_liveCount--;
+    }
+}
+
+} // namespace PixelMotion
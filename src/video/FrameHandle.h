@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+struct AVFrame;
+
+namespace PixelMotion {
+
+/**
+ * Counted reference to a decoded frame
+ * Copies share the frame's buffers (av_frame_ref), so pixels and decoder
+ * surfaces are never duplicated as a frame passes from the decoder to
+ * converters and windows. The buffers go back to their pool when the last
+ * handle is reset or destroyed
+ */
+class FrameHandle {
+public:
+    FrameHandle() = default;
+
+    /**
+     * New reference to a frame's buffers
+     * Frames without refcounted buffers give an empty handle rather than a copy
+     */
+    explicit FrameHandle(const AVFrame* frame);
+
+    ~FrameHandle();
+
+    FrameHandle(const FrameHandle& other);
+    FrameHandle& operator=(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+
+    /**
+     * Drop this reference
+     */
+    void Reset();
+
+    const AVFrame* Get() const { return m_frame; }
+    const AVFrame* operator->() const { return m_frame; }
+    explicit operator bool() const { return m_frame != nullptr; }
+
+    /**
+     * Handles alive in the process, for spotting frames that are never released
+     */
+    static int64_t GetLiveCount() { return s_liveCount.load(); }
+
+private:
+    AVFrame* m_frame = nullptr;
+
+    static std::atomic<int64_t> s_liveCount;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,202 @@
+#include "FramePool.h"
+#include "core/Logger.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace PixelMotion {
+
+// Rows and planes start on cache lines (also covers every SIMD stride FFmpeg asks for)
+constexpr int ROW_ALIGNMENT = 64;
+
+// Decoder SIMD may read a little past the end of a plane
+constexpr size_t PLANE_PADDING = 64;
+
+static size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Large page size if this process may use large pages, 0 otherwise
+ * Needs the "Lock pages in memory" right, which is enabled here once
+ */
+static size_t GetLargePageSize() {
+    static const size_t largePageSize = [] {
+        size_t minimum = GetLargePageMinimum();
+        if (minimum == 0) {
+            return size_t(0);
+        }
+
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+            return size_t(0);
+        }
+
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        bool enabled = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+                       AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                       GetLastError() == ERROR_SUCCESS;
+        CloseHandle(token);
+
+        Logger::Info(enabled ? "Frame buffers use large pages" : "Large pages unavailable for frame buffers");
+        return enabled ? minimum : size_t(0);
+    }();
+    return largePageSize;
+}
+
+FramePool::FramePool()
+    : m_pool(nullptr)
+    , m_format(AV_PIX_FMT_NONE)
+    , m_width(0)
+    , m_height(0)
+    , m_linesizes{}
+    , m_planeOffsets{}
+    , m_bufferSize(0)
+    , m_allocations(0)
+    , m_allocatedBytes(0)
+{
+}
+
+FramePool::~FramePool() {
+    // Buffers still held by frames are freed when their last reference goes
+    av_buffer_pool_uninit(&m_pool);
+}
+
+void FramePool::Attach(AVCodecContext* codecContext) {
+    if (!codecContext || !codecContext->codec || !(codecContext->codec->capabilities & AV_CODEC_CAP_DR1)) {
+        return;
+    }
+
+    codecContext->opaque = this;
+    codecContext->get_buffer2 = &FramePool::GetBuffer;
+}
+
+int FramePool::GetBuffer(AVCodecContext* codecContext, AVFrame* frame, int flags) {
+    FramePool* pool = static_cast<FramePool*>(codecContext->opaque);
+    if (!pool || frame->hw_frames_ctx || codecContext->codec_type != AVMEDIA_TYPE_VIDEO) {
+        return avcodec_default_get_buffer2(codecContext, frame, flags);
+    }
+
+    // Palettes and hardware surfaces keep FFmpeg's allocator
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM))) {
+        return avcodec_default_get_buffer2(codecContext, frame, flags);
+    }
+
+    int ret = pool->FillFrame(codecContext, frame);
+    if (ret < 0) {
+        return avcodec_default_get_buffer2(codecContext, frame, flags);
+    }
+    return ret;
+}
+
+int FramePool::FillFrame(AVCodecContext* codecContext, AVFrame* frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_pool || frame->format != m_format || frame->width != m_width || frame->height != m_height) {
+        // Decoders write past the visible size up to their block alignment
+        int width = frame->width;
+        int height = frame->height;
+        int linesizeAlign[AV_NUM_DATA_POINTERS];
+        avcodec_align_dimensions2(codecContext, &width, &height, linesizeAlign);
+
+        AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+        int linesizes[4] = {};
+        if (av_image_fill_linesizes(linesizes, format, width) < 0) {
+            return -1;
+        }
+
+        ptrdiff_t strides[4] = {};
+        for (int i = 0; i < 4; i++) {
+            linesizes[i] = static_cast<int>(AlignUp(linesizes[i], std::max(ROW_ALIGNMENT, linesizeAlign[i])));
+            strides[i] = linesizes[i];
+        }
+
+        size_t planeSizes[4] = {};
+        if (av_image_fill_plane_sizes(planeSizes, format, height, strides) < 0) {
+            return -1;
+        }
+
+        size_t offset = 0;
+        for (int i = 0; i < 4; i++) {
+            m_linesizes[i] = linesizes[i];
+            m_planeOffsets[i] = offset;
+            if (planeSizes[i] > 0) {
+                offset = AlignUp(offset + planeSizes[i] + PLANE_PADDING, ROW_ALIGNMENT);
+            }
+        }
+
+        // Frames with the old geometry keep their buffers until released
+        av_buffer_pool_uninit(&m_pool);
+        m_pool = av_buffer_pool_init2(offset, this, &FramePool::AllocateBuffer, nullptr);
+        if (!m_pool) {
+            return -1;
+        }
+
+        m_format = frame->format;
+        m_width = frame->width;
+        m_height = frame->height;
+        m_bufferSize = offset;
+        Logger::Info("Frame pool: " + std::to_string(frame->width) + "x" + std::to_string(frame->height) + " " +
+                     av_get_pix_fmt_name(format) + ", " + std::to_string(offset / 1024) + " KB per frame");
+    }
+
+    frame->buf[0] = av_buffer_pool_get(m_pool);
+    if (!frame->buf[0]) {
+        return -1;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        frame->linesize[i] = m_linesizes[i];
+        frame->data[i] = m_linesizes[i] ? frame->buf[0]->data + m_planeOffsets[i] : nullptr;
+    }
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+AVBufferRef* FramePool::AllocateBuffer(void* opaque, size_t size) {
+    FramePool* pool = static_cast<FramePool*>(opaque);
+
+    // Page-aligned, zeroed memory straight from the OS; large pages keep the
+    // TLB from thrashing on 4K frames
+    size_t largePageSize = GetLargePageSize();
+    void* memory = nullptr;
+    size_t allocated = 0;
+    if (largePageSize && size >= largePageSize) {
+        allocated = AlignUp(size, largePageSize);
+        memory = VirtualAlloc(nullptr, allocated, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+    if (!memory) {
+        allocated = size;
+        memory = VirtualAlloc(nullptr, allocated, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (!memory) {
+        return nullptr;
+    }
+
+    AVBufferRef* buffer = av_buffer_create(static_cast<uint8_t*>(memory), size, &FramePool::FreeBuffer, nullptr, 0);
+    if (!buffer) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return nullptr;
+    }
+
+    pool->m_allocations++;
+    pool->m_allocatedBytes += allocated;
+    return buffer;
+}
+
+void FramePool::FreeBuffer(void*, uint8_t* data) {
+    VirtualFree(data, 0, MEM_RELEASE);
+}
+
+} // namespace PixelMotion
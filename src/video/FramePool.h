@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+struct AVBufferPool;
+struct AVBufferRef;
+struct AVCodecContext;
+struct AVFrame;
+
+namespace PixelMotion {
+
+/**
+ * Frame buffers for a software decoder, handed out through get_buffer2
+ * Each frame is one page-aligned allocation (large pages when the process
+ * may lock memory) with 64-byte aligned planes and rows. Buffers return to
+ * the pool when the last reference goes, so after the first few frames
+ * decoding allocates no frame memory; the pool is rebuilt only when the
+ * frame size or format changes
+ */
+class FramePool {
+public:
+    FramePool();
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * Serve a codec's frames from this pool (before avcodec_open2)
+     * Decoders that can't use caller buffers keep FFmpeg's allocator
+     */
+    void Attach(AVCodecContext* codecContext);
+
+    uint64_t GetAllocationCount() const { return m_allocations.load(); }
+    size_t GetAllocatedBytes() const { return m_allocatedBytes.load(); }
+
+private:
+    static int GetBuffer(AVCodecContext* codecContext, AVFrame* frame, int flags);
+    int FillFrame(AVCodecContext* codecContext, AVFrame* frame);
+    static AVBufferRef* AllocateBuffer(void* opaque, size_t size);
+    static void FreeBuffer(void* opaque, uint8_t* data);
+
+    std::mutex m_mutex; // get_buffer2 runs on FFmpeg's frame threads
+    AVBufferPool* m_pool;
+    int m_format;
+    int m_width;
+    int m_height;
+    int m_linesizes[4];
+    size_t m_planeOffsets[4];
+    size_t m_bufferSize;
+
+    std::atomic<uint64_t> m_allocations;
+    std::atomic<size_t> m_allocatedBytes; // Includes buffers of earlier sizes
+};
+
+} // namespace PixelMotion
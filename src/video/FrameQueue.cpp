@@ -0,0 +1,94 @@
+#include "FrameQueue.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+
+FrameQueue::FrameQueue(size_t capacity)
+    : m_slots(capacity > 0 ? capacity : 1, nullptr)
+    , m_head(0)
+    , m_count(0)
+    , m_aborted(false)
+{
+    for (auto& slot : m_slots) {
+        slot = av_frame_alloc();
+    }
+}
+
+FrameQueue::~FrameQueue() {
+    for (auto& slot : m_slots) {
+        av_frame_free(&slot);
+    }
+}
+
+bool FrameQueue::Push(AVFrame* frame) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_aborted || m_count < m_slots.size(); });
+
+    if (m_aborted) {
+        return false;
+    }
+
+    // Slots are owned by the queue, so only buffer references change hands
+    AVFrame* slot = m_slots[(m_head + m_count) % m_slots.size()];
+    av_frame_move_ref(slot, frame);
+    m_count++;
+    return true;
+}
+
+bool FrameQueue::Pop(AVFrame* dst) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == 0) {
+            return false;
+        }
+
+        av_frame_unref(dst);
+        av_frame_move_ref(dst, m_slots[m_head]);
+        m_head = (m_head + 1) % m_slots.size();
+        m_count--;
+    }
+
+    m_notFull.notify_one();
+    return true;
+}
+
+bool FrameQueue::PeekPts(int64_t* pts) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == 0) {
+        return false;
+    }
+
+    *pts = m_slots[m_head]->pts;
+    return true;
+}
+
+void FrameQueue::Abort() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_aborted = true;
+    }
+    m_notFull.notify_all();
+}
+
+void FrameQueue::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& slot : m_slots) {
+            av_frame_unref(slot);
+        }
+        m_head = 0;
+        m_count = 0;
+        m_aborted = false;
+    }
+    m_notFull.notify_all();
+}
+
+size_t FrameQueue::GetSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct AVFrame;
+
+namespace PixelMotion {
+
+/**
+ * Bounded single-producer/single-consumer queue of decoded frames
+ * The decode thread pushes frames ahead of time, the main loop pops the one that is due
+ */
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacity);
+    ~FrameQueue();
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    /**
+     * Move the frame's buffers into the queue, blocking while it is full
+     * @return false if the queue was aborted while waiting
+     */
+    bool Push(AVFrame* frame);
+
+    /**
+     * Move the oldest frame into dst without blocking
+     * @return false if the queue is empty
+     */
+    bool Pop(AVFrame* dst);
+
+    /**
+     * Get the pts of the oldest frame without removing it
+     * @return false if the queue is empty
+     */
+    bool PeekPts(int64_t* pts) const;
+
+    /**
+     * Wake up a blocked producer and reject further pushes
+     */
+    void Abort();
+
+    /**
+     * Drop all queued frames and accept pushes again
+     */
+    void Reset();
+
+    size_t GetSize() const;
+
+private:
+    std::vector<AVFrame*> m_slots;
+    size_t m_head;
+    size_t m_count;
+    bool m_aborted;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,132 @@
+#include "KeyframeIndex.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <fstream>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace PixelMotion {
+
+constexpr uint32_t INDEX_FILE_MAGIC = 0x494B4D50; // "PMKI"
+constexpr uint32_t INDEX_FILE_VERSION = 1;
+
+struct IndexFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t timeBaseNum;
+    int32_t timeBaseDen;
+    uint64_t count;
+};
+
+bool KeyframeIndex::BuildFromDemuxer(AVStream* stream) {
+    m_entries.clear();
+
+    int count = avformat_index_get_entries_count(stream);
+    for (int i = 0; i < count; i++) {
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+        if (entry && (entry->flags & AVINDEX_KEYFRAME)) {
+            m_entries.push_back({ entry->timestamp, entry->pos });
+        }
+    }
+
+    Finalize();
+    return !m_entries.empty();
+}
+
+bool KeyframeIndex::BuildFromScan(AVFormatContext* formatContext, int streamIndex) {
+    m_entries.clear();
+
+    if (av_seek_frame(formatContext, streamIndex, 0, AVSEEK_FLAG_BACKWARD) < 0) {
+        Logger::Warning("Keyframe scan: could not seek to start");
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    if (!packet) {
+        return false;
+    }
+
+    while (av_read_frame(formatContext, packet) >= 0) {
+        if (packet->stream_index == streamIndex && (packet->flags & AV_PKT_FLAG_KEY)) {
+            int64_t pts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+            if (pts != AV_NOPTS_VALUE) {
+                m_entries.push_back({ pts, packet->pos });
+            }
+        }
+        av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+
+    Finalize();
+    return !m_entries.empty();
+}
+
+bool KeyframeIndex::Load(const std::filesystem::path& path, int timeBaseNum, int timeBaseDen) {
+    m_entries.clear();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    IndexFileHeader header = {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != INDEX_FILE_MAGIC || header.version != INDEX_FILE_VERSION ||
+        header.timeBaseNum != timeBaseNum || header.timeBaseDen != timeBaseDen ||
+        header.count == 0 || header.count > (1u << 24)) {
+        Logger::Warning("Ignoring stale or invalid keyframe index");
+        return false;
+    }
+
+    m_entries.resize(static_cast<size_t>(header.count));
+    file.read(reinterpret_cast<char*>(m_entries.data()), m_entries.size() * sizeof(Entry));
+    if (!file) {
+        m_entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool KeyframeIndex::Save(const std::filesystem::path& path, int timeBaseNum, int timeBaseDen) const {
+    if (m_entries.empty()) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    IndexFileHeader header = { INDEX_FILE_MAGIC, INDEX_FILE_VERSION, timeBaseNum, timeBaseDen, m_entries.size() };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_entries.data()), m_entries.size() * sizeof(Entry));
+    return file.good();
+}
+
+int KeyframeIndex::FindKeyframe(int64_t pts) const {
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), pts,
+        [](int64_t value, const Entry& entry) { return value < entry.pts; });
+    return static_cast<int>(it - m_entries.begin()) - 1;
+}
+
+int64_t KeyframeIndex::GetMaxInterval() const {
+    int64_t maxInterval = 0;
+    for (size_t i = 1; i < m_entries.size(); i++) {
+        maxInterval = std::max(maxInterval, m_entries[i].pts - m_entries[i - 1].pts);
+    }
+    return maxInterval;
+}
+
+void KeyframeIndex::Finalize() {
+    std::sort(m_entries.begin(), m_entries.end(),
+        [](const Entry& a, const Entry& b) { return a.pts < b.pts; });
+    m_entries.erase(std::unique(m_entries.begin(), m_entries.end(),
+        [](const Entry& a, const Entry& b) { return a.pts == b.pts; }), m_entries.end());
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+struct AVFormatContext;
+struct AVStream;
+
+namespace PixelMotion {
+
+/**
+ * Timestamps and byte positions of a video stream's keyframes
+ * Built once per file (from the container index, or by scanning packets)
+ * and persisted so reopening the file skips the scan
+ */
+class KeyframeIndex {
+public:
+    struct Entry {
+        int64_t pts;      // Stream time base
+        int64_t position; // Byte offset of the keyframe packet, -1 if unknown
+    };
+
+    /**
+     * Copy keyframes from the demuxer's own index (MP4 sample tables, MKV cues)
+     * @return false if the container has no index
+     */
+    bool BuildFromDemuxer(AVStream* stream);
+
+    /**
+     * Read every packet of the stream and record the keyframes
+     * Leaves the demuxer at end of file; the caller must seek afterwards
+     */
+    bool BuildFromScan(AVFormatContext* formatContext, int streamIndex);
+
+    bool Load(const std::filesystem::path& path, int timeBaseNum, int timeBaseDen);
+    bool Save(const std::filesystem::path& path, int timeBaseNum, int timeBaseDen) const;
+
+    /**
+     * Index of the last keyframe at or before pts
+     * @return -1 if pts precedes every keyframe or the index is empty
+     */
+    int FindKeyframe(int64_t pts) const;
+
+    const Entry& GetEntry(int index) const { return m_entries[index]; }
+    size_t GetCount() const { return m_entries.size(); }
+    bool IsEmpty() const { return m_entries.empty(); }
+    void Clear() { m_entries.clear(); }
+
+    /**
+     * Longest distance between two keyframes, in stream time base
+     */
+    int64_t GetMaxInterval() const;
+
+private:
+    void Finalize();
+
+    std::vector<Entry> m_entries;
+};
+
+} // namespace PixelMotion
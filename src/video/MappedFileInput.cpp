@@ -0,0 +1,322 @@
+#include "MappedFileInput.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/mem.h>
+}
+
+namespace PixelMotion {
+
+// FFmpeg's own file protocol uses the same I/O buffer size
+constexpr int IO_BUFFER_SIZE = 32 * 1024;
+
+// Keep this much of the file ahead of the demuxer resident (~5s of 4K HEVC)
+constexpr int64_t READ_AHEAD_BYTES = 16 * 1024 * 1024;
+
+// Refill once the demuxer gets this close to the end of the window
+constexpr int64_t READ_AHEAD_LOW_WATER = READ_AHEAD_BYTES / 2;
+
+// Upper bound on how long a missed wakeup can delay the next refill
+constexpr auto READ_AHEAD_POLL_INTERVAL = std::chrono::milliseconds(100);
+
+constexpr int64_t PAGE_SIZE = 4096;
+
+// Unit of simulated slow storage reads
+constexpr int64_t STORAGE_BLOCK_SIZE = 64 * 1024;
+
+enum StorageBlockState : uint8_t {
+    BLOCK_COLD,
+    BLOCK_LOADING,
+    BLOCK_RESIDENT
+};
+
+MappedFileInput::MappedFileInput()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+    , m_view(nullptr)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_position(0)
+    , m_readCount(0)
+    , m_stopReadAhead(false)
+    , m_prefetchStart(0)
+    , m_prefetchEnd(0)
+    , m_readAheadEnabled(true)
+    , m_blockLatency(0.0)
+    , m_ioContext(nullptr)
+{
+}
+
+MappedFileInput::~MappedFileInput() {
+    Close();
+}
+
+bool MappedFileInput::Open(const std::wstring& filePath, size_t preloadLimit) {
+    if (!Map(filePath, preloadLimit)) {
+        return false;
+    }
+
+    uint8_t* ioBuffer = static_cast<uint8_t*>(av_malloc(IO_BUFFER_SIZE));
+    if (!ioBuffer) {
+        Close();
+        return false;
+    }
+
+    m_ioContext = avio_alloc_context(ioBuffer, IO_BUFFER_SIZE, 0, this, ReadPacket, nullptr, Seek);
+    if (!m_ioContext) {
+        av_free(ioBuffer);
+        Close();
+        return false;
+    }
+
+    Logger::Info(std::string(IsPreloaded() ? "Preloaded" : "Mapped") + " input file: " +
+                 std::to_string(m_size / 1024) + " KB");
+
+    if (!IsPreloaded() && m_readAheadEnabled) {
+        StartReadAhead();
+    }
+    return true;
+}
+
+bool MappedFileInput::Map(const std::wstring& filePath, size_t preloadLimit) {
+    Close();
+
+    m_file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                         nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        Logger::Warning("Could not open file for mapping: " + std::to_string(GetLastError()));
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart <= 0) {
+        Close();
+        return false;
+    }
+    m_size = fileSize.QuadPart;
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping) {
+        Logger::Warning("Could not create file mapping: " + std::to_string(GetLastError()));
+        Close();
+        return false;
+    }
+
+    m_view = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_view) {
+        Logger::Warning("Could not map file: " + std::to_string(GetLastError()));
+        Close();
+        return false;
+    }
+    m_data = m_view;
+    if (m_blockLatency > 0.0) {
+        m_blockState.assign(static_cast<size_t>((m_size + STORAGE_BLOCK_SIZE - 1) / STORAGE_BLOCK_SIZE), BLOCK_COLD);
+    }
+
+    // Small clips are copied once and the file is let go, so the disk can sleep
+    if (preloadLimit > 0 && static_cast<uint64_t>(m_size) <= preloadLimit) {
+        m_preload.assign(m_view, m_view + m_size);
+        m_data = m_preload.data();
+
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    return true;
+}
+
+void MappedFileInput::Close() {
+    StopReadAhead();
+
+    if (m_ioContext) {
+        // The context may have replaced the buffer it was given
+        av_freep(&m_ioContext->buffer);
+        avio_context_free(&m_ioContext);
+    }
+
+    m_preload.clear();
+    m_preload.shrink_to_fit();
+
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    m_blockState.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_position = 0;
+}
+
+int MappedFileInput::ReadPacket(void* opaque, uint8_t* buffer, int bufferSize) {
+    auto* input = static_cast<MappedFileInput*>(opaque);
+
+    int64_t remaining = input->m_size - input->m_position;
+    if (remaining <= 0) {
+        return AVERROR_EOF;
+    }
+
+    int count = static_cast<int>(std::min<int64_t>(bufferSize, remaining));
+    if (!input->IsPreloaded()) {
+        input->WaitForStorage(input->m_position, input->m_position + count);
+    }
+    std::memcpy(buffer, input->m_data + input->m_position, count);
+    input->m_position += count;
+    input->m_readCount++;
+
+    if (input->NeedsReadAhead()) {
+        input->m_readAheadWake.notify_one();
+    }
+    return count;
+}
+
+int64_t MappedFileInput::Seek(void* opaque, int64_t offset, int whence) {
+    auto* input = static_cast<MappedFileInput*>(opaque);
+
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return input->m_size;
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            offset += input->m_position;
+            break;
+        case SEEK_END:
+            offset += input->m_size;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+
+    if (offset < 0 || offset > input->m_size) {
+        return AVERROR(EINVAL);
+    }
+
+    input->m_position = offset;
+
+    // A seek outside the window (e.g. back to the start of a loop) refills right away
+    if (input->NeedsReadAhead()) {
+        input->m_readAheadWake.notify_one();
+    }
+    return offset;
+}
+
+void MappedFileInput::StartReadAhead() {
+    m_stopReadAhead = false;
+    m_prefetchStart = 0;
+    m_prefetchEnd = 0;
+    m_readAheadThread = std::thread(&MappedFileInput::ReadAheadThreadMain, this);
+}
+
+void MappedFileInput::StopReadAhead() {
+    if (!m_readAheadThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_readAheadMutex);
+        m_stopReadAhead = true;
+    }
+    m_readAheadWake.notify_all();
+    m_readAheadThread.join();
+}
+
+bool MappedFileInput::NeedsReadAhead() const {
+    if (!m_readAheadThread.joinable()) {
+        return false;
+    }
+
+    int64_t position = m_position;
+    int64_t windowEnd = std::min(m_size, m_prefetchEnd.load());
+    return position < m_prefetchStart || (windowEnd < m_size && position + READ_AHEAD_LOW_WATER > windowEnd);
+}
+
+void MappedFileInput::ReadAheadThreadMain() {
+    // Page faults are waited out here, so keep out of the way of the decode thread
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+    std::unique_lock<std::mutex> lock(m_readAheadMutex);
+    while (!m_stopReadAhead) {
+        int64_t position = m_position;
+
+        // Continue the current window, or start a new one after a seek
+        int64_t start = m_prefetchEnd;
+        if (position < m_prefetchStart || position > m_prefetchEnd) {
+            start = position;
+            m_prefetchStart = position;
+        }
+        int64_t end = std::min(m_size, position + READ_AHEAD_BYTES);
+
+        if (start < end) {
+            lock.unlock();
+            Prefetch(start, end);
+            lock.lock();
+            m_prefetchEnd = end;
+        }
+
+        m_readAheadWake.wait_for(lock, READ_AHEAD_POLL_INTERVAL,
+            [this] { return m_stopReadAhead || NeedsReadAhead(); });
+    }
+}
+
+void MappedFileInput::Prefetch(int64_t start, int64_t end) {
+    // Ask the memory manager for the whole range in large I/Os first...
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t*>(m_view + start);
+    range.NumberOfBytes = static_cast<SIZE_T>(end - start);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+    // ...then touch every page, blocking this thread until the range is resident
+    volatile uint8_t sink = 0;
+    for (int64_t offset = start - (start % PAGE_SIZE); offset < end; offset += PAGE_SIZE) {
+        WaitForStorage(offset, offset + 1);
+        sink = sink + m_view[offset];
+        if (m_stopReadAhead) {
+            break;
+        }
+    }
+}
+
+void MappedFileInput::WaitForStorage(int64_t start, int64_t end) {
+    if (m_blockLatency <= 0.0) {
+        return;
+    }
+
+    for (int64_t block = start / STORAGE_BLOCK_SIZE; block * STORAGE_BLOCK_SIZE < end; block++) {
+        std::unique_lock<std::mutex> lock(m_storageMutex);
+
+        // A block the other thread is loading arrives when that load does
+        m_storageReady.wait(lock, [&] { return m_blockState[block] != BLOCK_LOADING; });
+        if (m_blockState[block] == BLOCK_RESIDENT) {
+            continue;
+        }
+
+        m_blockState[block] = BLOCK_LOADING;
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::duration<double>(m_blockLatency));
+        lock.lock();
+        m_blockState[block] = BLOCK_RESIDENT;
+        m_storageReady.notify_all();
+    }
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AVIOContext;
+
+namespace PixelMotion {
+
+/**
+ * Custom FFmpeg input backed by a memory-mapped file
+ * Reads are plain copies out of the mapping, so looping playback needs no
+ * read syscalls once the file is in the page cache. Small files can be
+ * preloaded into RAM entirely, which also releases the file handle.
+ * Mapped files get a read-ahead thread that faults in the pages ahead of
+ * the demuxer, so a cold page cache stalls that thread instead of decoding
+ */
+class MappedFileInput {
+public:
+    MappedFileInput();
+    ~MappedFileInput();
+
+    MappedFileInput(const MappedFileInput&) = delete;
+    MappedFileInput& operator=(const MappedFileInput&) = delete;
+
+    /**
+     * Map the file and create the I/O context
+     * @param preloadLimit Copy files up to this size into memory (0 = never)
+     */
+    bool Open(const std::wstring& filePath, size_t preloadLimit);
+
+    /**
+     * Map (or preload) the file only, for callers that read GetData directly;
+     * no I/O context and no read-ahead thread
+     */
+    bool Map(const std::wstring& filePath, size_t preloadLimit);
+    void Close();
+
+    /**
+     * Read ahead of the demuxer on mapped files (default on); call before Open
+     */
+    void SetReadAhead(bool enabled) { m_readAheadEnabled = enabled; }
+
+    /**
+     * Benchmarks: make the first read of every block of a mapped file wait
+     * as if it came from slow storage, on whichever thread gets there first
+     * (the read-ahead thread, if it is ahead of the demuxer); call before Open
+     */
+    void SimulateSlowStorage(double blockLatency) { m_blockLatency = blockLatency; }
+
+    /**
+     * I/O context for AVFormatContext::pb (owned by this object)
+     */
+    AVIOContext* GetContext() const { return m_ioContext; }
+
+    const uint8_t* GetData() const { return m_data; }
+    int64_t GetSize() const { return m_size; }
+    bool IsPreloaded() const { return !m_preload.empty(); }
+
+    /**
+     * ReadPacket calls so far; each is a copy out of memory where FFmpeg's
+     * file protocol would make a read syscall
+     */
+    uint64_t GetReadCount() const { return m_readCount; }
+
+private:
+    static int ReadPacket(void* opaque, uint8_t* buffer, int bufferSize);
+    static int64_t Seek(void* opaque, int64_t offset, int whence);
+
+    void StartReadAhead();
+    void StopReadAhead();
+    void ReadAheadThreadMain();
+    void Prefetch(int64_t start, int64_t end);
+    bool NeedsReadAhead() const;
+    void WaitForStorage(int64_t start, int64_t end);
+
+    HANDLE m_file;
+    HANDLE m_mapping;
+    const uint8_t* m_view;
+    std::vector<uint8_t> m_preload;
+
+    const uint8_t* m_data; // Mapped view or preload buffer
+    int64_t m_size;
+    std::atomic<int64_t> m_position;
+    std::atomic<uint64_t> m_readCount;
+
+    // Read-ahead window [m_prefetchStart, m_prefetchEnd), owned by the read-ahead thread
+    std::thread m_readAheadThread;
+    std::mutex m_readAheadMutex;
+    std::condition_variable m_readAheadWake;
+    std::atomic<bool> m_stopReadAhead;
+    std::atomic<int64_t> m_prefetchStart;
+    std::atomic<int64_t> m_prefetchEnd;
+    bool m_readAheadEnabled;
+
+    // Simulated slow storage: per-block state, loaded once
+    double m_blockLatency;
+    std::vector<uint8_t> m_blockState;
+    std::mutex m_storageMutex;
+    std::condition_variable m_storageReady;
+
+    AVIOContext* m_ioContext;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,201 @@
+#include "MediaLoader.h"
+#include "AnimatedImage.h"
+#include "MediaSourceRegistry.h"
+#include "StillImageCache.h"
+#include "VideoDecoder.h"
+#include "core/Logger.h"
+#include "core/TextEncoding.h"
+
+#include <Windows.h>
+
+namespace PixelMotion {
+
+MediaLoader& MediaLoader::GetInstance() {
+    static MediaLoader instance;
+    return instance;
+}
+
+MediaLoader::~MediaLoader() {
+    Shutdown();
+}
+
+LoadedMedia MediaLoader::Load(const Request& request) {
+    LoadedMedia media;
+    media.path = request.path;
+
+    if (!request.device) {
+        Logger::Error("Could not get D3D11 device");
+        return media;
+    }
+
+    std::string path = ToUtf8(request.path);
+
+    // A still image already converted (or decoded) for another monitor needs no decoder
+    StillImageCache& images = StillImageCache::GetInstance();
+    media.image = images.Acquire(request.path, request.device, request.targetWidth, request.targetHeight,
+                                 request.scalingMode);
+    if (media.image) {
+        Logger::Info("Image loaded successfully: " + path);
+        return media;
+    }
+
+    MediaSourceRegistry& registry = MediaSourceRegistry::GetInstance();
+    media.animation = registry.FindAnimation(request.path);
+    if (media.animation) {
+        Logger::Info("Animated image loaded successfully: " + path);
+        return media;
+    }
+
+    // Monitors showing the same file share one decoder
+    auto decoder = registry.Acquire(request.path, request.device, request.options);
+    if (!decoder) {
+        return media;
+    }
+
+    // Animated images are decoded in full once and then played without the decoder
+    if (decoder->IsAnimation()) {
+        media.animation = registry.CreateAnimation(request.path, *decoder, request.device);
+        if (!media.animation) {
+            Logger::Error("Failed to decode animated image");
+            return media;
+        }
+        Logger::Info("Animated image loaded successfully: " + path);
+        return media;
+    }
+
+    // Still images are converted for this monitor and the decoder released
+    if (decoder->IsImage()) {
+        media.image = images.Create(request.path, request.device, decoder->AcquireFrame(),
+                                    request.targetWidth, request.targetHeight, request.scalingMode);
+        if (media.image) {
+            Logger::Info("Image loaded successfully: " + path);
+            return media;
+        }
+        Logger::Warning("Still image conversion failed, keeping the decoder");
+    }
+
+    media.decoder = decoder;
+    Logger::Info("Video loaded successfully: " + path);
+    return media;
+}
+
+uint64_t MediaLoader::Submit(const Request& request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        return 0;
+    }
+
+    uint64_t ticket = m_nextTicket++;
+    m_jobs.push_back({ ticket, request });
+
+    if (!m_worker.joinable()) {
+        m_worker = std::thread(&MediaLoader::WorkerMain, this);
+    }
+    m_wakeup.notify_one();
+    return ticket;
+}
+
+bool MediaLoader::Poll(uint64_t ticket, LoadedMedia& media) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_finished.find(ticket);
+    if (it == m_finished.end()) {
+        // Never submitted (or the loader stopped): report it as failed
+        return ticket == 0 || m_stopping;
+    }
+
+    media = std::move(it->second);
+    m_finished.erase(it);
+    return true;
+}
+
+void MediaLoader::Cancel(uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+        if (it->ticket == ticket) {
+            m_jobs.erase(it);
+            return;
+        }
+    }
+
+    auto it = m_finished.find(ticket);
+    if (it != m_finished.end()) {
+        m_releases.push_back(std::move(it->second));
+        m_finished.erase(it);
+        m_wakeup.notify_one();
+        return;
+    }
+
+    // Still running; dropped when it finishes
+    m_cancelled.insert(ticket);
+}
+
+void MediaLoader::Release(LoadedMedia media) {
+    if (!media.IsValid()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping || !m_worker.joinable()) {
+        return; // Released here when media goes out of scope
+    }
+    m_releases.push_back(std::move(media));
+    m_wakeup.notify_one();
+}
+
+void MediaLoader::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+    }
+    m_wakeup.notify_all();
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+
+    // Decoders must be closed before the device goes away
+    m_releases.clear();
+    m_finished.clear();
+    m_cancelled.clear();
+}
+
+void MediaLoader::WorkerMain() {
+    // Loads yield to decode threads and the main thread
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+    for (;;) {
+        Job job;
+        std::deque<LoadedMedia> releases;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this] { return m_stopping || !m_jobs.empty() || !m_releases.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            releases.swap(m_releases);
+            if (!m_jobs.empty()) {
+                job = m_jobs.front();
+                m_jobs.pop_front();
+            } else {
+                job.ticket = 0;
+            }
+        }
+
+        releases.clear();
+        if (job.ticket == 0) {
+            continue;
+        }
+
+        LoadedMedia media = Load(job.request);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cancelled.erase(job.ticket) > 0) {
+            m_releases.push_back(std::move(media));
+            continue;
+        }
+        m_finished[job.ticket] = std::move(media);
+    }
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "DecoderOptions.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+struct ID3D11Device;
+
+namespace PixelMotion {
+
+class AnimatedImage;
+class StillImage;
+class VideoDecoder;
+
+/**
+ * Wallpaper content ready to draw: a running decoder with its first frame
+ * decoded, a still image converted for the monitor, or a decoded animation
+ */
+struct LoadedMedia {
+    std::wstring path;
+    std::shared_ptr<VideoDecoder> decoder;
+    std::shared_ptr<StillImage> image;
+    std::shared_ptr<AnimatedImage> animation;
+
+    bool IsValid() const { return decoder || image || animation; }
+};
+
+/**
+ * Opens wallpapers off the main thread
+ * Loads run in order on one worker, sharing decoders and converted images
+ * through MediaSourceRegistry and StillImageCache like loads on the main
+ * thread. Content being replaced can be handed back to be released on the
+ * worker too, since closing a decoder joins its decode thread
+ */
+class MediaLoader {
+public:
+    struct Request {
+        std::wstring path;
+        ID3D11Device* device = nullptr;
+        int targetWidth = 0;
+        int targetHeight = 0;
+        int scalingMode = 0; // 0=Fill, 1=Fit, 2=Stretch, 3=Center
+        DecoderOptions options;
+    };
+
+    static MediaLoader& GetInstance();
+
+    /**
+     * Open a file on the calling thread
+     * @return invalid media if the file can't be opened or decoded
+     */
+    static LoadedMedia Load(const Request& request);
+
+    /**
+     * Queue a load on the worker
+     * @return ticket for Poll and Cancel
+     */
+    uint64_t Submit(const Request& request);
+
+    /**
+     * Take the result of a finished load (invalid if it failed)
+     * @return false while the load is queued or running
+     */
+    bool Poll(uint64_t ticket, LoadedMedia& media);
+
+    /**
+     * Forget a load; its result is released on the worker
+     */
+    void Cancel(uint64_t ticket);
+
+    /**
+     * Drop content on the worker instead of the calling thread
+     */
+    void Release(LoadedMedia media);
+
+    /**
+     * Stop the worker; queued loads are abandoned
+     */
+    void Shutdown();
+
+private:
+    struct Job {
+        uint64_t ticket;
+        Request request;
+    };
+
+    MediaLoader() = default;
+    ~MediaLoader();
+
+    void WorkerMain();
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<Job> m_jobs;
+    std::deque<LoadedMedia> m_releases;
+    std::map<uint64_t, LoadedMedia> m_finished;
+    std::set<uint64_t> m_cancelled; // Queued or running loads nobody will poll
+    uint64_t m_nextTicket = 1;
+    bool m_stopping = false;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,220 @@
+#include "MediaSourceRegistry.h"
+#include "ProxyTranscoder.h"
+#include "core/Logger.h"
+
+#include <chrono>
+#include <cwctype>
+#include <filesystem>
+#include <system_error>
+
+namespace PixelMotion {
+
+MediaSourceRegistry& MediaSourceRegistry::GetInstance() {
+    static MediaSourceRegistry instance;
+    return instance;
+}
+
+std::shared_ptr<VideoDecoder> MediaSourceRegistry::Acquire(const std::wstring& filePath, ID3D11Device* device,
+                                                           const DecoderOptions& options) {
+    std::wstring key = MakeKey(filePath, options);
+    int activeStreams = 0;
+    bool onBattery = false;
+    DecodeMode mode = DecodeMode::Normal;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PruneExpired();
+
+        auto it = m_sources.find(key);
+        if (it != m_sources.end()) {
+            if (auto decoder = it->second.lock()) {
+                // The reference taken here becomes the new window's
+                Logger::Info("Sharing decoder, now used by " + std::to_string(decoder.use_count()) + " windows");
+                return decoder;
+            }
+        }
+
+        activeStreams = CountActiveStreams() + 1;
+        onBattery = m_onBattery;
+        mode = GetDecodeMode();
+    }
+
+    // Opened without the lock: loads run in the background while the main
+    // thread updates the power state every tick
+    auto decoder = OpenSource(filePath, device, options, activeStreams, onBattery, mode);
+    if (!decoder) {
+        return nullptr;
+    }
+
+    std::shared_ptr<VideoDecoder> existing;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_sources.find(key);
+        if (it != m_sources.end()) {
+            existing = it->second.lock();
+        }
+        if (!existing) {
+            m_sources[key] = decoder;
+            decoder->SetDecodeMode(GetDecodeMode()); // The power state may have changed meanwhile
+            UpdateThreadingHints();
+            return decoder;
+        }
+    }
+
+    // Another load opened the file first; ours is closed outside the lock
+    Logger::Info("Sharing decoder opened concurrently, now used by " + std::to_string(existing.use_count()) + " windows");
+    return existing;
+}
+
+std::shared_ptr<AnimatedImage> MediaSourceRegistry::FindAnimation(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PruneExpired();
+
+    auto it = m_animations.find(MakeKey(filePath, DecoderOptions()));
+    if (it == m_animations.end()) {
+        return nullptr;
+    }
+
+    auto animation = it->second.lock();
+    if (animation) {
+        Logger::Info("Sharing animated image, now used by " + std::to_string(animation.use_count()) + " windows");
+    }
+    return animation;
+}
+
+std::shared_ptr<AnimatedImage> MediaSourceRegistry::CreateAnimation(const std::wstring& filePath, VideoDecoder& decoder,
+                                                                    ID3D11Device* device) {
+    // Decoding every frame takes a while; don't hold up other windows meanwhile
+    auto animation = AnimatedImage::Decode(decoder, device);
+    if (!animation) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PruneExpired();
+
+    std::wstring key = MakeKey(filePath, DecoderOptions());
+    auto it = m_animations.find(key);
+    if (it != m_animations.end()) {
+        if (auto existing = it->second.lock()) {
+            return existing;
+        }
+    }
+    m_animations[key] = animation;
+    return animation;
+}
+
+std::wstring MediaSourceRegistry::MakeKey(const std::wstring& filePath, const DecoderOptions& options) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(filePath, ec);
+    std::wstring key = ec ? filePath : canonical.wstring();
+
+    // Paths are case-insensitive on Windows
+    for (auto& c : key) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+
+    // Decoders opened with different options produce different output
+    key += L"|" + std::to_wstring(options.loopCacheBudget) + L"|" + std::to_wstring(options.proxyHeight);
+
+    // Once a proxy is made, new loads open it instead of sharing the decoder of the source
+    if (options.proxyHeight > 0 && !ProxyTranscoder::FindProxy(filePath, options.proxyHeight).empty()) {
+        key += L"|proxy";
+    }
+    return key;
+}
+
+std::shared_ptr<VideoDecoder> MediaSourceRegistry::OpenSource(const std::wstring& filePath, ID3D11Device* device,
+                                                              const DecoderOptions& options, int activeStreams,
+                                                              bool onBattery, DecodeMode mode) {
+    auto openStart = std::chrono::steady_clock::now();
+    auto decoder = std::make_shared<VideoDecoder>();
+    decoder->SetThreadingHint(activeStreams, onBattery);
+    decoder->SetDecodeMode(mode);
+
+    if (!decoder->Initialize(filePath, device, options)) {
+        Logger::Error("Failed to initialize video decoder");
+        return nullptr;
+    }
+
+    // Decode first frame
+    if (!decoder->DecodeNextFrame()) {
+        Logger::Error("Failed to decode first frame");
+        return nullptr;
+    }
+
+    double firstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+    Logger::Info("Time to first frame: " + std::to_string(firstFrameMs) + " ms");
+
+    // Decode ahead off the main thread so demux/decode stalls don't delay presents
+    if (!decoder->IsImage() && !decoder->StartDecodeThread()) {
+        Logger::Warning("Decode thread unavailable, decoding on the main thread");
+    }
+
+    return decoder;
+}
+
+void MediaSourceRegistry::SetPowerState(bool onBattery, bool lowBattery) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PruneExpired();
+
+    // Cheaper decoding on battery; the switch happens without reopening the file
+    if (onBattery != m_onBattery || lowBattery != m_lowBattery) {
+        m_onBattery = onBattery;
+        m_lowBattery = lowBattery;
+        for (const auto& [key, source] : m_sources) {
+            if (auto decoder = source.lock()) {
+                decoder->SetDecodeMode(GetDecodeMode());
+            }
+        }
+    }
+
+    UpdateThreadingHints();
+}
+
+DecodeMode MediaSourceRegistry::GetDecodeMode() const {
+    if (m_onBattery && m_lowBattery) {
+        return DecodeMode::KeyframesOnly;
+    }
+    return m_onBattery ? DecodeMode::LowPower : DecodeMode::Normal;
+}
+
+int MediaSourceRegistry::CountActiveStreams() {
+    int count = 0;
+    for (const auto& [key, source] : m_sources) {
+        auto decoder = source.lock();
+        if (decoder && !decoder->IsImage()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void MediaSourceRegistry::UpdateThreadingHints() {
+    // Decoders apply the hint the next time they reopen their codec
+    int activeStreams = CountActiveStreams();
+    for (const auto& [key, source] : m_sources) {
+        if (auto decoder = source.lock()) {
+            decoder->SetThreadingHint(activeStreams, m_onBattery);
+        }
+    }
+}
+
+void MediaSourceRegistry::PruneExpired() {
+    for (auto it = m_sources.begin(); it != m_sources.end();) {
+        if (it->second.expired()) {
+            it = m_sources.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = m_animations.begin(); it != m_animations.end();) {
+        if (it->second.expired()) {
+            it = m_animations.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "AnimatedImage.h"
+#include "VideoDecoder.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+struct ID3D11Device;
+
+namespace PixelMotion {
+
+/**
+ * Shares one decoder between all windows showing the same file
+ * Sources are keyed by canonical path and decoder options, and live as
+ * long as any window holds them; each window still scales on its own.
+ * Files are opened and decoded outside the lock, so a load on another
+ * thread never blocks the main thread here
+ */
+class MediaSourceRegistry {
+public:
+    static MediaSourceRegistry& GetInstance();
+
+    /**
+     * Get the running decoder for a file, opening it on first use
+     * @return nullptr if the file can't be opened or decoded
+     */
+    std::shared_ptr<VideoDecoder> Acquire(const std::wstring& filePath, ID3D11Device* device,
+                                          const DecoderOptions& options);
+
+    /**
+     * Get an animated image already decoded for another window
+     */
+    std::shared_ptr<AnimatedImage> FindAnimation(const std::wstring& filePath);
+
+    /**
+     * Decode every frame of an animated image into a store shared by all
+     * windows showing it; the decoder is not needed afterwards
+     */
+    std::shared_ptr<AnimatedImage> CreateAnimation(const std::wstring& filePath, VideoDecoder& decoder,
+                                                   ID3D11Device* device);
+
+    /**
+     * Update the power state (main thread, every tick)
+     * Switches decoders to low power decoding on battery (keyframes only on
+     * low battery) and rebalances decode threads after sources were released
+     */
+    void SetPowerState(bool onBattery, bool lowBattery);
+
+private:
+    MediaSourceRegistry() = default;
+    ~MediaSourceRegistry() = default;
+
+    static std::wstring MakeKey(const std::wstring& filePath, const DecoderOptions& options);
+    std::shared_ptr<VideoDecoder> OpenSource(const std::wstring& filePath, ID3D11Device* device,
+                                             const DecoderOptions& options, int activeStreams,
+                                             bool onBattery, DecodeMode mode);
+    void PruneExpired();
+    int CountActiveStreams();
+    void UpdateThreadingHints();
+    DecodeMode GetDecodeMode() const;
+
+    std::map<std::wstring, std::weak_ptr<VideoDecoder>> m_sources;
+    std::map<std::wstring, std::weak_ptr<AnimatedImage>> m_animations;
+    std::mutex m_mutex;
+    bool m_onBattery = false;
+    bool m_lowBattery = false;
+};
+
+} // namespace PixelMotion
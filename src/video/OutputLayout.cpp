@@ -0,0 +1,96 @@
+#include "OutputLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace PixelMotion {
+
+OutputLayout OutputLayout::Compute(int sourceWidth, int sourceHeight, int targetWidth, int targetHeight,
+                                   int scalingMode, bool crop) {
+    OutputLayout layout;
+    layout.cropWidth = sourceWidth;
+    layout.cropHeight = sourceHeight;
+
+    if (targetWidth <= 0 || targetHeight <= 0 || sourceWidth <= 0 || sourceHeight <= 0) {
+        layout.width = sourceWidth;
+        layout.height = sourceHeight;
+        return layout;
+    }
+
+    // Scale factor from the cropped source to the output; frames are never
+    // upscaled here, the renderer stretches small ones on the GPU
+    double scale = 1.0;
+
+    switch (scalingMode) {
+        case 0: { // Fill - cover the monitor
+            if (!crop) {
+                scale = std::min(1.0, std::max(static_cast<double>(targetWidth) / sourceWidth,
+                                               static_cast<double>(targetHeight) / sourceHeight));
+                break;
+            }
+
+            // Crop to the monitor's aspect ratio, then fit its width
+            if (static_cast<int64_t>(sourceWidth) * targetHeight > static_cast<int64_t>(sourceHeight) * targetWidth) {
+                layout.cropWidth = std::max(1, static_cast<int>(static_cast<int64_t>(sourceHeight) * targetWidth / targetHeight));
+                layout.cropX = (sourceWidth - layout.cropWidth) / 2;
+            } else {
+                layout.cropHeight = std::max(1, static_cast<int>(static_cast<int64_t>(sourceWidth) * targetHeight / targetWidth));
+                layout.cropY = (sourceHeight - layout.cropHeight) / 2;
+            }
+            scale = std::min(1.0, static_cast<double>(targetWidth) / layout.cropWidth);
+            break;
+        }
+
+        case 1: { // Fit - whole frame inside the monitor
+            scale = std::min({ 1.0,
+                               static_cast<double>(targetWidth) / sourceWidth,
+                               static_cast<double>(targetHeight) / sourceHeight });
+            break;
+        }
+
+        case 2: { // Stretch - each axis scaled on its own
+            layout.width = std::min(sourceWidth, targetWidth);
+            layout.height = std::min(sourceHeight, targetHeight);
+            return layout;
+        }
+
+        case 3: { // Center - original size, parts outside the monitor cropped
+            if (crop) {
+                layout.cropWidth = std::min(sourceWidth, targetWidth);
+                layout.cropHeight = std::min(sourceHeight, targetHeight);
+                layout.cropX = (sourceWidth - layout.cropWidth) / 2;
+                layout.cropY = (sourceHeight - layout.cropHeight) / 2;
+            }
+            break;
+        }
+    }
+
+    layout.width = std::max(1, static_cast<int>(std::lround(layout.cropWidth * scale)));
+    layout.height = std::max(1, static_cast<int>(std::lround(layout.cropHeight * scale)));
+    return layout;
+}
+
+void OutputRequest::Add(const OutputLayout& layout) {
+    if (layout.cropWidth <= 0 || layout.cropHeight <= 0) {
+        return;
+    }
+    cropWidth = std::max(cropWidth, layout.cropWidth);
+    cropHeight = std::max(cropHeight, layout.cropHeight);
+    scaleX = std::max(scaleX, static_cast<double>(layout.width) / layout.cropWidth);
+    scaleY = std::max(scaleY, static_cast<double>(layout.height) / layout.cropHeight);
+}
+
+void OutputRequest::Add(const OutputRequest& request) {
+    cropWidth = std::max(cropWidth, request.cropWidth);
+    cropHeight = std::max(cropHeight, request.cropHeight);
+    scaleX = std::max(scaleX, request.scaleX);
+    scaleY = std::max(scaleY, request.scaleY);
+}
+
+void OutputRequest::GetOutputSize(int frameCropWidth, int frameCropHeight, int* width, int* height) const {
+    *width = std::max(1, static_cast<int>(std::lround(frameCropWidth * std::min(1.0, scaleX))));
+    *height = std::max(1, static_cast<int>(std::lround(frameCropHeight * std::min(1.0, scaleY))));
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,46 @@
+#pragma once
+
+namespace PixelMotion {
+
+/**
+ * Part of a frame that is visible on a monitor and the size it is shown at
+ * Conversions produce exactly this many pixels; the renderer only has to
+ * stretch frames smaller than the monitor
+ */
+struct OutputLayout {
+    int cropX = 0;
+    int cropY = 0;
+    int cropWidth = 0;
+    int cropHeight = 0;
+    int width = 0;
+    int height = 0;
+
+    /**
+     * Layout for a monitor and scaling mode (0=Fill, 1=Fit, 2=Stretch, 3=Center)
+     * Output is never larger than the source; a target of 0x0 keeps the source size
+     * @param crop Leave out what Fill and Center push off screen, otherwise only scale
+     */
+    static OutputLayout Compute(int sourceWidth, int sourceHeight, int targetWidth, int targetHeight,
+                                int scalingMode, bool crop);
+};
+
+/**
+ * What the windows sharing a decoder ask for: the union of their centered
+ * crops, at the finest scale on each axis (Stretch scales them separately)
+ */
+struct OutputRequest {
+    int cropWidth = 0;
+    int cropHeight = 0;
+    double scaleX = 0.0;
+    double scaleY = 0.0;
+
+    void Add(const OutputLayout& layout);
+    void Add(const OutputRequest& request);
+
+    /**
+     * Size to convert a crop of the frame to; never larger than the crop
+     */
+    void GetOutputSize(int frameCropWidth, int frameCropHeight, int* width, int* height) const;
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,182 @@
+#include "PlaybackScheduler.h"
+#include "core/Logger.h"
+
+#include <chrono>
+#include <string>
+#include <system_error>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+
+// Give up after this many consecutive failures
+constexpr int MAX_CONSECUTIVE_ERRORS = 16;
+
+// Further behind than this and playback restarts from the due frame
+constexpr double RESYNC_THRESHOLD = 0.25;
+
+// Poll interval while the next frame is not decoded yet
+constexpr double UNDERRUN_RETRY_INTERVAL = 0.005;
+
+static double ToSeconds(int64_t timelineTime) {
+    return static_cast<double>(timelineTime) / AV_TIME_BASE;
+}
+
+PlaybackScheduler::PlaybackScheduler(FrameProducer& producer, size_t queueDepth)
+    : m_producer(producer)
+    , m_queue(queueDepth)
+    , m_queueDepth(queueDepth)
+    , m_stopDecodeThread(false)
+    , m_decodeThreadAlive(false)
+    , m_inlineErrors(0)
+    , m_decodeFailed(false)
+    , m_lateFrameCounted(false)
+    , m_lateFrames(0)
+{
+}
+
+PlaybackScheduler::~PlaybackScheduler() {
+    StopDecodeThread();
+}
+
+bool PlaybackScheduler::StartDecodeThread() {
+    if (IsDecodeThreadRunning()) {
+        return true;
+    }
+
+    // A previous thread that gave up has exited but not been joined yet
+    if (m_decodeThread.joinable()) {
+        m_decodeThread.join();
+    }
+
+    m_stopDecodeThread = false;
+    m_decodeThreadAlive = true;
+
+    try {
+        m_decodeThread = std::thread(&PlaybackScheduler::DecodeThreadMain, this);
+    } catch (const std::system_error& e) {
+        m_decodeThreadAlive = false;
+        Logger::Error("Failed to start decode thread: " + std::string(e.what()));
+        return false;
+    }
+
+    Logger::Info("Decode thread started (queue depth " + std::to_string(m_queueDepth) + ")");
+    return true;
+}
+
+void PlaybackScheduler::StopDecodeThread() {
+    if (m_decodeThread.joinable()) {
+        m_stopDecodeThread = true;
+        m_queue.Abort();
+        m_decodeThread.join();
+    }
+    m_queue.Reset();
+}
+
+void PlaybackScheduler::DecodeThreadMain() {
+    int consecutiveErrors = 0;
+
+    while (!m_stopDecodeThread) {
+        if (!m_producer.ProduceFrame(m_queue)) {
+            if (m_stopDecodeThread) {
+                break;
+            }
+
+            if (++consecutiveErrors >= MAX_CONSECUTIVE_ERRORS) {
+                Logger::Error("Too many decode errors, stopping decode thread");
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        consecutiveErrors = 0;
+    }
+
+    m_decodeThreadAlive = false;
+}
+
+bool PlaybackScheduler::UpdatePlayback(double now, AVFrame* current) {
+    if (m_decodeFailed) {
+        return false;
+    }
+
+    // A decode thread that gave up after repeated errors has exited; collect it
+    // and keep going inline, which stops for good if the errors persist
+    if (m_decodeThread.joinable() && !m_decodeThreadAlive) {
+        m_decodeThread.join();
+        Logger::Warning("Decode thread exited, decoding inline");
+    }
+
+    // Without a decode thread, stay one frame ahead by producing inline
+    if (!IsDecodeThreadRunning() && m_queue.GetSize() == 0) {
+        if (m_producer.ProduceFrame(m_queue)) {
+            m_inlineErrors = 0;
+        } else if (++m_inlineErrors >= MAX_CONSECUTIVE_ERRORS) {
+            Logger::Error("Too many decode errors, playback stopped");
+            m_decodeFailed = true;
+            return false;
+        }
+    }
+
+    if (!m_clock.IsStarted()) {
+        // The current frame is on screen as of now
+        m_clock.Start(now, ToSeconds(current->pts));
+    }
+
+    bool presented = false;
+    int64_t pts = 0;
+    while (m_queue.PeekPts(&pts)) {
+        double dueTime = m_clock.GetDueTime(ToSeconds(pts));
+        if (dueTime > now) {
+            break;
+        }
+
+        if (now - dueTime > RESYNC_THRESHOLD) {
+            // Too far behind (paused, suspended): restart the clock rather than fast-forward
+            m_clock.Start(now, ToSeconds(pts));
+        }
+
+        // A frame already picked up in this pass is superseded by a later due one
+        m_queue.Pop(current);
+        presented = true;
+    }
+
+    if (presented) {
+        m_lateFrameCounted = false;
+        return true;
+    }
+
+    // The current frame has run out and its successor isn't decoded yet
+    double frameEnd = m_clock.GetDueTime(ToSeconds(current->pts + current->duration));
+    if (!m_lateFrameCounted && frameEnd <= now) {
+        m_lateFrames++;
+        m_lateFrameCounted = true;
+    }
+
+    return false;
+}
+
+double PlaybackScheduler::GetTimeToNextFrame(double now) const {
+    if (m_decodeFailed) {
+        return 1.0; // Nothing more to show, check infrequently
+    }
+
+    if (!m_clock.IsStarted()) {
+        return 0.0;
+    }
+
+    int64_t pts = 0;
+    if (!m_queue.PeekPts(&pts)) {
+        // Next frame not decoded yet, poll again shortly
+        return UNDERRUN_RETRY_INTERVAL;
+    }
+
+    double remaining = m_clock.GetDueTime(ToSeconds(pts)) - now;
+    return (remaining > 0.0) ? remaining : 0.0;
+}
+
+} // namespace PixelMotion
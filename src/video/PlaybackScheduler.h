@@ -0,0 +1,101 @@
+#pragma once
+
+#include "FrameQueue.h"
+#include "PresentationClock.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+struct AVFrame;
+
+namespace PixelMotion {
+
+/**
+ * Source of the frames a PlaybackScheduler plays
+ * VideoDecoder decodes them; tests can stand in with stalls of their own
+ */
+class FrameProducer {
+public:
+    virtual ~FrameProducer() = default;
+
+    /**
+     * Push the next frame (pts/duration in microseconds on the playback
+     * timeline) into the queue, blocking while it is full
+     * Called on the decode thread, or on the main thread when none runs
+     * @return false on error, or when the queue was aborted
+     */
+    virtual bool ProduceFrame(FrameQueue& queue) = 0;
+};
+
+/**
+ * Decode-ahead thread, bounded frame queue and presentation schedule of one stream
+ * Has no decoder or D3D11 dependencies of its own, so the threading and
+ * scheduling run the same with a real decoder and in headless tests
+ */
+class PlaybackScheduler {
+public:
+    PlaybackScheduler(FrameProducer& producer, size_t queueDepth);
+    ~PlaybackScheduler();
+
+    PlaybackScheduler(const PlaybackScheduler&) = delete;
+    PlaybackScheduler& operator=(const PlaybackScheduler&) = delete;
+
+    /**
+     * Produce frames ahead on a worker thread into the queue
+     */
+    bool StartDecodeThread();
+
+    /**
+     * Stop the worker and drop the frames it queued
+     */
+    void StopDecodeThread();
+    bool IsDecodeThreadRunning() const { return m_decodeThreadAlive; }
+
+    /**
+     * Make the queued frame that is due at now current (main thread only)
+     * Late frames are dropped; a stall longer than the resync threshold
+     * restarts the clock instead of fast-forwarding. Produces inline when
+     * no worker runs, including after the worker gave up on errors
+     * @param current Frame on screen, replaced by the one presented
+     * @return true if a new frame became current
+     */
+    bool UpdatePlayback(double now, AVFrame* current);
+    double GetTimeToNextFrame(double now) const;
+
+    /**
+     * Forget the schedule (after a seek); the current frame restarts the clock
+     */
+    void ResetClock() { m_clock.Stop(); }
+
+    /**
+     * Times the current frame ran out before its successor was ready
+     */
+    int GetLateFrameCount() const { return m_lateFrames; }
+
+    /**
+     * Producing stopped after repeated errors; the last frame stays current
+     */
+    bool HasDecodeFailed() const { return m_decodeFailed; }
+
+    size_t GetQueuedFrameCount() const { return m_queue.GetSize(); }
+
+private:
+    void DecodeThreadMain();
+
+    FrameProducer& m_producer;
+    FrameQueue m_queue;
+    size_t m_queueDepth;
+
+    std::thread m_decodeThread;
+    std::atomic<bool> m_stopDecodeThread;
+    std::atomic<bool> m_decodeThreadAlive; // Cleared by the thread when it exits
+    int m_inlineErrors; // Consecutive inline failures
+    bool m_decodeFailed;
+
+    PresentationClock m_clock;
+    bool m_lateFrameCounted;
+    int m_lateFrames;
+};
+
+} // namespace PixelMotion
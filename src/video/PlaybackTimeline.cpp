@@ -0,0 +1,39 @@
+#include "PlaybackTimeline.h"
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/avutil.h>
+}
+
+namespace PixelMotion {
+
+PlaybackTimeline::PlaybackTimeline()
+    : m_loopOffset(0)
+    , m_end(0)
+    , m_lastPts(AV_NOPTS_VALUE)
+{
+}
+
+void PlaybackTimeline::Reset() {
+    m_loopOffset = 0;
+    m_end = 0;
+    m_lastPts = AV_NOPTS_VALUE;
+}
+
+int64_t PlaybackTimeline::Place(int64_t relativePts, int64_t duration) {
+    int64_t pts = m_end;
+    if (relativePts != AV_NOPTS_VALUE) {
+        pts = m_loopOffset + relativePts;
+    }
+
+    if (m_lastPts != AV_NOPTS_VALUE && pts <= m_lastPts) {
+        pts = m_end;
+    }
+
+    m_lastPts = pts;
+    m_end = std::max(m_end, pts + duration);
+    return pts;
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace PixelMotion {
+
+/**
+ * Continuous presentation timeline of a looping stream
+ * Frames are placed at their time from the start of the stream plus the
+ * length of the loops played before, so timestamps keep increasing across
+ * loops and the presentation clock never has to be restarted to loop
+ * All times are in microseconds
+ */
+class PlaybackTimeline {
+public:
+    PlaybackTimeline();
+
+    /**
+     * Start over at zero (after opening or seeking)
+     */
+    void Reset();
+
+    /**
+     * Place the next frame on the timeline
+     * Missing (AV_NOPTS_VALUE) or non-monotonic timestamps continue after the previous frame
+     * @param relativePts Time from the start of the stream
+     * @return Timeline time at which the frame is presented
+     */
+    int64_t Place(int64_t relativePts, int64_t duration);
+
+    /**
+     * The stream restarts from its beginning; its frames follow the last one placed
+     */
+    void StartLoop() { m_loopOffset = m_end; }
+
+    /**
+     * Timeline time of the start of the current pass through the stream
+     */
+    int64_t GetLoopOffset() const { return m_loopOffset; }
+
+    /**
+     * End of the last frame placed
+     */
+    int64_t GetEnd() const { return m_end; }
+
+private:
+    int64_t m_loopOffset;
+    int64_t m_end;
+    int64_t m_lastPts;
+};
+
+} // namespace PixelMotion
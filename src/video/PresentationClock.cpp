@@ -0,0 +1,39 @@
+#include "PresentationClock.h"
+
+#include <chrono>
+
+namespace PixelMotion {
+
+PresentationClock::PresentationClock()
+    : m_anchorWallTime(0.0)
+    , m_anchorStreamTime(0.0)
+    , m_started(false)
+{
+}
+
+double PresentationClock::Now() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(now).count();
+}
+
+void PresentationClock::Start(double wallTime, double streamTime) {
+    m_anchorWallTime = wallTime;
+    m_anchorStreamTime = streamTime;
+    m_started = true;
+}
+
+void PresentationClock::Stop() {
+    m_started = false;
+}
+
+double PresentationClock::GetDueTime(double streamTime) const {
+    // Due times are derived from the anchor every time instead of being
+    // accumulated frame by frame, so rounding never adds up to drift
+    return m_anchorWallTime + (streamTime - m_anchorStreamTime);
+}
+
+double PresentationClock::GetStreamTime(double wallTime) const {
+    return m_anchorStreamTime + (wallTime - m_anchorWallTime);
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,42 @@
+#pragma once
+
+namespace PixelMotion {
+
+/**
+ * Maps stream time to wall-clock time for frame scheduling
+ * All times are in seconds; callers pass "now" explicitly so the clock
+ * can be driven by a virtual time source as well as the system clock
+ */
+class PresentationClock {
+public:
+    PresentationClock();
+
+    /**
+     * Monotonic system time in seconds
+     */
+    static double Now();
+
+    /**
+     * Anchor the clock so that streamTime is presented at wallTime
+     */
+    void Start(double wallTime, double streamTime);
+    void Stop();
+    bool IsStarted() const { return m_started; }
+
+    /**
+     * Wall-clock time at which a frame with the given stream time is due
+     */
+    double GetDueTime(double streamTime) const;
+
+    /**
+     * Stream time that should be on screen at the given wall-clock time
+     */
+    double GetStreamTime(double wallTime) const;
+
+private:
+    double m_anchorWallTime;
+    double m_anchorStreamTime;
+    bool m_started;
+};
+
+} // namespace PixelMotion
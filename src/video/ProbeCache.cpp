@@ -0,0 +1,145 @@
+#include "ProbeCache.h"
+#include "core/FileCache.h"
+#include "core/Logger.h"
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <nlohmann/json.hpp>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/mem.h>
+}
+
+using json = nlohmann::json;
+
+namespace PixelMotion {
+
+constexpr int PROBE_CACHE_VERSION = 1;
+constexpr const wchar_t* PROBE_CACHE_EXTENSION = L".probe.json";
+
+static bool LoadEntry(const std::wstring& filePath, ProbeCache::Entry* entry) {
+    std::filesystem::path cachePath = FileCache::GetEntryPath(filePath, PROBE_CACHE_EXTENSION);
+    if (cachePath.empty()) {
+        return false;
+    }
+
+    std::ifstream file(cachePath);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    try {
+        json j = json::parse(file);
+        if (j.value("version", 0) != PROBE_CACHE_VERSION) {
+            return false;
+        }
+
+        entry->streamIndex = j["streamIndex"].get<int>();
+        entry->codecId = j["codecId"].get<int>();
+        entry->format = j["format"].get<int>();
+        entry->width = j["width"].get<int>();
+        entry->height = j["height"].get<int>();
+        entry->profile = j["profile"].get<int>();
+        entry->level = j["level"].get<int>();
+        entry->frameRateNum = j["frameRateNum"].get<int>();
+        entry->frameRateDen = j["frameRateDen"].get<int>();
+        entry->streamStartTime = j["streamStartTime"].get<int64_t>();
+        entry->duration = j["duration"].get<int64_t>();
+        entry->isImage = j["isImage"].get<bool>();
+        entry->extradata = j["extradata"].get<std::vector<uint8_t>>();
+        return true;
+    } catch (const std::exception& e) {
+        Logger::Warning("Ignoring invalid probe cache entry: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool ProbeCache::Apply(const std::wstring& filePath, AVFormatContext* formatContext, Entry* entry) {
+    if (!LoadEntry(filePath, entry)) {
+        return false;
+    }
+
+    // The demuxer read the headers already; they must agree with the cache
+    if (entry->streamIndex < 0 || entry->streamIndex >= static_cast<int>(formatContext->nb_streams)) {
+        return false;
+    }
+
+    AVStream* stream = formatContext->streams[entry->streamIndex];
+    AVCodecParameters* codecpar = stream->codecpar;
+    if (codecpar->codec_type != AVMEDIA_TYPE_VIDEO || codecpar->codec_id != static_cast<AVCodecID>(entry->codecId)) {
+        return false;
+    }
+
+    codecpar->format = entry->format;
+    codecpar->width = entry->width;
+    codecpar->height = entry->height;
+    codecpar->profile = entry->profile;
+    codecpar->level = entry->level;
+
+    if (codecpar->extradata_size == 0 && !entry->extradata.empty()) {
+        size_t size = entry->extradata.size();
+        codecpar->extradata = static_cast<uint8_t*>(av_mallocz(size + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (!codecpar->extradata) {
+            return false;
+        }
+        std::memcpy(codecpar->extradata, entry->extradata.data(), size);
+        codecpar->extradata_size = static_cast<int>(size);
+    }
+
+    if (entry->frameRateNum > 0 && entry->frameRateDen > 0) {
+        stream->avg_frame_rate = AVRational{ entry->frameRateNum, entry->frameRateDen };
+    }
+    if (entry->streamStartTime != AV_NOPTS_VALUE) {
+        stream->start_time = entry->streamStartTime;
+    }
+    if (entry->duration != AV_NOPTS_VALUE) {
+        formatContext->duration = entry->duration;
+    }
+
+    return true;
+}
+
+void ProbeCache::Store(const std::wstring& filePath, const AVFormatContext* formatContext,
+                       int streamIndex, bool isImage) {
+    std::filesystem::path cachePath = FileCache::GetEntryPath(filePath, PROBE_CACHE_EXTENSION);
+    if (cachePath.empty()) {
+        return;
+    }
+
+    const AVStream* stream = formatContext->streams[streamIndex];
+    const AVCodecParameters* codecpar = stream->codecpar;
+
+    json j;
+    j["version"] = PROBE_CACHE_VERSION;
+    j["streamIndex"] = streamIndex;
+    j["codecId"] = static_cast<int>(codecpar->codec_id);
+    j["format"] = codecpar->format;
+    j["width"] = codecpar->width;
+    j["height"] = codecpar->height;
+    j["profile"] = codecpar->profile;
+    j["level"] = codecpar->level;
+    j["frameRateNum"] = stream->avg_frame_rate.num;
+    j["frameRateDen"] = stream->avg_frame_rate.den;
+    j["streamStartTime"] = stream->start_time;
+    j["duration"] = formatContext->duration;
+    j["isImage"] = isImage;
+    j["extradata"] = std::vector<uint8_t>(codecpar->extradata, codecpar->extradata + codecpar->extradata_size);
+
+    std::ofstream file(cachePath);
+    if (file.is_open()) {
+        file << j.dump();
+    }
+}
+
+void ProbeCache::Invalidate(const std::wstring& filePath) {
+    std::filesystem::path cachePath = FileCache::GetEntryPath(filePath, PROBE_CACHE_EXTENSION);
+    if (!cachePath.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(cachePath, ec);
+    }
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AVFormatContext;
+
+namespace PixelMotion {
+
+/**
+ * Persistent cache of stream probing results
+ * Reopening an unchanged file restores the video stream's parameters from
+ * here instead of running avformat_find_stream_info, which may decode
+ * several frames per stream
+ */
+class ProbeCache {
+public:
+    struct Entry {
+        int streamIndex = -1;
+        int codecId = 0;
+        int format = -1; // Pixel format
+        int width = 0;
+        int height = 0;
+        int profile = 0;
+        int level = 0;
+        int frameRateNum = 0;
+        int frameRateDen = 1;
+        int64_t streamStartTime = 0; // Stream time base, AV_NOPTS_VALUE if unknown
+        int64_t duration = 0;        // AV_TIME_BASE, AV_NOPTS_VALUE if unknown
+        bool isImage = false;
+        std::vector<uint8_t> extradata;
+    };
+
+    /**
+     * Restore cached parameters into a freshly opened format context
+     * @return false if there is no entry or it doesn't match the container
+     */
+    static bool Apply(const std::wstring& filePath, AVFormatContext* formatContext, Entry* entry);
+
+    /**
+     * Record the probed parameters of a video stream
+     */
+    static void Store(const std::wstring& filePath, const AVFormatContext* formatContext,
+                      int streamIndex, bool isImage);
+
+    static void Invalidate(const std::wstring& filePath);
+};
+
+} // namespace PixelMotion
@@ -0,0 +1,560 @@
+#include "ProxyTranscoder.h"
+#include "PresentationClock.h"
+#include "core/FileCache.h"
+#include "core/Logger.h"
+#include "core/TextEncoding.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <system_error>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+
+// Proxy heights; a monitor gets the smallest one that covers it
+constexpr int LADDER[] = { 720, 1080, 1440, 2160 };
+
+// Sources that loop back to a keyframe sooner than this don't need new GOPs
+constexpr double MAX_SOURCE_GOP_SECONDS = 2.0;
+
+// How much of the source is scanned for its keyframe spacing
+constexpr double GOP_SCAN_SECONDS = 20.0;
+
+// Proxy frames decoded to measure their cost
+constexpr int PROXY_MEASURE_FRAMES = 120;
+
+// Bitrate for encoders without a quality mode (bits per pixel per frame)
+constexpr double PROXY_BITS_PER_PIXEL = 0.08;
+
+static std::wstring GetProxyExtension(int rung) {
+    return L"." + std::to_wstring(rung) + L"p.mp4";
+}
+
+/**
+ * Encoders in order of preference; the native MPEG-4 encoder is always built
+ */
+static const AVCodec* FindEncoder() {
+    for (const char* name : { "libx264", "h264_mf", "libopenh264", "mpeg4" }) {
+        const AVCodec* codec = avcodec_find_encoder_by_name(name);
+        if (codec) {
+            return codec;
+        }
+    }
+    return nullptr;
+}
+
+static AVPixelFormat ChooseEncoderFormat(const AVCodec* codec) {
+    if (!codec->pix_fmts) {
+        return AV_PIX_FMT_YUV420P;
+    }
+    for (const AVPixelFormat* format = codec->pix_fmts; *format != AV_PIX_FMT_NONE; format++) {
+        if (*format == AV_PIX_FMT_YUV420P || *format == AV_PIX_FMT_NV12) {
+            return *format;
+        }
+    }
+    return codec->pix_fmts[0];
+}
+
+/**
+ * FFmpeg objects of one transcode, freed together
+ */
+struct TranscodeContext {
+    AVFormatContext* input = nullptr;
+    AVCodecContext* decoder = nullptr;
+    AVFormatContext* output = nullptr;
+    AVCodecContext* encoder = nullptr;
+    SwsContext* scaler = nullptr;
+    AVFrame* decoded = nullptr;
+    AVFrame* scaled = nullptr;
+    AVPacket* packet = nullptr;
+
+    ~TranscodeContext() {
+        av_packet_free(&packet);
+        av_frame_free(&scaled);
+        av_frame_free(&decoded);
+        sws_freeContext(scaler);
+        avcodec_free_context(&encoder);
+        if (output) {
+            if (!(output->oformat->flags & AVFMT_NOFILE)) {
+                avio_closep(&output->pb);
+            }
+            avformat_free_context(output);
+        }
+        avcodec_free_context(&decoder);
+        avformat_close_input(&input);
+    }
+};
+
+/**
+ * Longest keyframe interval in the first seconds of a stream (seconds)
+ * Reads from the input's current position; RewindInput goes back afterwards
+ */
+static double MeasureLongestGop(AVFormatContext* input, int streamIndex, AVPacket* packet) {
+    AVStream* stream = input->streams[streamIndex];
+    double timeBase = av_q2d(stream->time_base);
+    int64_t start = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+
+    double longest = 0.0;
+    double lastKeyframe = -1.0;
+    double position = 0.0;
+    while (position < GOP_SCAN_SECONDS && av_read_frame(input, packet) >= 0) {
+        if (packet->stream_index == streamIndex && packet->pts != AV_NOPTS_VALUE) {
+            position = (packet->pts - start) * timeBase;
+            if (packet->flags & AV_PKT_FLAG_KEY) {
+                if (lastKeyframe >= 0.0) {
+                    longest = std::max(longest, position - lastKeyframe);
+                }
+                lastKeyframe = position;
+            }
+        }
+        av_packet_unref(packet);
+    }
+
+    // No second keyframe seen: the GOP is at least as long as the scan
+    if (lastKeyframe <= 0.0) {
+        longest = std::max(longest, position);
+    }
+
+    return longest;
+}
+
+/**
+ * Seek back to the start of a stream, reopening the file if the demuxer can't seek
+ * Invalidates the input's stream pointers when it reopens
+ */
+static bool RewindInput(AVFormatContext*& input, const std::string& path, int streamIndex) {
+    AVStream* stream = input->streams[streamIndex];
+    int64_t start = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+    if (av_seek_frame(input, streamIndex, start, AVSEEK_FLAG_BACKWARD) >= 0) {
+        return true;
+    }
+
+    avformat_close_input(&input);
+    return avformat_open_input(&input, path.c_str(), nullptr, nullptr) >= 0 &&
+           avformat_find_stream_info(input, nullptr) >= 0 &&
+           streamIndex < static_cast<int>(input->nb_streams);
+}
+
+/**
+ * Average single-threaded decode time of a file's first frames (seconds per frame)
+ */
+static double MeasureDecodeTime(const std::string& path) {
+    TranscodeContext ctx;
+    if (avformat_open_input(&ctx.input, path.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(ctx.input, nullptr) < 0) {
+        return 0.0;
+    }
+
+    const AVCodec* codec = nullptr;
+    int streamIndex = av_find_best_stream(ctx.input, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (streamIndex < 0 || !codec) {
+        return 0.0;
+    }
+
+    ctx.decoder = avcodec_alloc_context3(codec);
+    ctx.decoded = av_frame_alloc();
+    ctx.packet = av_packet_alloc();
+    if (!ctx.decoder || !ctx.decoded || !ctx.packet ||
+        avcodec_parameters_to_context(ctx.decoder, ctx.input->streams[streamIndex]->codecpar) < 0) {
+        return 0.0;
+    }
+    ctx.decoder->thread_count = 1;
+    if (avcodec_open2(ctx.decoder, codec, nullptr) < 0) {
+        return 0.0;
+    }
+
+    int frames = 0;
+    double decodeTime = 0.0;
+    while (frames < PROXY_MEASURE_FRAMES && av_read_frame(ctx.input, ctx.packet) >= 0) {
+        if (ctx.packet->stream_index == streamIndex) {
+            double startTime = PresentationClock::Now();
+            if (avcodec_send_packet(ctx.decoder, ctx.packet) >= 0) {
+                while (avcodec_receive_frame(ctx.decoder, ctx.decoded) >= 0) {
+                    frames++;
+                }
+            }
+            decodeTime += PresentationClock::Now() - startTime;
+        }
+        av_packet_unref(ctx.packet);
+    }
+
+    return frames > 0 ? decodeTime / frames : 0.0;
+}
+
+ProxyTranscoder& ProxyTranscoder::GetInstance() {
+    static ProxyTranscoder instance;
+    return instance;
+}
+
+ProxyTranscoder::~ProxyTranscoder() {
+    Shutdown();
+}
+
+int ProxyTranscoder::GetRung(int monitorHeight) {
+    for (int rung : LADDER) {
+        if (rung >= monitorHeight) {
+            return rung;
+        }
+    }
+    return 0;
+}
+
+std::wstring ProxyTranscoder::FindProxy(const std::wstring& sourcePath, int rung) {
+    if (rung <= 0) {
+        return {};
+    }
+
+    std::filesystem::path proxyPath = FileCache::GetEntryPath(sourcePath, GetProxyExtension(rung));
+    std::error_code ec;
+    if (proxyPath.empty() || !std::filesystem::exists(proxyPath, ec)) {
+        return {};
+    }
+    return proxyPath.wstring();
+}
+
+void ProxyTranscoder::Request(const std::wstring& sourcePath, int rung) {
+    if (rung <= 0 || !FindProxy(sourcePath, rung).empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        return;
+    }
+
+    for (const Job& job : m_jobs) {
+        if (job.sourcePath == sourcePath && job.rung == rung) {
+            return;
+        }
+    }
+    m_jobs.push_back({ sourcePath, rung });
+
+    if (!m_worker.joinable()) {
+        m_worker = std::thread(&ProxyTranscoder::WorkerMain, this);
+    }
+    m_wakeup.notify_one();
+}
+
+std::vector<std::wstring> ProxyTranscoder::TakeFinished() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::wstring> finished;
+    finished.swap(m_finished);
+    return finished;
+}
+
+void ProxyTranscoder::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+    }
+    m_wakeup.notify_all();
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void ProxyTranscoder::WorkerMain() {
+    // Background mode also lowers I/O and memory priority; codecs run on this
+    // thread only, so all transcoding happens at idle priority
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+
+    // Sources already checked this session, proxy made or not
+    std::vector<std::wstring> checked;
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping) {
+                return;
+            }
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        std::wstring jobKey = job.sourcePath + L"|" + std::to_wstring(job.rung);
+        if (std::find(checked.begin(), checked.end(), jobKey) != checked.end()) {
+            continue;
+        }
+        checked.push_back(jobKey);
+
+        if (Transcode(job)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished.push_back(job.sourcePath);
+        }
+    }
+}
+
+bool ProxyTranscoder::Transcode(const Job& job) {
+    std::filesystem::path proxyPath = FileCache::GetEntryPath(job.sourcePath, GetProxyExtension(job.rung));
+    if (proxyPath.empty()) {
+        return false;
+    }
+
+    std::string sourcePath = ToUtf8(job.sourcePath);
+    TranscodeContext ctx;
+    ctx.packet = av_packet_alloc();
+    ctx.decoded = av_frame_alloc();
+    ctx.scaled = av_frame_alloc();
+    if (!ctx.packet || !ctx.decoded || !ctx.scaled) {
+        return false;
+    }
+
+    if (avformat_open_input(&ctx.input, sourcePath.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(ctx.input, nullptr) < 0) {
+        Logger::Warning("Proxy: could not open " + sourcePath);
+        return false;
+    }
+
+    const AVCodec* decoderCodec = nullptr;
+    int streamIndex = av_find_best_stream(ctx.input, AVMEDIA_TYPE_VIDEO, -1, -1, &decoderCodec, 0);
+    if (streamIndex < 0 || !decoderCodec) {
+        return false;
+    }
+    AVStream* sourceStream = ctx.input->streams[streamIndex];
+    const AVCodecParameters* sourceParams = sourceStream->codecpar;
+
+    // Stills and animated images are never decoded continuously
+    AVCodecID codecId = sourceParams->codec_id;
+    bool image = codecId == AV_CODEC_ID_GIF || codecId == AV_CODEC_ID_APNG || codecId == AV_CODEC_ID_WEBP ||
+                 codecId == AV_CODEC_ID_PNG || codecId == AV_CODEC_ID_MJPEG || codecId == AV_CODEC_ID_BMP ||
+                 codecId == AV_CODEC_ID_TIFF || codecId == AV_CODEC_ID_JPEG2000;
+    double duration = (ctx.input->duration != AV_NOPTS_VALUE) ? static_cast<double>(ctx.input->duration) / AV_TIME_BASE : 0.0;
+    if (image || duration < 1.0 || sourceParams->width <= 0 || sourceParams->height <= 0) {
+        return false;
+    }
+
+    // A proxy only pays off if it is smaller, loops to a keyframe sooner or drops B-frames
+    double longestGop = MeasureLongestGop(ctx.input, streamIndex, ctx.packet);
+    if (!RewindInput(ctx.input, sourcePath, streamIndex)) {
+        Logger::Warning("Proxy: could not rewind " + sourcePath);
+        return false;
+    }
+    sourceStream = ctx.input->streams[streamIndex];
+    sourceParams = sourceStream->codecpar;
+    bool downscale = sourceParams->height > job.rung;
+    bool longGop = longestGop > MAX_SOURCE_GOP_SECONDS;
+    bool reordered = sourceParams->video_delay > 0;
+    if (!downscale && !longGop && !reordered) {
+        Logger::Info("Proxy: " + sourcePath + " is already suited to looping at " + std::to_string(job.rung) + "p");
+        return false;
+    }
+
+    const AVCodec* encoderCodec = FindEncoder();
+    if (!encoderCodec) {
+        Logger::Warning("Proxy: no video encoder available");
+        return false;
+    }
+
+    // Decoder
+    ctx.decoder = avcodec_alloc_context3(decoderCodec);
+    if (!ctx.decoder || avcodec_parameters_to_context(ctx.decoder, sourceParams) < 0) {
+        return false;
+    }
+    ctx.decoder->thread_count = 1; // Codec threads wouldn't run at idle priority
+    if (avcodec_open2(ctx.decoder, decoderCodec, nullptr) < 0) {
+        Logger::Warning("Proxy: could not open decoder for " + sourcePath);
+        return false;
+    }
+
+    // Proxy geometry: the rung's height (never upscaled), even dimensions
+    int height = std::min(job.rung, sourceParams->height) & ~1;
+    int width = static_cast<int>(static_cast<int64_t>(sourceParams->width) * height / sourceParams->height + 1) & ~1;
+    AVRational frameRate = sourceStream->avg_frame_rate;
+    if (frameRate.num <= 0 || frameRate.den <= 0) {
+        frameRate = sourceStream->r_frame_rate;
+    }
+    if (frameRate.num <= 0 || frameRate.den <= 0) {
+        frameRate = AVRational{ 30, 1 };
+    }
+    int gopSize = std::max(1, static_cast<int>(std::lround(av_q2d(frameRate))));
+
+    // Encoder: one-second closed GOPs from the first frame, so every loop and
+    // seek lands on a keyframe, and no B-frames to reorder
+    ctx.encoder = avcodec_alloc_context3(encoderCodec);
+    if (!ctx.encoder) {
+        return false;
+    }
+    ctx.encoder->width = width;
+    ctx.encoder->height = height;
+    ctx.encoder->pix_fmt = ChooseEncoderFormat(encoderCodec);
+    ctx.encoder->time_base = av_inv_q(frameRate);
+    ctx.encoder->framerate = frameRate;
+    ctx.encoder->sample_aspect_ratio = sourceParams->sample_aspect_ratio;
+    ctx.encoder->gop_size = gopSize;
+    ctx.encoder->keyint_min = gopSize;
+    ctx.encoder->max_b_frames = 0;
+    ctx.encoder->flags |= AV_CODEC_FLAG_CLOSED_GOP;
+    ctx.encoder->thread_count = 1;
+    ctx.encoder->color_range = sourceParams->color_range;
+    ctx.encoder->color_primaries = sourceParams->color_primaries;
+    ctx.encoder->color_trc = sourceParams->color_trc;
+    ctx.encoder->colorspace = sourceParams->color_space;
+    if (std::string(encoderCodec->name) == "libx264") {
+        av_opt_set(ctx.encoder->priv_data, "preset", "medium", 0);
+        av_opt_set(ctx.encoder->priv_data, "crf", "20", 0);
+    } else {
+        ctx.encoder->bit_rate = static_cast<int64_t>(width * static_cast<double>(height) * av_q2d(frameRate) *
+                                                     PROXY_BITS_PER_PIXEL);
+    }
+
+    // Output goes to a temporary name and is renamed once complete
+    std::filesystem::path partPath = proxyPath;
+    partPath += L".part";
+    std::string outputPath = ToUtf8(partPath.wstring());
+    if (avformat_alloc_output_context2(&ctx.output, nullptr, "mp4", outputPath.c_str()) < 0 || !ctx.output) {
+        return false;
+    }
+    if (ctx.output->oformat->flags & AVFMT_GLOBALHEADER) {
+        ctx.encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    if (avcodec_open2(ctx.encoder, encoderCodec, nullptr) < 0) {
+        Logger::Warning("Proxy: could not open encoder " + std::string(encoderCodec->name));
+        return false;
+    }
+
+    AVStream* proxyStream = avformat_new_stream(ctx.output, nullptr);
+    if (!proxyStream || avcodec_parameters_from_context(proxyStream->codecpar, ctx.encoder) < 0) {
+        return false;
+    }
+    proxyStream->time_base = ctx.encoder->time_base;
+    proxyStream->avg_frame_rate = frameRate;
+
+    if (avio_open(&ctx.output->pb, outputPath.c_str(), AVIO_FLAG_WRITE) < 0) {
+        Logger::Warning("Proxy: could not create " + outputPath);
+        return false;
+    }
+
+    // Index up front so opening the proxy needs no seek to the end
+    AVDictionary* muxerOptions = nullptr;
+    av_dict_set(&muxerOptions, "movflags", "+faststart", 0);
+    int ret = avformat_write_header(ctx.output, &muxerOptions);
+    av_dict_free(&muxerOptions);
+    if (ret < 0) {
+        return false;
+    }
+
+    ctx.scaled->format = ctx.encoder->pix_fmt;
+    ctx.scaled->width = width;
+    ctx.scaled->height = height;
+    if (av_frame_get_buffer(ctx.scaled, 0) < 0) {
+        return false;
+    }
+
+    Logger::Info("Proxy: transcoding " + sourcePath + " to " + std::to_string(width) + "x" + std::to_string(height) +
+                 " with " + encoderCodec->name + " (source GOP up to " + std::to_string(longestGop) + " s)");
+
+    int64_t framesEncoded = 0;
+    int64_t framesDecoded = 0;
+    double decodeTime = 0.0;
+    bool failed = false;
+
+    // Sends one frame (or nullptr to flush) and writes whatever the encoder returns
+    auto encode = [&](AVFrame* frame) {
+        if (avcodec_send_frame(ctx.encoder, frame) < 0) {
+            failed = true;
+            return;
+        }
+        AVPacket* encoded = ctx.packet;
+        while (avcodec_receive_packet(ctx.encoder, encoded) >= 0) {
+            av_packet_rescale_ts(encoded, ctx.encoder->time_base, proxyStream->time_base);
+            encoded->stream_index = proxyStream->index;
+            if (av_interleaved_write_frame(ctx.output, encoded) < 0) {
+                failed = true;
+            }
+        }
+    };
+
+    auto convert = [&]() {
+        ctx.scaler = sws_getCachedContext(ctx.scaler,
+                                          ctx.decoded->width, ctx.decoded->height, (AVPixelFormat)ctx.decoded->format,
+                                          width, height, ctx.encoder->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (!ctx.scaler || av_frame_make_writable(ctx.scaled) < 0) {
+            failed = true;
+            return;
+        }
+        sws_scale(ctx.scaler, ctx.decoded->data, ctx.decoded->linesize, 0, ctx.decoded->height,
+                  ctx.scaled->data, ctx.scaled->linesize);
+
+        // Constant frame rate timeline; the first frame opens the loop with a keyframe
+        ctx.scaled->pts = framesEncoded++;
+        ctx.scaled->pict_type = (ctx.scaled->pts == 0) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+        encode(ctx.scaled);
+    };
+
+    auto decode = [&](const AVPacket* packet) {
+        double startTime = PresentationClock::Now();
+        int sent = avcodec_send_packet(ctx.decoder, packet);
+        while (sent >= 0 && !failed) {
+            if (avcodec_receive_frame(ctx.decoder, ctx.decoded) < 0) {
+                break;
+            }
+            decodeTime += PresentationClock::Now() - startTime;
+            framesDecoded++;
+            convert();
+            av_frame_unref(ctx.decoded);
+            startTime = PresentationClock::Now();
+        }
+        decodeTime += PresentationClock::Now() - startTime;
+    };
+
+    AVPacket* sourcePacket = av_packet_alloc();
+    while (sourcePacket && !failed && !m_stopping && av_read_frame(ctx.input, sourcePacket) >= 0) {
+        if (sourcePacket->stream_index == streamIndex) {
+            decode(sourcePacket);
+        }
+        av_packet_unref(sourcePacket);
+    }
+    av_packet_free(&sourcePacket);
+
+    if (!failed && !m_stopping) {
+        decode(nullptr);
+        encode(nullptr);
+    }
+
+    bool complete = !failed && !m_stopping && framesEncoded > 0 && av_write_trailer(ctx.output) >= 0;
+    avio_closep(&ctx.output->pb);
+
+    std::error_code ec;
+    if (!complete) {
+        std::filesystem::remove(partPath, ec);
+        if (!m_stopping) {
+            Logger::Warning("Proxy: transcoding failed for " + sourcePath);
+        }
+        return false;
+    }
+
+    std::filesystem::rename(partPath, proxyPath, ec);
+    if (ec) {
+        std::filesystem::remove(partPath, ec);
+        return false;
+    }
+
+    // Same single-threaded measurement for both, so the ratio is the saving
+    double sourceCost = framesDecoded > 0 ? decodeTime / framesDecoded : 0.0;
+    double proxyCost = MeasureDecodeTime(ToUtf8(proxyPath.wstring()));
+    uintmax_t sourceBytes = std::filesystem::file_size(job.sourcePath, ec);
+    uintmax_t proxyBytes = std::filesystem::file_size(proxyPath, ec);
+    std::string saving = (sourceCost > 0.0 && proxyCost > 0.0)
+        ? std::to_string(static_cast<int>(std::lround((1.0 - proxyCost / sourceCost) * 100.0))) + "% less"
+        : "not measured";
+    Logger::Info("Proxy: finished " + sourcePath + " at " + std::to_string(job.rung) + "p, decode " +
+                 std::to_string(sourceCost * 1000.0) + " -> " + std::to_string(proxyCost * 1000.0) +
+                 " ms/frame (" + saving + "), " + std::to_string(sourceBytes / (1024 * 1024)) + " -> " +
+                 std::to_string(proxyBytes / (1024 * 1024)) + " MB");
+    return true;
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PixelMotion {
+
+/**
+ * Background transcoder that turns large or long-GOP videos into proxies
+ * made for looping wallpapers: one-second closed GOPs starting at the loop
+ * point, no B-frames, moov atom up front, and scaled down to a rung of a
+ * resolution ladder that covers the monitor. Proxies live in the file
+ * cache next to the other per-file entries, keyed by the source's
+ * identity, and VideoDecoder opens them in place of the source.
+ * Work runs on one idle-priority thread with single-threaded codecs, so it
+ * only uses otherwise idle CPU time
+ */
+class ProxyTranscoder {
+public:
+    static ProxyTranscoder& GetInstance();
+
+    /**
+     * Ladder rung (proxy height) for a monitor, the smallest one at least as tall
+     * @return 0 if the monitor is taller than every rung
+     */
+    static int GetRung(int monitorHeight);
+
+    /**
+     * Finished proxy of a file for a rung
+     * @return empty if none has been made for the file's current contents
+     */
+    static std::wstring FindProxy(const std::wstring& sourcePath, int rung);
+
+    /**
+     * Queue a proxy for a file unless it exists or wouldn't be cheaper to decode
+     */
+    void Request(const std::wstring& sourcePath, int rung);
+
+    /**
+     * Sources whose proxies were finished since the last call
+     */
+    std::vector<std::wstring> TakeFinished();
+
+    /**
+     * Stop the worker; a proxy in progress is abandoned
+     */
+    void Shutdown();
+
+private:
+    struct Job {
+        std::wstring sourcePath;
+        int rung;
+    };
+
+    ProxyTranscoder() = default;
+    ~ProxyTranscoder();
+
+    void WorkerMain();
+    bool Transcode(const Job& job);
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<Job> m_jobs;
+    std::vector<std::wstring> m_finished;
+    std::atomic<bool> m_stopping{false};
+};
+
+} // namespace PixelMotion
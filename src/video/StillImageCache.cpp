@@ -0,0 +1,199 @@
+#include "StillImageCache.h"
+#include "core/FileCache.h"
+#include "core/Logger.h"
+
+#include <iomanip>
+#include <sstream>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+
+StillImage::StillImage(ComPtr<ID3D11Texture2D> texture, int width, int height)
+    : m_texture(std::move(texture))
+    , m_width(width)
+    , m_height(height)
+{
+}
+
+StillImageCache& StillImageCache::GetInstance() {
+    static StillImageCache instance;
+    return instance;
+}
+
+StillImageCache::~StillImageCache() {
+    ReleaseSources();
+}
+
+std::shared_ptr<StillImage> StillImageCache::Acquire(const std::wstring& filePath, ID3D11Device* device,
+                                                     int targetWidth, int targetHeight, int scalingMode) {
+    uint64_t fileKey = FileCache::ComputeKey(filePath);
+    if (fileKey == 0) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PruneExpired();
+
+    auto it = m_sources.find(fileKey);
+    const AVFrame* frame = (it != m_sources.end()) ? it->second.Get() : nullptr;
+    return FindOrConvert(fileKey, device, frame, targetWidth, targetHeight, scalingMode);
+}
+
+std::shared_ptr<StillImage> StillImageCache::Create(const std::wstring& filePath, ID3D11Device* device,
+                                                    const FrameHandle& frame, int targetWidth, int targetHeight,
+                                                    int scalingMode) {
+    uint64_t fileKey = FileCache::ComputeKey(filePath);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    PruneExpired();
+
+    // Keep the decoded pixels (by reference) for monitors that still need them
+    if (fileKey != 0 && frame && m_sources.find(fileKey) == m_sources.end()) {
+        m_sources[fileKey] = frame;
+    }
+
+    return FindOrConvert(fileKey, device, frame.Get(), targetWidth, targetHeight, scalingMode);
+}
+
+void StillImageCache::ReleaseSources() {
+    // A background load converting an image holds the lock; try again next tick
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_sources.empty()) {
+        return;
+    }
+
+    m_sources.clear();
+    Logger::Info("Released decoded still image sources");
+}
+
+std::shared_ptr<StillImage> StillImageCache::FindOrConvert(uint64_t fileKey, ID3D11Device* device, const AVFrame* frame,
+                                                           int targetWidth, int targetHeight, int scalingMode) {
+    std::ostringstream keyStream;
+    keyStream << std::hex << std::setw(16) << std::setfill('0') << fileKey << std::dec
+              << "|" << targetWidth << "x" << targetHeight << "|" << scalingMode;
+    std::string key = keyStream.str();
+
+    // An unidentifiable file is never shared
+    if (fileKey != 0) {
+        auto it = m_images.find(key);
+        if (it != m_images.end()) {
+            if (auto image = it->second.lock()) {
+                Logger::Info("Sharing still image, now used by " + std::to_string(image.use_count()) + " windows");
+                return image;
+            }
+        }
+    }
+
+    if (!frame || !device) {
+        return nullptr;
+    }
+
+    OutputLayout layout = OutputLayout::Compute(frame->width, frame->height, targetWidth, targetHeight, scalingMode, true);
+    auto image = Convert(device, frame, layout);
+    if (!image) {
+        return nullptr;
+    }
+
+    if (fileKey != 0) {
+        m_images[key] = image;
+    }
+
+    size_t totalBytes = 0;
+    for (const auto& entry : m_images) {
+        if (auto shared = entry.second.lock()) {
+            totalBytes += shared->GetByteSize();
+        }
+    }
+    Logger::Info("Still image " + std::to_string(frame->width) + "x" + std::to_string(frame->height) +
+                 " converted to " + std::to_string(layout.width) + "x" + std::to_string(layout.height) +
+                 " (" + std::to_string(image->GetByteSize() / 1024) + " KB, " +
+                 std::to_string(totalBytes / 1024) + " KB for all still images)");
+    return image;
+}
+
+std::shared_ptr<StillImage> StillImageCache::Convert(ID3D11Device* device, const AVFrame* frame, const OutputLayout& layout) {
+    // Crop by offsetting plane pointers on a new reference; the source stays intact
+    AVFrame* cropped = av_frame_clone(frame);
+    if (!cropped) {
+        return nullptr;
+    }
+    cropped->crop_left = layout.cropX;
+    cropped->crop_top = layout.cropY;
+    cropped->crop_right = frame->width - layout.cropX - layout.cropWidth;
+    cropped->crop_bottom = frame->height - layout.cropY - layout.cropHeight;
+    if (av_frame_apply_cropping(cropped, AV_FRAME_CROP_UNALIGNED) < 0) {
+        Logger::Error("Failed to crop still image");
+        av_frame_free(&cropped);
+        return nullptr;
+    }
+
+    SwsContext* swsContext = sws_getContext(
+        cropped->width, cropped->height, static_cast<AVPixelFormat>(cropped->format),
+        layout.width, layout.height, AV_PIX_FMT_BGRA,
+        SWS_BICUBIC, nullptr, nullptr, nullptr
+    );
+    if (!swsContext) {
+        Logger::Error("Failed to create swscale context for still image");
+        av_frame_free(&cropped);
+        return nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width = layout.width;
+    texDesc.Height = layout.height;
+    texDesc.MipLevels = 1;
+    texDesc.ArraySize = 1;
+    texDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Usage = D3D11_USAGE_DYNAMIC;
+    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    ComPtr<ID3D11Texture2D> texture;
+    HRESULT hr = device->CreateTexture2D(&texDesc, nullptr, &texture);
+    if (FAILED(hr)) {
+        Logger::Error("Failed to create still image texture: " + std::to_string(hr));
+        sws_freeContext(swsContext);
+        av_frame_free(&cropped);
+        return nullptr;
+    }
+
+    ComPtr<ID3D11DeviceContext> context;
+    device->GetImmediateContext(&context);
+
+    // Convert and scale straight into the texture, without a staging copy
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = context->Map(texture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    if (SUCCEEDED(hr)) {
+        uint8_t* dstData[1] = { static_cast<uint8_t*>(mapped.pData) };
+        int dstLinesize[1] = { static_cast<int>(mapped.RowPitch) };
+        sws_scale(swsContext, cropped->data, cropped->linesize, 0, cropped->height, dstData, dstLinesize);
+        context->Unmap(texture.Get(), 0);
+    }
+
+    sws_freeContext(swsContext);
+    av_frame_free(&cropped);
+
+    if (FAILED(hr)) {
+        Logger::Error("Failed to map still image texture: " + std::to_string(hr));
+        return nullptr;
+    }
+
+    return std::make_shared<StillImage>(texture, layout.width, layout.height);
+}
+
+void StillImageCache::PruneExpired() {
+    for (auto it = m_images.begin(); it != m_images.end();) {
+        if (it->second.expired()) {
+            it = m_images.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace PixelMotion
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "FrameHandle.h"
+#include "OutputLayout.h"
+
+using Microsoft::WRL::ComPtr;
+
+struct AVFrame;
+
+namespace PixelMotion {
+
+/**
+ * A still image converted to BGRA at the size it is displayed at
+ * Holds no decoder state, only the texture
+ */
+class StillImage {
+public:
+    StillImage(ComPtr<ID3D11Texture2D> texture, int width, int height);
+
+    ID3D11Texture2D* GetTexture() const { return m_texture.Get(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    size_t GetByteSize() const { return static_cast<size_t>(m_width) * m_height * 4; }
+
+private:
+    ComPtr<ID3D11Texture2D> m_texture;
+    int m_width;
+    int m_height;
+};
+
+/**
+ * Shares still image wallpapers between windows
+ * Images are converted once per file, monitor size and scaling mode, cropped
+ * and downscaled to what is actually visible, and live as long as any window
+ * holds them. The decoded source frame is kept only until ReleaseSources, so
+ * monitors of different sizes are served from a single decode
+ */
+class StillImageCache {
+public:
+    static StillImageCache& GetInstance();
+
+    /**
+     * Get an image already converted for this monitor, or convert it from a
+     * recently decoded source frame
+     * @return nullptr if the file hasn't been decoded since the last ReleaseSources
+     */
+    std::shared_ptr<StillImage> Acquire(const std::wstring& filePath, ID3D11Device* device,
+                                        int targetWidth, int targetHeight, int scalingMode);
+
+    /**
+     * Convert a freshly decoded frame for this monitor and keep a reference
+     * to it for other monitors until ReleaseSources
+     */
+    std::shared_ptr<StillImage> Create(const std::wstring& filePath, ID3D11Device* device, const FrameHandle& frame,
+                                       int targetWidth, int targetHeight, int scalingMode);
+
+    /**
+     * Drop the decoded source frames (main thread, once wallpapers are set)
+     * Does nothing while another thread is converting an image
+     */
+    void ReleaseSources();
+
+private:
+    StillImageCache() = default;
+    ~StillImageCache();
+
+    static std::shared_ptr<StillImage> Convert(ID3D11Device* device, const AVFrame* frame, const OutputLayout& layout);
+    std::shared_ptr<StillImage> FindOrConvert(uint64_t fileKey, ID3D11Device* device, const AVFrame* frame,
+                                              int targetWidth, int targetHeight, int scalingMode);
+    void PruneExpired();
+
+    std::map<std::string, std::weak_ptr<StillImage>> m_images; // Keyed by file, monitor size and scaling mode
+    std::map<uint64_t, FrameHandle> m_sources;                 // Keyed by FileCache::ComputeKey
+    std::mutex m_mutex;
+};
+
+} // namespace PixelMotion
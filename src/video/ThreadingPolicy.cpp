@@ -0,0 +1,85 @@
+#include "ThreadingPolicy.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace PixelMotion {
+
+// FFmpeg's frame threading stops scaling (and some decoders cap out) beyond this
+constexpr int MAX_DECODE_THREADS = 16;
+
+// Below 720p the per-thread setup cost outweighs extra parallelism
+constexpr int SMALL_FRAME_AREA = 1280 * 720;
+constexpr int SMALL_FRAME_MAX_THREADS = 4;
+
+// Output pixels per conversion band; smaller bands cost more in wakeups than
+// they save (1080p gets 3 bands, 1440p 7, 4K up to 16)
+constexpr int MIN_BAND_AREA = 512 * 1024;
+
+ThreadingPolicy::Choice ThreadingPolicy::Choose(const AVCodec* codec, int width, int height, int activeStreams, bool onBattery) {
+    Choice choice;
+    if (!codec) {
+        return choice;
+    }
+
+    bool frameThreads = (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) != 0;
+    bool sliceThreads = (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) != 0;
+    if (!frameThreads && !sliceThreads) {
+        return choice;
+    }
+
+    // Leave one core for the main loop and compositor, split the rest between streams
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores <= 0) {
+        cores = 2;
+    }
+    int count = std::max(1, (cores - 1) / std::max(1, activeStreams));
+
+    if (onBattery) {
+        count = std::max(1, count / 2);
+    }
+
+    int maxThreads = (width * height <= SMALL_FRAME_AREA) ? SMALL_FRAME_MAX_THREADS : MAX_DECODE_THREADS;
+    choice.threadCount = std::min(count, maxThreads);
+
+    // Frame threading scales best but keeps a frame in flight per thread;
+    // on battery slice threading wakes fewer threads and holds less memory.
+    // The decode-ahead queue absorbs the extra latency either way
+    if (frameThreads && (!onBattery || !sliceThreads)) {
+        choice.threadType = FF_THREAD_FRAME;
+    } else {
+        choice.threadType = FF_THREAD_SLICE;
+    }
+
+    if (choice.threadCount == 1) {
+        choice.threadType = 0;
+    }
+
+    return choice;
+}
+
+int ThreadingPolicy::ChooseConversionBands(int outputWidth, int outputHeight, int threads, bool onBattery) {
+    int64_t area = static_cast<int64_t>(outputWidth) * outputHeight;
+    int bands = static_cast<int>(std::min<int64_t>(area / MIN_BAND_AREA, threads));
+
+    if (onBattery) {
+        bands /= 2;
+    }
+
+    return std::max(1, bands);
+}
+
+const char* ThreadingPolicy::GetTypeName(int threadType) {
+    switch (threadType) {
+        case FF_THREAD_FRAME: return "frame";
+        case FF_THREAD_SLICE: return "slice";
+        default: return "none";
+    }
+}
+
+} // namespace PixelMotion
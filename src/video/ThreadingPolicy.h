@@ -0,0 +1,33 @@
+#pragma once
+
+struct AVCodec;
+
+namespace PixelMotion {
+
+/**
+ * Picks FFmpeg threading for software decoding from the machine and the
+ * current workload, so several wallpapers don't oversubscribe the CPU
+ */
+class ThreadingPolicy {
+public:
+    struct Choice {
+        int threadCount = 1;
+        int threadType = 0; // FF_THREAD_FRAME or FF_THREAD_SLICE
+    };
+
+    /**
+     * @param activeStreams Videos decoding at the same time, including this one
+     * @param onBattery Favor fewer wakeups and less memory over throughput
+     */
+    static Choice Choose(const AVCodec* codec, int width, int height, int activeStreams, bool onBattery);
+
+    /**
+     * Horizontal bands to split a software frame conversion into
+     * @param threads Threads the conversion pool can run at once
+     */
+    static int ChooseConversionBands(int outputWidth, int outputHeight, int threads, bool onBattery);
+
+    static const char* GetTypeName(int threadType);
+};
+
+} // namespace PixelMotion
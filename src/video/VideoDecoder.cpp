@@ -1,8 +1,23 @@
 #include "VideoDecoder.h"
+#include "ClipInput.h"
+#include "ConversionPool.h"
+#include "FrameConverter.h"
+#include "FramePool.h"
+#include "FrameQueue.h"
+#include "MappedFileInput.h"
+#include "OutputLayout.h"
+#include "PlaybackScheduler.h"
+#include "PlaybackTimeline.h"
+#include "ProbeCache.h"
+#include "ProxyTranscoder.h"
+#include "core/FileCache.h"
 #include "core/Logger.h"
+#include "core/TextEncoding.h"
 
-#include <codecvt>
-#include <locale>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <system_error>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -10,21 +25,65 @@ extern "C" {
 #include <libavutil/hwcontext.h>
 #include <libavutil/hwcontext_d3d11va.h>
 #include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
+#include <libavutil/pixdesc.h>
 }
 
 namespace PixelMotion {
 
+// Frames decoded ahead of presentation (~160ms at 30 FPS)
+constexpr size_t FRAME_QUEUE_DEPTH = 5;
+
+// Low power mode decodes at 1/2^n resolution where the codec supports it
+constexpr int LOW_POWER_LOWRES = 1;
+
+// Software conversion cost is logged once per this many converted frames
+constexpr int CONVERSION_STATS_INTERVAL = 300;
+
+static double ToSeconds(int64_t timelineTime) {
+    return static_cast<double>(timelineTime) / AV_TIME_BASE;
+}
+
 VideoDecoder::VideoDecoder()
     : m_formatContext(nullptr)
     , m_codecContext(nullptr)
     , m_frame(nullptr)
+    , m_decodeFrame(nullptr)
     , m_packet(nullptr)
+    , m_packetPending(false)
+    , m_decodeState(DecodeState::Decoding)
     , m_hwDeviceCtx(nullptr)
-    , m_swsContext(nullptr)
-    , m_rgbaFrame(nullptr)
     , m_device(nullptr)
     , m_textureUploaded(false)
+    , m_frameSerial(0)
+    , m_outputSerial(0)
+    , m_visibleWidth(0)
+    , m_visibleHeight(0)
+    , m_convertedFrames(0)
+    , m_convertTime(0.0)
+    , m_activeStreams(1)
+    , m_onBattery(false)
+    , m_requestedMode(DecodeMode::Normal)
+    , m_decodeMode(DecodeMode::Normal)
+    , m_framesSkipped(false)
+    , m_awaitKeyframe(false)
+    , m_hasKeyframeIndex(false)
+    , m_stopIndexScan(false)
+    , m_indexScanDone(false)
+    , m_streamStartTime(0)
+    , m_defaultFrameDuration(AV_TIME_BASE / 30)
+    , m_packetsSent(0)
+    , m_framesReceived(0)
+    , m_fullPass(true)
+    , m_maxReadTime(0.0)
+    , m_loopHeadBytes(0)
+    , m_loopHeadEnd(AV_NOPTS_VALUE)
+    , m_loopHeadDuration(0)
+    , m_loopHeadComplete(false)
+    , m_loopHeadDegraded(false)
+    , m_loopCached(false)
+    , m_replayingLoopHead(false)
+    , m_loopReplayPosition(0)
+    , m_skipThroughPts(AV_NOPTS_VALUE)
     , m_width(0)
     , m_height(0)
     , m_duration(0.0)
@@ -33,6 +92,8 @@ VideoDecoder::VideoDecoder()
     , m_eof(false)
     , m_initialized(false)
     , m_isImage(false)
+    , m_isAnimation(false)
+    , m_probeCached(false)
 {
 }
 
@@ -40,14 +101,23 @@ VideoDecoder::~VideoDecoder() {
     Shutdown();
 }
 
-bool VideoDecoder::Initialize(const std::wstring& filePath, ID3D11Device* device) {
+bool VideoDecoder::Initialize(const std::wstring& filePath, ID3D11Device* device, const DecoderOptions& options) {
     if (m_initialized) {
         return true;
     }
 
+    m_options = options;
+
+    // A finished proxy decodes the same content more cheaply
+    std::wstring proxyPath = ProxyTranscoder::FindProxy(filePath, options.proxyHeight);
+    m_filePath = proxyPath.empty() ? filePath : proxyPath;
+
     Logger::Info("Initializing video decoder...");
+    if (!proxyPath.empty()) {
+        Logger::Info("Using " + std::to_string(options.proxyHeight) + "p proxy");
+    }
 
-    if (!OpenFile(filePath)) {
+    if (!OpenFile(m_filePath)) {
         Logger::Error("Failed to open video file");
         return false;
     }
@@ -60,22 +130,42 @@ bool VideoDecoder::Initialize(const std::wstring& filePath, ID3D11Device* device
 
     if (!InitializeDecoder(device)) {
         Logger::Error("Failed to initialize decoder");
+        if (m_probeCached) {
+            // The cached parameters may be what the decoder rejected; probe afresh next time
+            ProbeCache::Invalidate(m_filePath);
+        }
         Shutdown();
         return false;
     }
 
+    if (!m_probeCached) {
+        ProbeCache::Store(m_filePath, m_formatContext, m_videoStreamIndex, m_isImage);
+    }
+
+    if (!m_isImage) {
+        LoadKeyframeIndex();
+    }
+
     m_initialized = true;
     Logger::Info("Video decoder initialized successfully");
     return true;
 }
 
 void VideoDecoder::Shutdown() {
-    if (!m_initialized) {
+    // A failed Initialize may leave a partly opened file behind
+    if (!m_initialized && !m_formatContext) {
         return;
     }
 
     Logger::Info("Shutting down video decoder...");
 
+    StopDecodeThread();
+    StopIndexScan();
+    m_scheduler.reset();
+    ReleaseLoopHead();
+    m_keyframeIndex.Clear();
+    m_hasKeyframeIndex = false;
+
     if (m_packet) {
         av_packet_free(&m_packet);
     }
@@ -84,23 +174,27 @@ void VideoDecoder::Shutdown() {
         av_frame_free(&m_frame);
     }
 
-    if (m_rgbaFrame) {
-        av_frame_free(&m_rgbaFrame);
+    if (m_decodeFrame) {
+        av_frame_free(&m_decodeFrame);
     }
 
-    if (m_swsContext) {
-        sws_freeContext(m_swsContext);
-        m_swsContext = nullptr;
-    }
+    m_frameConverter.reset();
 
     if (m_codecContext) {
         avcodec_free_context(&m_codecContext);
     }
 
+    // Frames still holding pooled buffers free them on release
+    m_framePool.reset();
+
     if (m_formatContext) {
         avformat_close_input(&m_formatContext);
     }
 
+    // Custom I/O outlives the format context that reads from it
+    m_input.reset();
+    m_clipInput.reset();
+
     if (m_hwDeviceCtx) {
         av_buffer_unref(&m_hwDeviceCtx);
     }
@@ -111,18 +205,65 @@ void VideoDecoder::Shutdown() {
 }
 
 bool VideoDecoder::OpenFile(const std::wstring& filePath) {
-    // Convert wstring to UTF-8 string
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-    std::string utf8Path = converter.to_bytes(filePath);
+    std::string utf8Path = ToUtf8(filePath);
+    auto openStart = std::chrono::steady_clock::now();
+
+    const AVInputFormat* inputFormat = nullptr;
+    AVDictionary* demuxerOptions = nullptr;
+
+    if (ClipInput::IsClip(filePath)) {
+        // Pre-converted clips reach FFmpeg as uncompressed rawvideo
+        m_clipInput = std::make_unique<ClipInput>();
+        if (!m_clipInput->Open(filePath, m_options.preloadLimit)) {
+            m_clipInput.reset();
+            return false;
+        }
+        m_formatContext = avformat_alloc_context();
+        if (!m_formatContext) {
+            return false;
+        }
+        m_formatContext->pb = m_clipInput->GetContext();
+        m_formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        inputFormat = av_find_input_format("rawvideo");
+        m_clipInput->GetDemuxerOptions(&demuxerOptions);
+    } else {
+        // Read through a memory mapping when possible; the path still names the
+        // input so formats can be probed by extension
+        m_input = std::make_unique<MappedFileInput>();
+        if (m_input->Open(filePath, m_options.preloadLimit)) {
+            m_formatContext = avformat_alloc_context();
+            if (!m_formatContext) {
+                return false;
+            }
+            m_formatContext->pb = m_input->GetContext();
+            m_formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        } else {
+            Logger::Warning("Memory-mapped input unavailable, using buffered file reads");
+            m_input.reset();
+        }
+    }
 
-    // Open video file
-    if (avformat_open_input(&m_formatContext, utf8Path.c_str(), nullptr, nullptr) < 0) {
+    // Open video file (frees the context on failure)
+    int ret = avformat_open_input(&m_formatContext, utf8Path.c_str(), inputFormat, &demuxerOptions);
+    av_dict_free(&demuxerOptions);
+    if (ret < 0) {
         Logger::Error("Could not open video file: " + utf8Path);
+        m_input.reset();
+        m_clipInput.reset();
         return false;
     }
 
-    // Retrieve stream information
-    if (avformat_find_stream_info(m_formatContext, nullptr) < 0) {
+    if (m_clipInput) {
+        m_clipInput->ApplyStreamInfo(m_formatContext);
+    }
+
+    // Retrieve stream information, from the probe cache if the file is unchanged
+    ProbeCache::Entry probe;
+    m_probeCached = ProbeCache::Apply(filePath, m_formatContext, &probe);
+    if (m_probeCached) {
+        m_videoStreamIndex = probe.streamIndex;
+        m_isImage = probe.isImage;
+    } else if (avformat_find_stream_info(m_formatContext, nullptr) < 0) {
         Logger::Error("Could not find stream information");
         return false;
     }
@@ -132,19 +273,24 @@ bool VideoDecoder::OpenFile(const std::wstring& filePath) {
         m_duration = static_cast<double>(m_formatContext->duration) / AV_TIME_BASE;
     }
 
-    Logger::Info("Opened video file: " + utf8Path);
+    double openMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+    Logger::Info("Opened video file: " + utf8Path + " in " + std::to_string(openMs) + " ms (probe cache " +
+                 (m_probeCached ? "hit)" : "miss)"));
     Logger::Info("Duration: " + std::to_string(m_duration) + " seconds");
 
     return true;
 }
 
 bool VideoDecoder::FindVideoStream() {
-    m_videoStreamIndex = -1;
-
-    for (unsigned int i = 0; i < m_formatContext->nb_streams; i++) {
-        if (m_formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-            m_videoStreamIndex = i;
-            break;
+    // A probe cache hit already names the stream and its classification
+    if (!m_probeCached) {
+        m_videoStreamIndex = -1;
+
+        for (unsigned int i = 0; i < m_formatContext->nb_streams; i++) {
+            if (m_formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+                m_videoStreamIndex = i;
+                break;
+            }
         }
     }
 
@@ -159,20 +305,31 @@ bool VideoDecoder::FindVideoStream() {
     m_width = videoStream->codecpar->width;
     m_height = videoStream->codecpar->height;
     m_frameRate = av_q2d(videoStream->avg_frame_rate);
+    m_streamStartTime = (videoStream->start_time != AV_NOPTS_VALUE) ? videoStream->start_time : 0;
+    if (m_frameRate > 0.0) {
+        m_defaultFrameDuration = static_cast<int64_t>(AV_TIME_BASE / m_frameRate);
+    }
     
     // Detect if this is an image file based on codec ID
     // Image codecs: MJPEG, PNG, BMP, etc.
     AVCodecID codecId = videoStream->codecpar->codec_id;
+
+    // Animated images are decoded like images, but every frame is kept (see AnimatedImage)
+    m_isAnimation = codecId == AV_CODEC_ID_GIF || codecId == AV_CODEC_ID_APNG ||
+                    (codecId == AV_CODEC_ID_WEBP && videoStream->nb_frames > 1);
+
     if (codecId == AV_CODEC_ID_MJPEG || codecId == AV_CODEC_ID_PNG || 
         codecId == AV_CODEC_ID_BMP || codecId == AV_CODEC_ID_TIFF ||
         codecId == AV_CODEC_ID_WEBP || codecId == AV_CODEC_ID_JPEG2000 ||
-        codecId == AV_CODEC_ID_GIF ||
+        m_isAnimation ||
         videoStream->nb_frames == 1 || m_duration < 0.1) {
         m_isImage = true;
         
         // For some image formats, dimensions might be 0 until we decode
         // We'll get the actual dimensions after decoding the first frame
-        if (m_width == 0 || m_height == 0) {
+        if (m_isAnimation) {
+            Logger::Info("Detected animated image: " + std::to_string(m_width) + "x" + std::to_string(m_height));
+        } else if (m_width == 0 || m_height == 0) {
             Logger::Info("Image dimensions not in header, will get from decoded frame");
         } else {
             Logger::Info("Detected image file: " + std::to_string(m_width) + "x" + std::to_string(m_height));
@@ -212,9 +369,12 @@ bool VideoDecoder::InitializeDecoder(ID3D11Device* device) {
 
     // For images, skip hardware acceleration (not supported)
     // For videos, try to use hardware acceleration
-    if (!m_isImage && device) {
+    if (!m_isImage && device && !m_clipInput) {
         if (!SetupHardwareAcceleration(device)) {
             Logger::Warning("Hardware acceleration setup failed, falling back to software decoding");
+        } else {
+            // Queued, pre-rolled and presented frames hold on to decoder surfaces, so reserve extra ones
+            m_codecContext->extra_hw_frames = static_cast<int>(FRAME_QUEUE_DEPTH + m_options.loopPrerollFrames) + 2;
         }
         
         // Set pixel format callback to prefer hardware formats for videos
@@ -232,21 +392,36 @@ bool VideoDecoder::InitializeDecoder(ID3D11Device* device) {
         Logger::Info("Image file - using software decoding");
     }
 
+    // Hardware decoding stays single-threaded; software decoding is split across
+    // cores and decodes into pooled buffers
+    if (!m_hwDeviceCtx) {
+        ApplyThreadingPolicy(m_codecContext, codec);
+        m_codecContext->lowres = GetLowres(m_requestedMode);
+        m_framePool = std::make_unique<FramePool>();
+        m_framePool->Attach(m_codecContext);
+    }
+
     // Open codec
     if (avcodec_open2(m_codecContext, codec, nullptr) < 0) {
         Logger::Error("Could not open codec");
         return false;
     }
 
-    // Allocate frame and packet
+    // Allocate frames and packet
     m_frame = av_frame_alloc();
+    m_decodeFrame = av_frame_alloc();
     m_packet = av_packet_alloc();
 
-    if (!m_frame || !m_packet) {
+    if (!m_frame || !m_decodeFrame || !m_packet) {
         Logger::Error("Could not allocate frame or packet");
         return false;
     }
 
+    if (!m_isImage) {
+        FrameProducer& producer = *this;
+        m_scheduler = std::make_unique<PlaybackScheduler>(producer, FRAME_QUEUE_DEPTH);
+    }
+
     // Store device for software texture upload
     m_device = device;
 
@@ -254,6 +429,117 @@ bool VideoDecoder::InitializeDecoder(ID3D11Device* device) {
     return true;
 }
 
+void VideoDecoder::ApplyThreadingPolicy(AVCodecContext* codecContext, const AVCodec* codec) {
+    m_threading = ThreadingPolicy::Choose(codec, m_width, m_height, m_activeStreams, m_onBattery);
+    codecContext->thread_count = m_threading.threadCount;
+    codecContext->thread_type = m_threading.threadType;
+
+    Logger::Info("Software decode threading: " + std::to_string(m_threading.threadCount) + " " +
+                 ThreadingPolicy::GetTypeName(m_threading.threadType) + " threads");
+}
+
+void VideoDecoder::SetThreadingHint(int activeStreams, bool onBattery) {
+    m_activeStreams = std::max(1, activeStreams);
+    m_onBattery = onBattery;
+}
+
+void VideoDecoder::SetDecodeMode(DecodeMode mode) {
+    m_requestedMode = mode;
+}
+
+int VideoDecoder::GetLowres(DecodeMode mode) const {
+    // Only some software decoders (JPEG, MPEG-4 part 2, ...) can decode at reduced size
+    if (mode != DecodeMode::LowPower || m_hwDeviceCtx || !m_codecContext) {
+        return 0;
+    }
+    return std::min<int>(LOW_POWER_LOWRES, m_codecContext->codec->max_lowres);
+}
+
+void VideoDecoder::ApplyDecodeMode() {
+    DecodeMode mode = m_requestedMode;
+    if (mode == m_decodeMode) {
+        return;
+    }
+
+    // Skip settings are read per frame, so they switch immediately; lowres
+    // needs a codec reopen and waits for the next loop restart
+    bool lowPower = (mode == DecodeMode::LowPower);
+    bool keyframesOnly = (mode == DecodeMode::KeyframesOnly);
+    m_codecContext->skip_loop_filter = lowPower ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+    m_codecContext->skip_idct = lowPower ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    m_codecContext->skip_frame = lowPower ? AVDISCARD_NONREF :
+                                 keyframesOnly ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+
+    // The decoder only holds keyframes when leaving keyframes-only mode
+    if (m_decodeMode == DecodeMode::KeyframesOnly) {
+        m_awaitKeyframe = true;
+    }
+
+    m_decodeMode = mode;
+    m_framesSkipped = m_framesSkipped || mode != DecodeMode::Normal;
+    Logger::Info(std::string("Decode mode: ") + GetDecodeModeName(mode));
+}
+
+const char* VideoDecoder::GetDecodeModeName(DecodeMode mode) {
+    switch (mode) {
+        case DecodeMode::LowPower: return "low power";
+        case DecodeMode::KeyframesOnly: return "keyframes only";
+        default: return "normal";
+    }
+}
+
+bool VideoDecoder::ReopenCodecIfNeeded() {
+    // Only software decoding is threaded or scaled, and only between passes
+    if (m_hwDeviceCtx || !m_codecContext) {
+        return true;
+    }
+
+    const AVCodec* codec = m_codecContext->codec;
+    ThreadingPolicy::Choice choice = ThreadingPolicy::Choose(codec, m_width, m_height, m_activeStreams, m_onBattery);
+    int lowres = GetLowres(m_decodeMode);
+    if (choice.threadCount == m_threading.threadCount && choice.threadType == m_threading.threadType &&
+        lowres == m_codecContext->lowres) {
+        return true;
+    }
+
+    // Thread count and lowres are fixed once a codec is open, so reopen it (the stream is at a keyframe)
+    AVCodecContext* codecContext = avcodec_alloc_context3(codec);
+    if (!codecContext) {
+        return false;
+    }
+
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+    ThreadingPolicy::Choice previous = m_threading;
+    if (avcodec_parameters_to_context(codecContext, videoStream->codecpar) < 0) {
+        avcodec_free_context(&codecContext);
+        return false;
+    }
+
+    ApplyThreadingPolicy(codecContext, codec);
+    codecContext->lowres = lowres;
+    if (m_framePool) {
+        m_framePool->Attach(codecContext);
+    }
+    codecContext->skip_loop_filter = m_codecContext->skip_loop_filter;
+    codecContext->skip_idct = m_codecContext->skip_idct;
+    codecContext->skip_frame = m_codecContext->skip_frame;
+
+    if (avcodec_open2(codecContext, codec, nullptr) < 0) {
+        Logger::Warning("Could not reopen codec, keeping previous settings");
+        avcodec_free_context(&codecContext);
+        m_threading = previous;
+        return false;
+    }
+
+    if (lowres != m_codecContext->lowres) {
+        Logger::Info("Decoding at 1/" + std::to_string(1 << lowres) + " resolution");
+    }
+
+    avcodec_free_context(&m_codecContext);
+    m_codecContext = codecContext;
+    return true;
+}
+
 bool VideoDecoder::SetupHardwareAcceleration(ID3D11Device* device) {
     // Create D3D11VA device context
     AVBufferRef* hwDeviceCtx = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_D3D11VA);
@@ -285,33 +571,118 @@ bool VideoDecoder::SetupHardwareAcceleration(ID3D11Device* device) {
 }
 
 bool VideoDecoder::DecodeNextFrame() {
-    if (!m_initialized) {
+    if (!m_initialized || IsDecodeThreadRunning()) {
+        return false;
+    }
+
+    if (!m_isImage) {
+        ApplyDecodeMode();
+    }
+
+    if (!DecodeFrame(m_frame)) {
+        return false;
+    }
+
+    // For images with 0x0 dimensions, get actual size from decoded frame
+    if (m_isImage && (m_width == 0 || m_height == 0)) {
+        m_width = m_frame->width;
+        m_height = m_frame->height;
+        Logger::Info("Got image dimensions from frame: " + std::to_string(m_width) + "x" + std::to_string(m_height));
+    }
+
+    if (!m_isImage) {
+        TimestampFrame(m_frame);
+        RetainLoopHead(m_frame);
+    } else if (m_isAnimation) {
+        TimestampFrame(m_frame);
+    }
+
+    m_textureUploaded = false; // New frame needs upload
+    m_frameSerial++;
+    return true;
+}
+
+bool VideoDecoder::DecodeFrame(AVFrame* frame) {
+    if (m_decodeState == DecodeState::Drained) {
         return false;
     }
 
     while (true) {
-        // Read packet
-        int ret = av_read_frame(m_formatContext, m_packet);
-        
-        if (ret < 0) {
+        // Drain frames the decoder already has before feeding it more input;
+        // one packet can yield several frames and reordered frames arrive late
+        int ret = avcodec_receive_frame(m_codecContext, frame);
+
+        if (ret >= 0) {
+            m_framesReceived++;
+            return true;
+        }
+
+        if (ret == AVERROR_EOF) {
+            // Everything buffered in the decoder has been returned
+            m_decodeState = DecodeState::Drained;
+            m_eof = true;
+            LogDecodeStats();
+            return false;
+        }
+
+        if (ret != AVERROR(EAGAIN)) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            Logger::Error("Error receiving frame from decoder: " + std::string(errbuf));
+            return false;
+        }
+
+        // Decoder needs more input
+        if (m_decodeState == DecodeState::Draining) {
+            // Nothing left to feed after the flush packet
+            m_decodeState = DecodeState::Drained;
+            m_eof = true;
+            return false;
+        }
+
+        if (!m_packetPending) {
+            // Demux stalls show up here when the read-ahead falls behind storage
+            double readStartTime = PresentationClock::Now();
+            ret = av_read_frame(m_formatContext, m_packet);
+            m_maxReadTime = std::max(m_maxReadTime, PresentationClock::Now() - readStartTime);
+
             if (ret == AVERROR_EOF) {
-                m_eof = true;
-                Logger::Info("End of video file reached");
-            } else {
+                // Flush packet: the decoder releases all frames it still holds
+                avcodec_send_packet(m_codecContext, nullptr);
+                m_decodeState = DecodeState::Draining;
+                continue;
+            } else if (ret < 0) {
                 Logger::Error("Error reading frame");
+                return false;
             }
-            return false;
-        }
 
-        // Skip non-video packets
-        if (m_packet->stream_index != m_videoStreamIndex) {
-            av_packet_unref(m_packet);
-            continue;
+            // Skip non-video packets
+            if (m_packet->stream_index != m_videoStreamIndex) {
+                av_packet_unref(m_packet);
+                continue;
+            }
+
+            // Keyframes-only playback never hands other packets to the decoder, and
+            // after it ends, decoding resumes at a keyframe so no reference is missing
+            bool keyframe = (m_packet->flags & AV_PKT_FLAG_KEY) != 0;
+            if ((m_decodeMode == DecodeMode::KeyframesOnly || m_awaitKeyframe) && !keyframe) {
+                av_packet_unref(m_packet);
+                continue;
+            }
+            m_awaitKeyframe = false;
         }
 
         // Send packet to decoder
         ret = avcodec_send_packet(m_codecContext, m_packet);
+
+        if (ret == AVERROR(EAGAIN)) {
+            // Output must be read first; keep the packet and resend it afterwards
+            m_packetPending = true;
+            continue;
+        }
+
         av_packet_unref(m_packet);
+        m_packetPending = false;
 
         if (ret < 0) {
             char errbuf[AV_ERROR_MAX_STRING_SIZE];
@@ -320,39 +691,362 @@ bool VideoDecoder::DecodeNextFrame() {
             return false;
         }
 
-        // Receive decoded frame
-        ret = avcodec_receive_frame(m_codecContext, m_frame);
-        
-        if (ret == AVERROR(EAGAIN)) {
-            // Need more packets
-            continue;
-        } else if (ret < 0) {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-            Logger::Error("Error receiving frame from decoder: " + std::string(errbuf));
+        m_packetsSent++;
+    }
+}
+
+void VideoDecoder::LogConversionStats(int cropWidth, int cropHeight, int outputWidth, int outputHeight, int bands) {
+    if (++m_convertedFrames < CONVERSION_STATS_INTERVAL) {
+        return;
+    }
+
+    AVPixelFormat format = static_cast<AVPixelFormat>(m_frame->format);
+    int readBytes = std::max(0, av_image_get_buffer_size(format, cropWidth, cropHeight, 1));
+    int sourceBytes = std::max(0, av_image_get_buffer_size(format, m_frame->width, m_frame->height, 1));
+    size_t frameBytes = static_cast<size_t>(outputWidth) * outputHeight * 4;
+    Logger::Info("Software conversion " + std::to_string(cropWidth) + "x" + std::to_string(cropHeight) +
+                 " of " + std::to_string(m_frame->width) + "x" + std::to_string(m_frame->height) +
+                 " -> " + std::to_string(outputWidth) + "x" + std::to_string(outputHeight) + ": " +
+                 std::to_string(m_convertTime * 1000.0 / m_convertedFrames) + " ms in " + std::to_string(bands) +
+                 (bands == 1 ? " band" : " bands") + ", reads " +
+                 std::to_string(readBytes / 1024) + " of " + std::to_string(sourceBytes / 1024) + " KB and writes " +
+                 std::to_string(frameBytes / 1024) + " KB per frame");
+    m_convertedFrames = 0;
+    m_convertTime = 0.0;
+}
+
+void VideoDecoder::LogDecodeStats() {
+    int64_t packets = m_packetsSent;
+    int64_t frames = m_framesReceived;
+    if (packets == 0) {
+        return;
+    }
+
+    Logger::Info("End of video file reached: " + std::to_string(frames) + " frames from " +
+                 std::to_string(packets) + " packets (" + std::to_string(GetFramesPerPacket()) + " frames/packet), " +
+                 "slowest packet read " + std::to_string(m_maxReadTime * 1000.0) + " ms");
+
+    // Lost frames mean the decoder wasn't fully drained
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+    if (m_fullPass && !m_framesSkipped && videoStream->nb_frames > 0 && frames != videoStream->nb_frames) {
+        Logger::Warning("Decoded frame count differs from container: " + std::to_string(frames) +
+                        " vs " + std::to_string(videoStream->nb_frames));
+    }
+}
+
+double VideoDecoder::GetFramesPerPacket() const {
+    int64_t packets = m_packetsSent;
+    if (packets == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(m_framesReceived) / static_cast<double>(packets);
+}
+
+uint64_t VideoDecoder::GetFrameBufferAllocations() const {
+    return m_framePool ? m_framePool->GetAllocationCount() : 0;
+}
+
+void VideoDecoder::TimestampFrame(AVFrame* frame) {
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+
+    int64_t duration = m_defaultFrameDuration;
+    if (frame->duration > 0) {
+        duration = av_rescale_q(frame->duration, videoStream->time_base, AV_TIME_BASE_Q);
+    }
+
+    // A keyframe stays on screen until the next one is due
+    if (m_decodeMode == DecodeMode::KeyframesOnly) {
+        duration = GetKeyframeHoldDuration(frame, duration);
+    }
+
+    // Queued frames carry pts/duration in microseconds on the playback timeline,
+    // which keeps counting across loops
+    frame->pts = m_timeline.Place(GetRelativePts(frame), duration);
+    frame->duration = duration;
+}
+
+int64_t VideoDecoder::GetKeyframeHoldDuration(const AVFrame* frame, int64_t frameDuration) const {
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+    int64_t pts = frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = frame->pts;
+    }
+
+    int keyframe = m_keyframeIndex.FindKeyframe(pts);
+    if (pts == AV_NOPTS_VALUE || keyframe < 0) {
+        return frameDuration;
+    }
+
+    // Last keyframe: hold until the end of the clip
+    int64_t nextPts = m_streamStartTime + av_rescale_q(static_cast<int64_t>(m_duration * AV_TIME_BASE),
+                                                       AV_TIME_BASE_Q, videoStream->time_base);
+    if (keyframe + 1 < static_cast<int>(m_keyframeIndex.GetCount())) {
+        nextPts = m_keyframeIndex.GetEntry(keyframe + 1).pts;
+    }
+
+    int64_t hold = av_rescale_q(nextPts - pts, videoStream->time_base, AV_TIME_BASE_Q);
+    return (hold > frameDuration) ? hold : frameDuration;
+}
+
+void VideoDecoder::ResetTimeline() {
+    m_timeline.Reset();
+    m_skipThroughPts = AV_NOPTS_VALUE;
+    m_replayingLoopHead = false;
+    if (m_scheduler) {
+        m_scheduler->ResetClock();
+    }
+
+    // A partially built loop head can't be completed from a new position
+    if (!m_loopHeadComplete) {
+        ReleaseLoopHead();
+    }
+}
+
+bool VideoDecoder::ProduceFrame(FrameQueue& queue) {
+    ApplyDecodeMode();
+    AdoptScannedIndex();
+
+    if (m_replayingLoopHead) {
+        return ReplayLoopHead(queue);
+    }
+
+    if (!DecodeFrame(m_decodeFrame)) {
+        if (!m_eof) {
             return false;
         }
+        return LoopPlayback(queue);
+    }
 
-        // Successfully decoded a frame
-        // For images with 0x0 dimensions, get actual size from decoded frame
-        if (m_isImage && (m_width == 0 || m_height == 0)) {
-            m_width = m_frame->width;
-            m_height = m_frame->height;
-            Logger::Info("Got image dimensions from frame: " + std::to_string(m_width) + "x" + std::to_string(m_height));
+    if (m_skipThroughPts != AV_NOPTS_VALUE) {
+        // Already played from the pre-rolled loop head
+        if (GetRelativePts(m_decodeFrame) <= m_skipThroughPts) {
+            av_frame_unref(m_decodeFrame);
+            return true;
         }
-        
-        m_textureUploaded = false; // New frame needs upload
+        m_skipThroughPts = AV_NOPTS_VALUE;
+    }
+
+    TimestampFrame(m_decodeFrame);
+    RetainLoopHead(m_decodeFrame);
+
+    // Blocks while the queue is full; returns false when stopping
+    if (!queue.Push(m_decodeFrame)) {
+        av_frame_unref(m_decodeFrame);
+        return false;
+    }
+    return true;
+}
+
+bool VideoDecoder::LoopPlayback(FrameQueue& queue) {
+    // Frames decoded in a reduced mode are not replayed once it ends; the
+    // next pass from the start builds the head again
+    if (m_loopHeadDegraded) {
+        ReleaseLoopHead();
+    }
+
+    // Clips that were retained in full are replayed without touching the decoder
+    if (m_fullPass && !m_loopHeadComplete && !m_loopHead.empty()) {
+        m_loopHeadComplete = true;
+        m_loopCached = true;
+        UpdateLoopHeadSpan();
+        Logger::Info("Cached entire loop: " + std::to_string(m_loopHead.size()) + " frames, " +
+                     std::to_string(m_loopHeadBytes / (1024 * 1024)) + " MB");
+    }
+
+    if (!m_loopCached) {
+        // Loop back to beginning; the next iteration continues the timeline
+        if (!SeekStream(0.0)) {
+            return false;
+        }
+
+        // Pick up changes in stream count or power state at the keyframe
+        ReopenCodecIfNeeded();
+    }
+    m_timeline.StartLoop();
+
+    if (!m_loopHeadComplete) {
+        // Nothing pre-rolled, the first frame of the next loop is decoded synchronously
+        ReleaseLoopHead();
         return true;
     }
+    if (m_loopHead.empty()) {
+        return true; // Pre-roll disabled
+    }
+
+    // The start of the clip is already decoded: queue it ahead of the decoder, one
+    // frame per call like decoded frames, and skip the pre-rolled frames once decoding
+    // resumes. A cached loop leaves the demuxer at end of file, so the call after the
+    // last replayed frame lands here again
+    m_replayingLoopHead = true;
+    m_loopReplayPosition = 0;
+    if (!m_loopCached) {
+        m_skipThroughPts = m_loopHeadEnd;
+    }
+    return ReplayLoopHead(queue);
+}
+
+bool VideoDecoder::ReplayLoopHead(FrameQueue& queue) {
+    const AVFrame* headFrame = m_loopHead[m_loopReplayPosition];
+    if (av_frame_ref(m_decodeFrame, headFrame) < 0) {
+        return false;
+    }
+
+    m_decodeFrame->pts = m_timeline.Place(headFrame->pts, headFrame->duration);
+
+    // Blocks while the queue is full; returns false when stopping
+    if (!queue.Push(m_decodeFrame)) {
+        av_frame_unref(m_decodeFrame);
+        return false;
+    }
+
+    if (++m_loopReplayPosition == m_loopHead.size()) {
+        m_replayingLoopHead = false;
+    }
+    return true;
+}
+
+void VideoDecoder::RetainLoopHead(const AVFrame* frame) {
+    // Only a pass from the start of the file builds the loop head
+    if (m_loopHeadComplete || !m_fullPass) {
+        return;
+    }
+
+    // Beyond the pre-roll, keep going only while the whole loop may still fit the
+    // cache budget; hardware frames live in the decoder's fixed surface pool
+    size_t frameBytes = GetFrameBytes(frame);
+    bool cacheable = frame->format != AV_PIX_FMT_D3D11 &&
+                     m_loopHeadBytes + frameBytes <= m_options.loopCacheBudget;
+
+    size_t preroll = m_options.loopPrerollFrames;
+    if (m_loopHead.size() >= preroll && !cacheable) {
+        if (m_loopHead.size() > preroll) {
+            Logger::Info("Loop exceeds cache budget, keeping pre-roll only");
+            while (m_loopHead.size() > preroll) {
+                m_loopHeadBytes -= GetFrameBytes(m_loopHead.back());
+                av_frame_free(&m_loopHead.back());
+                m_loopHead.pop_back();
+            }
+        }
+
+        m_loopHeadComplete = true;
+        UpdateLoopHeadSpan();
+        Logger::Info("Pre-rolled " + std::to_string(m_loopHead.size()) + " frames (" +
+                     std::to_string(ToSeconds(m_loopHeadDuration) * 1000.0) + " ms) for seamless looping");
+        return;
+    }
+
+    AVFrame* headFrame = av_frame_alloc();
+    if (!headFrame || av_frame_ref(headFrame, frame) < 0) {
+        av_frame_free(&headFrame);
+        ReleaseLoopHead();
+        m_loopHeadComplete = true; // Give up on pre-roll for this file
+        return;
+    }
+
+    // Head frames are kept relative to the start of the loop
+    headFrame->pts -= m_timeline.GetLoopOffset();
+    m_loopHead.push_back(headFrame);
+    m_loopHeadBytes += frameBytes;
+    m_loopHeadDegraded = m_loopHeadDegraded || m_decodeMode != DecodeMode::Normal;
+}
+
+void VideoDecoder::UpdateLoopHeadSpan() {
+    if (m_loopHead.empty()) {
+        m_loopHeadEnd = AV_NOPTS_VALUE;
+        m_loopHeadDuration = 0;
+        return;
+    }
+
+    const AVFrame* last = m_loopHead.back();
+    m_loopHeadEnd = last->pts;
+    m_loopHeadDuration = last->pts + last->duration - m_loopHead.front()->pts;
+}
+
+void VideoDecoder::ReleaseLoopHead() {
+    for (auto& headFrame : m_loopHead) {
+        av_frame_free(&headFrame);
+    }
+    m_loopHead.clear();
+    m_loopHeadBytes = 0;
+    m_loopHeadEnd = AV_NOPTS_VALUE;
+    m_loopHeadDuration = 0;
+    m_loopHeadComplete = false;
+    m_loopHeadDegraded = false;
+    m_loopCached = false;
+    m_replayingLoopHead = false;
+    m_loopReplayPosition = 0;
 }
 
-ID3D11Texture2D* VideoDecoder::GetFrameTexture() {
+size_t VideoDecoder::GetFrameBytes(const AVFrame* frame) {
+    size_t bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i]; i++) {
+        bytes += frame->buf[i]->size;
+    }
+    return bytes;
+}
+
+int64_t VideoDecoder::GetRelativePts(const AVFrame* frame) const {
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+
+    int64_t streamPts = frame->best_effort_timestamp;
+    if (streamPts == AV_NOPTS_VALUE) {
+        streamPts = frame->pts;
+    }
+    if (streamPts == AV_NOPTS_VALUE) {
+        return AV_NOPTS_VALUE;
+    }
+
+    return av_rescale_q(streamPts - m_streamStartTime, videoStream->time_base, AV_TIME_BASE_Q);
+}
+
+bool VideoDecoder::StartDecodeThread() {
+    if (!m_initialized || m_isImage) {
+        return false;
+    }
+
+    return m_scheduler->StartDecodeThread();
+}
+
+void VideoDecoder::StopDecodeThread() {
+    if (!m_scheduler) {
+        return;
+    }
+
+    m_scheduler->StopDecodeThread();
+    av_frame_unref(m_decodeFrame);
+}
+
+bool VideoDecoder::UpdatePlayback(double now) {
+    if (!m_initialized || m_isImage) {
+        return false;
+    }
+
+    if (!m_scheduler->UpdatePlayback(now, m_frame)) {
+        return false;
+    }
+
+    m_textureUploaded = false; // New frame needs upload
+    m_frameSerial++;
+    return true;
+}
+
+double VideoDecoder::GetTimeToNextFrame(double now) const {
+    if (!m_initialized || m_isImage) {
+        return 1.0; // Static content, check infrequently
+    }
+
+    return m_scheduler->GetTimeToNextFrame(now);
+}
+
+ID3D11Texture2D* VideoDecoder::GetFrameTexture(int targetWidth, int targetHeight, int scalingMode) {
     if (!m_frame || !m_frame->data[0]) {
         return nullptr;
     }
 
     // If hardware decoding, frame->data[0] contains ID3D11Texture2D*
     if (m_frame->format == AV_PIX_FMT_D3D11) {
+        m_visibleWidth = m_width;
+        m_visibleHeight = m_height;
         return reinterpret_cast<ID3D11Texture2D*>(m_frame->data[0]);
     }
 
@@ -366,11 +1060,57 @@ ID3D11Texture2D* VideoDecoder::GetFrameTexture() {
         return nullptr;
     }
 
+    // Only the pixels a monitor can show are read and converted. Windows sharing
+    // this decoder may need different parts and sizes; the union of what was
+    // asked for during this frame or the previous one is produced, so the
+    // output settles without converting a frame twice
+    OutputLayout layout = OutputLayout::Compute(m_frame->width, m_frame->height,
+                                                targetWidth, targetHeight, scalingMode, true);
+    if (m_outputSerial != m_frameSerial) {
+        m_outputSerial = m_frameSerial;
+        m_previousRequest = m_request;
+        m_request = OutputRequest();
+    }
+    m_request.Add(layout);
+    OutputRequest merged = m_request;
+    merged.Add(m_previousRequest);
+
+    int cropWidth = std::min(merged.cropWidth, m_frame->width);
+    int cropHeight = std::min(merged.cropHeight, m_frame->height);
+    const uint8_t* planes[4];
+    if (!FrameConverter::GetCroppedPlanes(m_frame, cropWidth, cropHeight, planes)) {
+        cropWidth = m_frame->width;
+        cropHeight = m_frame->height;
+    }
+
+    int outputWidth = 0;
+    int outputHeight = 0;
+    merged.GetOutputSize(cropWidth, cropHeight, &outputWidth, &outputHeight);
+
+    // The renderer lays out the visible part; a new crop needs a new upload
+    int visibleWidth = static_cast<int>(static_cast<int64_t>(cropWidth) * m_width / m_frame->width);
+    int visibleHeight = static_cast<int>(static_cast<int64_t>(cropHeight) * m_height / m_frame->height);
+    if (visibleWidth != m_visibleWidth || visibleHeight != m_visibleHeight) {
+        m_visibleWidth = visibleWidth;
+        m_visibleHeight = visibleHeight;
+        m_textureUploaded = false;
+    }
+
+    // Output size changes with the monitors and when lowres decoding is switched
+    if (m_softwareTexture) {
+        D3D11_TEXTURE2D_DESC currentDesc;
+        m_softwareTexture->GetDesc(&currentDesc);
+        if (currentDesc.Width != static_cast<UINT>(outputWidth) ||
+            currentDesc.Height != static_cast<UINT>(outputHeight)) {
+            m_softwareTexture.Reset();
+        }
+    }
+
     // Create or update software texture if needed
     if (!m_softwareTexture) {
         D3D11_TEXTURE2D_DESC texDesc = {};
-        texDesc.Width = m_frame->width;
-        texDesc.Height = m_frame->height;
+        texDesc.Width = outputWidth;
+        texDesc.Height = outputHeight;
         texDesc.MipLevels = 1;
         texDesc.ArraySize = 1;
         texDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
@@ -384,7 +1124,8 @@ ID3D11Texture2D* VideoDecoder::GetFrameTexture() {
             Logger::Error("Failed to create software texture: " + std::to_string(hr));
             return nullptr;
         }
-        Logger::Info("Created software upload texture: " + std::to_string(m_frame->width) + "x" + std::to_string(m_frame->height));
+        Logger::Info("Created software upload texture: " + std::to_string(outputWidth) + "x" + std::to_string(outputHeight) +
+                     " for " + std::to_string(m_frame->width) + "x" + std::to_string(m_frame->height) + " frames");
         m_textureUploaded = false; // Force upload for new texture
     }
 
@@ -393,18 +1134,11 @@ ID3D11Texture2D* VideoDecoder::GetFrameTexture() {
         return m_softwareTexture.Get();
     }
 
-    // Set up swscale context if needed (convert any format to BGRA)
-    if (!m_swsContext) {
-        m_swsContext = sws_getContext(
-            m_frame->width, m_frame->height, (AVPixelFormat)m_frame->format,
-            m_frame->width, m_frame->height, AV_PIX_FMT_BGRA,
-            SWS_BILINEAR, nullptr, nullptr, nullptr
-        );
-        if (!m_swsContext) {
-            Logger::Error("Failed to create swscale context");
-            return nullptr;
-        }
-        Logger::Info("Created swscale context for format " + std::to_string(m_frame->format) + " -> BGRA");
+    // Large conversions are split into bands run on the shared worker pool
+    int bands = ThreadingPolicy::ChooseConversionBands(outputWidth, outputHeight,
+                                                       ConversionPool::GetInstance().GetThreadCount(), m_onBattery);
+    if (!m_frameConverter) {
+        m_frameConverter = std::make_unique<FrameConverter>();
     }
 
     // Map the texture for writing
@@ -423,16 +1157,23 @@ ID3D11Texture2D* VideoDecoder::GetFrameTexture() {
     }
 
     // Convert frame to BGRA and write directly to mapped texture
-    uint8_t* dstData[1] = { (uint8_t*)mapped.pData };
-    int dstLinesize[1] = { (int)mapped.RowPitch };
+    uint8_t* dstData = static_cast<uint8_t*>(mapped.pData);
+    int dstPitch = static_cast<int>(mapped.RowPitch);
 
-    sws_scale(m_swsContext, m_frame->data, m_frame->linesize, 
-              0, m_frame->height, dstData, dstLinesize);
+    double convertStartTime = PresentationClock::Now();
+    bool converted = m_frameConverter->Convert(m_frame, planes, cropWidth, cropHeight, dstData, dstPitch,
+                                               outputWidth, outputHeight, bands);
+    m_convertTime += PresentationClock::Now() - convertStartTime;
 
     context->Unmap(m_softwareTexture.Get(), 0);
     context->Release();
 
+    if (!converted) {
+        return nullptr;
+    }
+
     m_textureUploaded = true;
+    LogConversionStats(cropWidth, cropHeight, outputWidth, outputHeight, bands);
     return m_softwareTexture.Get();
 }
 
@@ -450,17 +1191,275 @@ void VideoDecoder::Seek(double timeSeconds) {
         return;
     }
 
+    // The decode thread owns the demuxer while it runs
+    bool wasRunning = IsDecodeThreadRunning();
+    StopDecodeThread();
+
+    if (SeekStream(timeSeconds)) {
+        ResetTimeline();
+        DecodeNextFrame();
+    }
+
+    if (wasRunning) {
+        StartDecodeThread();
+    }
+}
+
+bool VideoDecoder::SeekStream(double timeSeconds) {
     int64_t timestamp = static_cast<int64_t>(timeSeconds * AV_TIME_BASE);
     
     if (av_seek_frame(m_formatContext, -1, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
         Logger::Error("Seek failed");
-        return;
+        return false;
     }
 
+    FlushDecoder();
+    m_fullPass = (timeSeconds <= 0.0);
+    return true;
+}
+
+void VideoDecoder::FlushDecoder() {
+    // Drop decoder state and any packet that was waiting to be resent
     avcodec_flush_buffers(m_codecContext);
+    av_packet_unref(m_packet);
+    m_packetPending = false;
+    m_decodeState = DecodeState::Decoding;
+    m_packetsSent = 0;
+    m_framesReceived = 0;
+    m_framesSkipped = (m_decodeMode != DecodeMode::Normal);
+    m_awaitKeyframe = false;
+    m_maxReadTime = 0.0;
     m_eof = false;
 }
 
+bool VideoDecoder::SeekExact(double timeSeconds) {
+    if (!m_initialized || m_isImage) {
+        return false;
+    }
+
+    double seekStartTime = PresentationClock::Now();
+
+    // The decode thread owns the demuxer while it runs
+    bool wasRunning = IsDecodeThreadRunning();
+    StopDecodeThread();
+
+    // Until the background scan is done, an empty index seeks by timestamp
+    AdoptScannedIndex();
+
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+    int64_t target = m_streamStartTime + av_rescale_q(static_cast<int64_t>(timeSeconds * AV_TIME_BASE),
+                                                      AV_TIME_BASE_Q, videoStream->time_base);
+
+    int keyframe = m_keyframeIndex.FindKeyframe(target);
+    int framesDecoded = 0;
+    bool overshot = false;
+    bool found = SeekToKeyframe(keyframe, target) && DecodeUntil(target, &framesDecoded, &overshot);
+
+    // Container indexes store decode timestamps, which can put a keyframe's
+    // presentation time just past the target; start one GOP earlier instead
+    if (found && overshot && keyframe > 0) {
+        keyframe--;
+        found = SeekToKeyframe(keyframe, target) && DecodeUntil(target, &framesDecoded, &overshot);
+    }
+
+    if (found) {
+        m_fullPass = (timeSeconds <= 0.0);
+        ResetTimeline();
+        TimestampFrame(m_frame);
+        RetainLoopHead(m_frame);
+        m_textureUploaded = false;
+        m_frameSerial++;
+
+        double keyframeTime = (keyframe >= 0) ?
+            av_q2d(videoStream->time_base) * (m_keyframeIndex.GetEntry(keyframe).pts - m_streamStartTime) : 0.0;
+        Logger::Info("Exact seek to " + std::to_string(timeSeconds) + " s: " + std::to_string(framesDecoded) +
+                     " frames decoded from keyframe at " + std::to_string(keyframeTime) + " s in " +
+                     std::to_string((PresentationClock::Now() - seekStartTime) * 1000.0) + " ms");
+    } else {
+        Logger::Warning("Exact seek to " + std::to_string(timeSeconds) + " s failed, restarting from the beginning");
+        if (SeekStream(0.0)) {
+            ResetTimeline();
+            DecodeNextFrame();
+        }
+    }
+
+    if (wasRunning) {
+        StartDecodeThread();
+    }
+
+    return found;
+}
+
+bool VideoDecoder::SeekToKeyframe(int keyframe, int64_t target) {
+    bool seeked = false;
+
+    if (keyframe >= 0) {
+        const KeyframeIndex::Entry& entry = m_keyframeIndex.GetEntry(keyframe);
+        AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+
+        // Without a container index, timestamp seeks are bisections over the
+        // file; the scanned byte position lands on the keyframe directly
+        bool byteSeek = entry.position >= 0 &&
+                        avformat_index_get_entries_count(videoStream) == 0 &&
+                        !(m_formatContext->iformat->flags & AVFMT_NO_BYTE_SEEK);
+
+        if (byteSeek) {
+            seeked = av_seek_frame(m_formatContext, m_videoStreamIndex, entry.position, AVSEEK_FLAG_BYTE) >= 0;
+        }
+        if (!seeked) {
+            seeked = av_seek_frame(m_formatContext, m_videoStreamIndex, entry.pts, AVSEEK_FLAG_BACKWARD) >= 0;
+        }
+    } else {
+        seeked = av_seek_frame(m_formatContext, m_videoStreamIndex, target, AVSEEK_FLAG_BACKWARD) >= 0;
+    }
+
+    if (!seeked) {
+        Logger::Error("Seek failed");
+        return false;
+    }
+
+    FlushDecoder();
+    return true;
+}
+
+bool VideoDecoder::DecodeUntil(int64_t target, int* framesDecoded, bool* overshot) {
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+    int64_t defaultDuration = av_rescale_q(m_defaultFrameDuration, AV_TIME_BASE_Q, videoStream->time_base);
+
+    *framesDecoded = 0;
+    *overshot = false;
+
+    // Frames before the target are only decoded as references; they are never
+    // converted or uploaded
+    while (DecodeFrame(m_frame)) {
+        (*framesDecoded)++;
+
+        int64_t pts = m_frame->best_effort_timestamp;
+        if (pts == AV_NOPTS_VALUE) {
+            pts = m_frame->pts;
+        }
+        if (pts == AV_NOPTS_VALUE) {
+            return true;
+        }
+
+        int64_t duration = (m_frame->duration > 0) ? m_frame->duration : defaultDuration;
+        if (pts + duration > target) {
+            *overshot = (*framesDecoded == 1 && pts > target);
+            return true;
+        }
+
+        av_frame_unref(m_frame);
+    }
+
+    return false;
+}
+
+void VideoDecoder::LoadKeyframeIndex() {
+    AVStream* videoStream = m_formatContext->streams[m_videoStreamIndex];
+    std::filesystem::path indexPath = FileCache::GetEntryPath(m_filePath, L".kfi");
+
+    if (!indexPath.empty() &&
+        m_keyframeIndex.Load(indexPath, videoStream->time_base.num, videoStream->time_base.den)) {
+        Logger::Info("Loaded keyframe index: " + std::to_string(m_keyframeIndex.GetCount()) + " keyframes");
+        m_hasKeyframeIndex = true;
+        return;
+    }
+
+    // Containers with sample tables or cues already know their keyframes
+    if (m_keyframeIndex.BuildFromDemuxer(videoStream)) {
+        Logger::Info("Keyframe index from container: " + std::to_string(m_keyframeIndex.GetCount()) + " keyframes");
+        m_hasKeyframeIndex = true;
+        return;
+    }
+
+    // Every frame of a pre-converted clip is a keyframe
+    if (!m_clipInput) {
+        StartIndexScan();
+    }
+}
+
+// Lets a stopped scan abandon av_read_frame instead of reading to the end
+static int InterruptIndexScan(void* opaque) {
+    return static_cast<std::atomic<bool>*>(opaque)->load() ? 1 : 0;
+}
+
+void VideoDecoder::StartIndexScan() {
+    std::string utf8Path = ToUtf8(m_filePath);
+
+    m_stopIndexScan = false;
+    m_indexScanDone = false;
+
+    try {
+        m_indexThread = std::thread(&VideoDecoder::IndexScanMain, this, utf8Path, m_videoStreamIndex, m_filePath);
+    } catch (const std::system_error& e) {
+        Logger::Warning("Failed to start keyframe scan: " + std::string(e.what()));
+    }
+}
+
+void VideoDecoder::StopIndexScan() {
+    if (m_indexThread.joinable()) {
+        m_stopIndexScan = true;
+        m_indexThread.join();
+    }
+
+    m_scannedIndex.Clear();
+    m_indexScanDone = false;
+}
+
+void VideoDecoder::IndexScanMain(std::string utf8Path, int streamIndex, std::wstring filePath) {
+    double scanStartTime = PresentationClock::Now();
+    AVFormatContext* formatContext = avformat_alloc_context();
+
+    // Reads the file separately from playback, which keeps its own demuxer position
+    if (formatContext) {
+        formatContext->interrupt_callback.callback = InterruptIndexScan;
+        formatContext->interrupt_callback.opaque = &m_stopIndexScan;
+    }
+    if (!formatContext || avformat_open_input(&formatContext, utf8Path.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(formatContext, nullptr) < 0 ||
+        streamIndex >= static_cast<int>(formatContext->nb_streams)) {
+        Logger::Warning("Keyframe scan could not open " + utf8Path);
+        avformat_close_input(&formatContext);
+        m_indexScanDone = true;
+        return;
+    }
+
+    AVStream* videoStream = formatContext->streams[streamIndex];
+    KeyframeIndex index;
+    if (!index.BuildFromScan(formatContext, streamIndex)) {
+        if (!m_stopIndexScan) {
+            Logger::Warning("Keyframe scan found no keyframes");
+        }
+    } else if (!m_stopIndexScan) {
+        Logger::Info("Scanned keyframe index: " + std::to_string(index.GetCount()) + " keyframes, longest GOP " +
+                     std::to_string(av_q2d(videoStream->time_base) * index.GetMaxInterval()) + " s, " +
+                     std::to_string((PresentationClock::Now() - scanStartTime) * 1000.0) + " ms");
+
+        std::filesystem::path indexPath = FileCache::GetEntryPath(filePath, L".kfi");
+        if (indexPath.empty() || !index.Save(indexPath, videoStream->time_base.num, videoStream->time_base.den)) {
+            Logger::Warning("Could not save keyframe index");
+        }
+        m_scannedIndex = std::move(index);
+    }
+
+    avformat_close_input(&formatContext);
+    m_indexScanDone = true;
+}
+
+void VideoDecoder::AdoptScannedIndex() {
+    // Called by whichever thread owns the demuxer, so the index never changes under a reader
+    if (!m_indexScanDone || !m_indexThread.joinable()) {
+        return;
+    }
+
+    m_indexThread.join();
+    if (m_keyframeIndex.IsEmpty()) {
+        m_keyframeIndex = std::move(m_scannedIndex);
+        m_hasKeyframeIndex = !m_keyframeIndex.IsEmpty();
+    }
+    m_scannedIndex.Clear();
+}
+
 void VideoDecoder::Reset() {
     Seek(0.0);
 }
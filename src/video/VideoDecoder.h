@@ -5,6 +5,17 @@
 #include <wrl/client.h>
 #include <string>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <vector>
+#include "DecoderOptions.h"
+#include "FrameHandle.h"
+#include "KeyframeIndex.h"
+#include "OutputLayout.h"
+#include "PlaybackScheduler.h"
+#include "PlaybackTimeline.h"
+#include "ThreadingPolicy.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -14,23 +25,114 @@ struct AVCodecContext;
 struct AVFrame;
 struct AVPacket;
 struct AVBufferRef;
-struct SwsContext;
 
 namespace PixelMotion {
 
+class ClipInput;
+class FrameConverter;
+class FramePool;
+class MappedFileInput;
+
+/**
+ * Trade-off between decode cost and picture quality, switchable while playing
+ */
+enum class DecodeMode {
+    Normal,
+    LowPower,     // Skip loop filter/IDCT on non-key frames, drop non-reference frames, lowres if supported
+    KeyframesOnly // Demux and decode keyframes only, each held until the next one
+};
+
 /**
  * FFmpeg-based video decoder with D3D11VA hardware acceleration
  */
-class VideoDecoder {
+class VideoDecoder : private FrameProducer {
 public:
     VideoDecoder();
     ~VideoDecoder();
 
-    bool Initialize(const std::wstring& filePath, ID3D11Device* device);
+    bool Initialize(const std::wstring& filePath, ID3D11Device* device,
+                    const DecoderOptions& options = DecoderOptions());
     void Shutdown();
 
+    /**
+     * Workload hints for software decode threading
+     * Used when the codec is opened and applied again at each loop restart
+     */
+    void SetThreadingHint(int activeStreams, bool onBattery);
+
+    /**
+     * Request a decode mode; the decoder switches at the next frame
+     */
+    void SetDecodeMode(DecodeMode mode);
+    DecodeMode GetDecodeMode() const { return m_requestedMode; }
+
     bool DecodeNextFrame();
-    ID3D11Texture2D* GetFrameTexture();
+
+    /**
+     * Decode ahead on a worker thread into a bounded frame queue
+     * Looping at end of file is handled by the worker
+     */
+    bool StartDecodeThread();
+    void StopDecodeThread();
+    bool IsDecodeThreadRunning() const { return m_scheduler && m_scheduler->IsDecodeThreadRunning(); }
+
+    /**
+     * Advance playback to the given time (main thread only)
+     * Frames are scheduled from their timestamps; late frames are dropped
+     * Falls back to decoding inline when no decode thread is running,
+     * including after the decode thread gave up on errors
+     * Safe to call once per consumer per tick when the decoder is shared
+     * @param now Wall-clock time in seconds (see PresentationClock::Now)
+     * @return true if a new frame became current
+     */
+    bool UpdatePlayback(double now);
+
+    /**
+     * Incremented whenever the current frame changes, so consumers sharing
+     * this decoder can tell whether they have drawn it yet
+     */
+    uint64_t GetFrameSerial() const { return m_frameSerial; }
+    double GetTimeToNextFrame(double now) const;
+
+    int GetLateFrameCount() const { return m_scheduler ? m_scheduler->GetLateFrameCount() : 0; }
+
+    /**
+     * Decoding stopped after repeated errors; the last frame stays current
+     */
+    bool HasDecodeFailed() const { return m_scheduler && m_scheduler->HasDecodeFailed(); }
+
+    /**
+     * Average number of frames received per packet sent to the decoder
+     */
+    double GetFramesPerPacket() const;
+
+    /**
+     * Texture holding the current frame
+     * Software frames are converted at the size they are shown at on the
+     * target monitor (scaling mode 0=Fill, 1=Fit, 2=Stretch, 3=Center),
+     * reading only the part Fill and Center leave on screen;
+     * a target of 0x0 converts the whole frame at the source size
+     */
+    ID3D11Texture2D* GetFrameTexture(int targetWidth = 0, int targetHeight = 0, int scalingMode = 0);
+
+    /**
+     * Current decoded frame, for images (or when no decode thread is running)
+     * Animation frames carry pts/duration in microseconds from the first frame
+     */
+    const AVFrame* GetCurrentFrame() const { return m_frame; }
+
+    /**
+     * Reference to the current frame that stays valid after the decoder moves on
+     * Shares the decoded buffers (or D3D11 surface) instead of copying them
+     */
+    FrameHandle AcquireFrame() const { return FrameHandle(m_frame); }
+
+    /**
+     * Frame buffers the software decoder's pool has allocated so far, 0 when
+     * decoding in hardware
+     */
+    uint64_t GetFrameBufferAllocations() const;
+
     /**
      * Get texture array index for D3D11VA frames
      */
@@ -38,41 +140,162 @@ public:
     
     int GetWidth() const { return m_width; }
     int GetHeight() const { return m_height; }
+
+    /**
+     * Size of the part of the frame held by the last texture from GetFrameTexture,
+     * in stream pixels; smaller than GetWidth/GetHeight when off-screen margins are cropped
+     */
+    int GetVisibleWidth() const { return m_visibleWidth; }
+    int GetVisibleHeight() const { return m_visibleHeight; }
     double GetDuration() const { return m_duration; }
     double GetFrameRate() const { return m_frameRate; }
-    bool IsEndOfFile() const { return m_eof; }
+    bool IsEndOfFile() const { return m_eof.load(); }
     bool IsImage() const { return m_isImage; }
+    bool IsAnimation() const { return m_isAnimation; } // Animated GIF/APNG/WebP, also reported as an image
     
-    void Seek(double timeSeconds);
+    void Seek(double timeSeconds); // Lands on the keyframe at or before the time
     void Reset(); // Seek to beginning
 
+    /**
+     * Seek to the frame that is on screen at the given time
+     * Jumps to the enclosing GOP through the keyframe index, then decodes
+     * forward without converting or uploading the frames in between
+     * @return false if the time is past the end of the stream
+     */
+    bool SeekExact(double timeSeconds);
+
+    /**
+     * SeekExact can jump straight to the GOP; containers without an index
+     * are scanned in the background after opening, and seek by timestamp
+     * until the scan is done
+     */
+    bool IsKeyframeIndexReady() const { return m_indexScanDone || m_hasKeyframeIndex; }
+
 private:
+    // Decoder send/receive state
+    enum class DecodeState {
+        Decoding,   // Feeding packets
+        Draining,   // Demuxer hit EOF, flush packet sent
+        Drained     // Decoder returned EOF
+    };
+
     bool OpenFile(const std::wstring& filePath);
     bool FindVideoStream();
     bool InitializeDecoder(ID3D11Device* device);
     bool SetupHardwareAcceleration(ID3D11Device* device);
+    void ApplyThreadingPolicy(AVCodecContext* codecContext, const AVCodec* codec);
+    bool ReopenCodecIfNeeded();
+    void ApplyDecodeMode();
+    int GetLowres(DecodeMode mode) const;
+    static const char* GetDecodeModeName(DecodeMode mode);
+    bool DecodeFrame(AVFrame* frame);
+    void LogDecodeStats();
+    void LogConversionStats(int cropWidth, int cropHeight, int outputWidth, int outputHeight, int bands);
+    bool ProduceFrame(FrameQueue& queue) override;
+    bool LoopPlayback(FrameQueue& queue);
+    bool ReplayLoopHead(FrameQueue& queue);
+    void RetainLoopHead(const AVFrame* frame);
+    void UpdateLoopHeadSpan();
+    void ReleaseLoopHead();
+    static size_t GetFrameBytes(const AVFrame* frame);
+    int64_t GetRelativePts(const AVFrame* frame) const;
+    void TimestampFrame(AVFrame* frame);
+    int64_t GetKeyframeHoldDuration(const AVFrame* frame, int64_t frameDuration) const;
+    bool SeekStream(double timeSeconds);
+    bool SeekToKeyframe(int keyframe, int64_t target);
+    bool DecodeUntil(int64_t target, int* framesDecoded, bool* overshot);
+    void FlushDecoder();
+    void LoadKeyframeIndex();
+    void StartIndexScan();
+    void StopIndexScan();
+    void IndexScanMain(std::string utf8Path, int streamIndex, std::wstring filePath);
+    void AdoptScannedIndex();
+    void ResetTimeline();
 
+    std::unique_ptr<MappedFileInput> m_input;
+    std::unique_ptr<ClipInput> m_clipInput; // Replaces m_input for pre-converted clips
     AVFormatContext* m_formatContext;
     AVCodecContext* m_codecContext;
-    AVFrame* m_frame;
+    AVFrame* m_frame;       // Current (presented) frame
+    AVFrame* m_decodeFrame; // Scratch frame owned by the decode thread
     AVPacket* m_packet;
+    bool m_packetPending; // m_packet was refused by the decoder and must be resent
+    DecodeState m_decodeState;
     AVBufferRef* m_hwDeviceCtx;
+    std::unique_ptr<FramePool> m_framePool; // Software decoding only
     
     // Software frame upload
-    struct SwsContext* m_swsContext;
-    AVFrame* m_rgbaFrame;
+    std::unique_ptr<FrameConverter> m_frameConverter;
     ComPtr<ID3D11Texture2D> m_softwareTexture;
     ID3D11Device* m_device;
     bool m_textureUploaded;
+    uint64_t m_frameSerial;
+    uint64_t m_outputSerial;          // Frame the output requests below belong to
+    OutputRequest m_request;          // Merged requests of the windows during this frame
+    OutputRequest m_previousRequest;
+    int m_visibleWidth;               // Part of the frame in the texture, in stream pixels
+    int m_visibleHeight;
+    int m_convertedFrames;
+    double m_convertTime;
+
+    // Software decode threading
+    std::atomic<int> m_activeStreams;
+    std::atomic<bool> m_onBattery;
+    ThreadingPolicy::Choice m_threading;
+
+    // Decode mode, requested by the main thread and applied by the decoding thread
+    std::atomic<DecodeMode> m_requestedMode;
+    DecodeMode m_decodeMode;
+    bool m_framesSkipped; // Frames were dropped on purpose during this pass
+    bool m_awaitKeyframe; // Drop packets until a keyframe after leaving keyframes-only mode
+    DecoderOptions m_options;
+    std::wstring m_filePath;
+    KeyframeIndex m_keyframeIndex;
+    std::atomic<bool> m_hasKeyframeIndex; // m_keyframeIndex is filled, readable from any thread
+
+    // Keyframe scan for containers without an index, on its own demuxer
+    std::thread m_indexThread;
+    std::atomic<bool> m_stopIndexScan;
+    std::atomic<bool> m_indexScanDone;
+    KeyframeIndex m_scannedIndex; // Owned by m_indexThread until m_indexScanDone
+
+    // Decode-ahead thread and presentation schedule (videos only)
+    std::unique_ptr<PlaybackScheduler> m_scheduler;
+
+    // Presentation timeline (microseconds, continuous across loops)
+    int64_t m_streamStartTime; // Stream time base
+    PlaybackTimeline m_timeline;
+    int64_t m_defaultFrameDuration;
+
+    // Decode statistics for the current pass through the file
+    std::atomic<int64_t> m_packetsSent;
+    std::atomic<int64_t> m_framesReceived;
+    bool m_fullPass; // Current pass started at the beginning of the file
+    double m_maxReadTime; // Longest av_read_frame call (seconds)
+
+    // Loop pre-roll: first frames of the clip kept decoded (loop-relative pts),
+    // or the entire clip when it fits the loop cache budget
+    std::vector<AVFrame*> m_loopHead;
+    size_t m_loopHeadBytes;
+    int64_t m_loopHeadEnd;
+    int64_t m_loopHeadDuration;
+    bool m_loopHeadComplete;
+    bool m_loopHeadDegraded; // Holds frames decoded outside normal mode
+    bool m_loopCached; // Every loop is replayed from m_loopHead, decoder idle
+    bool m_replayingLoopHead; // Queuing m_loopHead instead of decoding
+    size_t m_loopReplayPosition; // Next m_loopHead frame to queue
+    int64_t m_skipThroughPts; // Drop re-decoded frames up to here after a loop
 
     int m_width;
     int m_height;
     double m_duration;
     double m_frameRate;
     int m_videoStreamIndex;
-    bool m_eof;
+    std::atomic<bool> m_eof;
     bool m_initialized;
     bool m_isImage;
+    bool m_isAnimation;
+    bool m_probeCached; // Stream parameters came from ProbeCache instead of avformat_find_stream_info
 };
 
 } // namespace PixelMotion
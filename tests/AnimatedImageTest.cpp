@@ -0,0 +1,195 @@
+#include "video/AnimatedImage.h"
+#include "video/VideoDecoder.h"
+#include "support/TestMedia.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+using Microsoft::WRL::ComPtr;
+
+namespace PixelMotion {
+namespace {
+
+// GIF delays are whole centiseconds
+const std::vector<int> FRAME_DELAYS_MS = {100, 50, 200};
+constexpr int FRAME_COUNT = 6;
+
+/**
+ * Animations generated in one container, decoded on a WARP device so no GPU is needed
+ */
+class AnimatedImageTest : public ::testing::TestWithParam<const char*> {
+protected:
+    void SetUp() override {
+        if (!HasEncoder(GetParam())) {
+            GTEST_SKIP() << GetParam() << " encoder not available";
+        }
+        if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                                     &m_device, nullptr, &m_context))) {
+            GTEST_SKIP() << "WARP device not available";
+        }
+
+        ClipSpec spec;
+        spec.codec = GetParam();
+        spec.frameCount = FRAME_COUNT;
+        spec.frameDurationsMs = FRAME_DELAYS_MS;
+        m_path = MakeTempPath(std::string("animation.") + GetParam());
+        ASSERT_TRUE(WriteClip(m_path, spec));
+
+        ASSERT_TRUE(m_decoder.Initialize(std::filesystem::path(m_path).wstring(), nullptr));
+        ASSERT_TRUE(m_decoder.IsAnimation());
+        ASSERT_TRUE(m_decoder.DecodeNextFrame());
+        m_image = AnimatedImage::Decode(m_decoder, m_device.Get());
+        ASSERT_NE(m_image, nullptr);
+    }
+
+    void TearDown() override {
+        m_image.reset();
+        m_decoder.Shutdown();
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    // BGRA contents of the animation's texture
+    std::vector<uint8_t> ReadTexture() {
+        D3D11_TEXTURE2D_DESC desc = {};
+        m_image->GetTexture()->GetDesc(&desc);
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+        ComPtr<ID3D11Texture2D> staging;
+        std::vector<uint8_t> pixels;
+        if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &staging))) {
+            ADD_FAILURE() << "Failed to create staging texture";
+            return pixels;
+        }
+        m_context->CopyResource(staging.Get(), m_image->GetTexture());
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(m_context->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped))) {
+            ADD_FAILURE() << "Failed to map staging texture";
+            return pixels;
+        }
+        size_t rowBytes = static_cast<size_t>(desc.Width) * 4;
+        pixels.resize(rowBytes * desc.Height);
+        for (UINT y = 0; y < desc.Height; y++) {
+            std::memcpy(pixels.data() + y * rowBytes, static_cast<const uint8_t*>(mapped.pData) + y * mapped.RowPitch,
+                        rowBytes);
+        }
+        m_context->Unmap(staging.Get(), 0);
+        return pixels;
+    }
+
+    // Every frame of the file as plain FFmpeg decodes it, converted like AnimatedImage converts
+    std::vector<std::vector<uint8_t>> ReadReferenceFrames() {
+        std::vector<std::vector<uint8_t>> frames;
+        ClipReader reader;
+        if (!reader.Open(m_path)) {
+            ADD_FAILURE() << "Failed to open " << m_path;
+            return frames;
+        }
+
+        AVFrame* frame = av_frame_alloc();
+        SwsContext* swsContext = nullptr;
+        while (reader.ReadFrame(frame)) {
+            swsContext = sws_getCachedContext(swsContext, frame->width, frame->height,
+                                              static_cast<AVPixelFormat>(frame->format), frame->width, frame->height,
+                                              AV_PIX_FMT_BGRA, SWS_POINT, nullptr, nullptr, nullptr);
+            std::vector<uint8_t> pixels(static_cast<size_t>(frame->width) * frame->height * 4);
+            uint8_t* dstData[1] = { pixels.data() };
+            int dstLinesize[1] = { frame->width * 4 };
+            sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dstData, dstLinesize);
+            frames.push_back(std::move(pixels));
+            av_frame_unref(frame);
+        }
+        sws_freeContext(swsContext);
+        av_frame_free(&frame);
+        return frames;
+    }
+
+    ComPtr<ID3D11Device> m_device;
+    ComPtr<ID3D11DeviceContext> m_context;
+    std::string m_path;
+    VideoDecoder m_decoder;
+    std::shared_ptr<AnimatedImage> m_image;
+};
+
+TEST_P(AnimatedImageTest, KeepsEveryFrameWithItsDelay) {
+    ASSERT_EQ(m_image->GetFrameCount(), FRAME_COUNT);
+
+    int64_t start = 0;
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        int64_t delay = FRAME_DELAYS_MS[i % FRAME_DELAYS_MS.size()] * 1000;
+        EXPECT_EQ(m_image->GetFrameStart(i), start) << "frame " << i;
+        EXPECT_EQ(m_image->GetFrameDuration(i), delay) << "frame " << i;
+        start += delay;
+    }
+    EXPECT_EQ(m_image->GetLoopDuration(), start);
+}
+
+TEST_P(AnimatedImageTest, PlaybackFollowsFrameDelays) {
+    const double startTime = 100.0;
+    EXPECT_FALSE(m_image->UpdatePlayback(startTime)); // Frame 0 is already in the texture
+    uint64_t serial = m_image->GetFrameSerial();
+
+    // Just inside each frame's slot, for two loops
+    for (int i = 1; i <= 2 * FRAME_COUNT; i++) {
+        int frame = i % FRAME_COUNT;
+        double slotStart = startTime + static_cast<double>((i / FRAME_COUNT) * m_image->GetLoopDuration() +
+                                                           m_image->GetFrameStart(frame)) / 1.0e6;
+        double slotEnd = slotStart + static_cast<double>(m_image->GetFrameDuration(frame)) / 1.0e6;
+
+        EXPECT_FALSE(m_image->UpdatePlayback(slotStart - 0.001)) << "frame " << i << " shown early";
+        EXPECT_TRUE(m_image->UpdatePlayback(slotStart + 0.001)) << "frame " << i << " not shown";
+        EXPECT_EQ(m_image->GetFrameSerial(), ++serial);
+        EXPECT_NEAR(m_image->GetTimeToNextFrame(slotStart + 0.001), slotEnd - slotStart - 0.001, 1.0e-5);
+    }
+}
+
+TEST_P(AnimatedImageTest, TextureMatchesEveryDecodedFrame) {
+    std::vector<std::vector<uint8_t>> reference = ReadReferenceFrames();
+    ASSERT_EQ(static_cast<int>(reference.size()), FRAME_COUNT);
+
+    // Deltas applied in order, then wrapping back to frame 0, rebuild each whole frame
+    const double startTime = 100.0;
+    m_image->UpdatePlayback(startTime);
+    EXPECT_EQ(ReadTexture(), reference[0]) << "frame 0";
+    for (int i = 1; i <= FRAME_COUNT; i++) {
+        int frame = i % FRAME_COUNT;
+        double slotStart = startTime + static_cast<double>((i / FRAME_COUNT) * m_image->GetLoopDuration() +
+                                                           m_image->GetFrameStart(frame)) / 1.0e6;
+        ASSERT_TRUE(m_image->UpdatePlayback(slotStart + 0.001));
+        EXPECT_EQ(ReadTexture(), reference[frame]) << "frame " << frame << " after " << i << " steps";
+    }
+}
+
+TEST_P(AnimatedImageTest, SkippedFramesAreStillApplied) {
+    std::vector<std::vector<uint8_t>> reference = ReadReferenceFrames();
+    ASSERT_EQ(static_cast<int>(reference.size()), FRAME_COUNT);
+
+    // A late tick jumps straight to the last frame
+    const double startTime = 100.0;
+    m_image->UpdatePlayback(startTime);
+    int last = FRAME_COUNT - 1;
+    ASSERT_TRUE(m_image->UpdatePlayback(startTime + static_cast<double>(m_image->GetFrameStart(last)) / 1.0e6 + 0.001));
+    EXPECT_EQ(ReadTexture(), reference[last]);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, AnimatedImageTest, ::testing::Values("gif", "apng"),
+                         [](const ::testing::TestParamInfo<const char*>& info) {
+                             return std::string(info.param);
+                         });
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,169 @@
+#include "video/ColorConverter.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace PixelMotion {
+namespace {
+
+using Format = ColorConverter::Format;
+using Kernel = ColorConverter::Kernel;
+using Matrix = ColorConverter::Matrix;
+
+/**
+ * Random 4:2:0 picture in one of the converter's layouts, with row padding
+ * so strides differ from the width
+ */
+struct TestPicture {
+    std::vector<uint8_t> planes[3];
+    const uint8_t* data[3] = {};
+    int linesize[3] = {};
+
+    TestPicture(Format format, int width, int height, uint32_t seed) {
+        std::mt19937 random(seed);
+        int bytesPerSample = (format == Format::P010) ? 2 : 1;
+        int chromaWidth = (width + 1) / 2;
+        int chromaHeight = (height + 1) / 2;
+
+        int planeCount = (format == Format::YUV420P) ? 3 : 2;
+        for (int p = 0; p < planeCount; p++) {
+            int samples = (p == 0) ? width : (format == Format::YUV420P ? chromaWidth : chromaWidth * 2);
+            int rows = (p == 0) ? height : chromaHeight;
+            linesize[p] = samples * bytesPerSample + 32;
+            planes[p].resize(static_cast<size_t>(linesize[p]) * rows);
+
+            if (format == Format::P010) {
+                // 10 significant bits at the top of each 16-bit sample
+                auto* samples16 = reinterpret_cast<uint16_t*>(planes[p].data());
+                for (size_t i = 0; i < planes[p].size() / 2; i++) {
+                    samples16[i] = static_cast<uint16_t>((random() & 0x3FF) << 6);
+                }
+            } else {
+                for (auto& sample : planes[p]) {
+                    sample = static_cast<uint8_t>(random());
+                }
+            }
+            data[p] = planes[p].data();
+        }
+    }
+};
+
+const char* GetFormatName(Format format) {
+    switch (format) {
+        case Format::NV12: return "NV12";
+        case Format::YUV420P: return "YUV420P";
+        default: return "P010";
+    }
+}
+
+std::vector<uint8_t> Convert(Kernel kernel, Format format, const TestPicture& picture, int width, int height,
+                             Matrix matrix, bool fullRange) {
+    int pitch = width * 4 + 64;
+    std::vector<uint8_t> output(static_cast<size_t>(pitch) * height, 0xCD);
+    EXPECT_TRUE(ColorConverter::Convert(kernel, format, picture.data, picture.linesize, width, height,
+                                        output.data(), pitch, matrix, fullRange));
+
+    // Only the pixels may be written, never the pitch padding
+    for (int y = 0; y < height; y++) {
+        const uint8_t* padding = output.data() + static_cast<size_t>(y) * pitch + width * 4;
+        EXPECT_TRUE(std::all_of(padding, padding + (pitch - width * 4), [](uint8_t b) { return b == 0xCD; }))
+            << "row " << y;
+    }
+    return output;
+}
+
+class ColorConverterKernelTest : public ::testing::TestWithParam<Kernel> {};
+
+TEST_P(ColorConverterKernelTest, MatchesScalarReference) {
+    Kernel kernel = GetParam();
+    if (!ColorConverter::IsSupported(kernel)) {
+        GTEST_SKIP() << ColorConverter::GetKernelName(kernel) << " not supported by this CPU";
+    }
+
+    // Widths around every vector width, so the scalar tail is exercised too
+    const int widths[] = {2, 6, 8, 14, 16, 18, 30, 32, 34, 62, 66, 1280, 1922};
+    for (Format format : {Format::NV12, Format::YUV420P, Format::P010}) {
+        for (Matrix matrix : {Matrix::BT601, Matrix::BT709}) {
+            for (bool fullRange : {false, true}) {
+                for (int width : widths) {
+                    SCOPED_TRACE(std::string(GetFormatName(format)) + (matrix == Matrix::BT709 ? " BT.709" : " BT.601") +
+                                 (fullRange ? " full" : " limited") + " width " + std::to_string(width));
+                    int height = 6;
+                    TestPicture picture(format, width, height, static_cast<uint32_t>(width));
+                    std::vector<uint8_t> expected = Convert(Kernel::Scalar, format, picture, width, height, matrix, fullRange);
+                    std::vector<uint8_t> actual = Convert(kernel, format, picture, width, height, matrix, fullRange);
+                    ASSERT_EQ(actual, expected);
+                }
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllKernels, ColorConverterKernelTest,
+                         ::testing::Values(Kernel::SSE41, Kernel::AVX2, Kernel::AVX512),
+                         [](const ::testing::TestParamInfo<Kernel>& info) {
+                             return std::string(info.param == Kernel::SSE41 ? "SSE41" :
+                                                info.param == Kernel::AVX2 ? "AVX2" : "AVX512");
+                         });
+
+TEST(ColorConverterTest, ScalarMatchesFloatingPointMatrix) {
+    // The 13-bit fixed-point coefficients stay within one level of exact math
+    for (Matrix matrix : {Matrix::BT601, Matrix::BT709}) {
+        for (bool fullRange : {false, true}) {
+            double kr = (matrix == Matrix::BT709) ? 0.2126 : 0.299;
+            double kb = (matrix == Matrix::BT709) ? 0.0722 : 0.114;
+            double kg = 1.0 - kr - kb;
+            double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+            double uvScale = fullRange ? 1.0 : 255.0 / 224.0;
+
+            TestPicture picture(Format::YUV420P, 64, 64, 7);
+            std::vector<uint8_t> output = Convert(Kernel::Scalar, Format::YUV420P, picture, 64, 64, matrix, fullRange);
+            int pitch = 64 * 4 + 64;
+
+            for (int y = 0; y < 64; y++) {
+                for (int x = 0; x < 64; x++) {
+                    double luma = (picture.data[0][y * picture.linesize[0] + x] - (fullRange ? 0 : 16)) * yScale;
+                    double u = (picture.data[1][(y / 2) * picture.linesize[1] + x / 2] - 128) * uvScale;
+                    double v = (picture.data[2][(y / 2) * picture.linesize[2] + x / 2] - 128) * uvScale;
+                    double r = luma + 2.0 * (1.0 - kr) * v;
+                    double g = luma - 2.0 * (1.0 - kb) * kb / kg * u - 2.0 * (1.0 - kr) * kr / kg * v;
+                    double b = luma + 2.0 * (1.0 - kb) * u;
+
+                    const uint8_t* pixel = output.data() + y * pitch + x * 4;
+                    EXPECT_NEAR(pixel[0], std::clamp(b, 0.0, 255.0), 1.0);
+                    EXPECT_NEAR(pixel[1], std::clamp(g, 0.0, 255.0), 1.0);
+                    EXPECT_NEAR(pixel[2], std::clamp(r, 0.0, 255.0), 1.0);
+                    EXPECT_EQ(pixel[3], 255);
+                }
+            }
+        }
+    }
+}
+
+TEST(ColorConverterTest, RowBandsMatchWholeFrame) {
+    const int width = 96;
+    const int height = 40;
+    TestPicture picture(Format::NV12, width, height, 3);
+
+    int pitch = width * 4;
+    std::vector<uint8_t> whole(static_cast<size_t>(pitch) * height);
+    ColorConverter::Convert(Format::NV12, picture.data, picture.linesize, width, height, whole.data(), pitch,
+                            Matrix::BT709, false);
+
+    // Bands may start on odd rows, in the middle of a chroma row pair
+    std::vector<uint8_t> banded(whole.size());
+    const int bounds[] = {0, 7, 8, 21, 40};
+    for (int i = 0; i + 1 < 5; i++) {
+        ColorConverter::ConvertRows(Format::NV12, picture.data, picture.linesize, width, bounds[i], bounds[i + 1],
+                                    banded.data(), pitch, Matrix::BT709, false);
+    }
+    EXPECT_EQ(banded, whole);
+}
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,71 @@
+#include "video/ConversionPool.h"
+#include "video/ThreadingPolicy.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace PixelMotion {
+namespace {
+
+/**
+ * Run one job and check every band ran exactly once before Run returned
+ */
+void ExpectEachBandOnce(int bands) {
+    std::vector<std::atomic<int>> runs(bands);
+    ConversionPool::GetInstance().Run(bands, [&](int band) {
+        ASSERT_GE(band, 0);
+        ASSERT_LT(band, bands);
+        runs[band]++;
+    });
+
+    for (int band = 0; band < bands; band++) {
+        ASSERT_EQ(runs[band].load(), 1) << "band " << band << " of " << bands;
+    }
+}
+
+TEST(ConversionPoolTest, RunsEveryBandExactlyOnce) {
+    // Back-to-back jobs, so a worker late for one job can't run bands of the next
+    for (int repeat = 0; repeat < 200; repeat++) {
+        for (int bands : {1, 2, 3, 7, 16, 61}) {
+            ExpectEachBandOnce(bands);
+        }
+    }
+}
+
+TEST(ConversionPoolTest, ConcurrentCallersEachGetTheirBands) {
+    // Decoders of different monitors convert from their own threads
+    std::vector<std::thread> callers;
+    for (int caller = 0; caller < 4; caller++) {
+        callers.emplace_back([caller] {
+            for (int repeat = 0; repeat < 50; repeat++) {
+                ExpectEachBandOnce(3 + caller * 4);
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+}
+
+TEST(ConversionPoolTest, BandsFollowFrameSizeAndCores) {
+    int threads = 16;
+    int bands1080 = ThreadingPolicy::ChooseConversionBands(1920, 1080, threads, false);
+    int bands1440 = ThreadingPolicy::ChooseConversionBands(2560, 1440, threads, false);
+    int bands2160 = ThreadingPolicy::ChooseConversionBands(3840, 2160, threads, false);
+
+    EXPECT_EQ(ThreadingPolicy::ChooseConversionBands(640, 360, threads, false), 1);
+    EXPECT_GT(bands1080, 1);
+    EXPECT_GT(bands1440, bands1080);
+    EXPECT_GT(bands2160, bands1440);
+
+    // Never more bands than threads, and fewer on battery
+    EXPECT_LE(ThreadingPolicy::ChooseConversionBands(7680, 4320, threads, false), threads);
+    EXPECT_EQ(ThreadingPolicy::ChooseConversionBands(3840, 2160, 2, false), 2);
+    EXPECT_LT(ThreadingPolicy::ChooseConversionBands(3840, 2160, threads, true), bands2160);
+    EXPECT_EQ(ThreadingPolicy::ChooseConversionBands(3840, 2160, 1, true), 1);
+}
+
+} // namespace
+} // namespace PixelMotion
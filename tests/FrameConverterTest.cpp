@@ -0,0 +1,255 @@
+#include "video/ColorConverter.h"
+#include "video/FrameConverter.h"
+#include "video/ThreadingPolicy.h"
+#include "support/TestMedia.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+struct CropCase {
+    int width;
+    int height;
+    int cropWidth; // Requested; GetCroppedPlanes may widen it
+    int cropHeight;
+};
+
+// Odd sizes and odd requests, so widening to whole chroma samples is exercised
+const CropCase CROP_CASES[] = {
+    {1920, 1080, 1920, 1080},
+    {1920, 1080, 1440, 1080},
+    {1920, 1080, 1920, 823},
+    {1920, 1080, 607, 1079},
+    {1281, 721, 1001, 333},
+    {640, 360, 2, 2},
+};
+
+const AVPixelFormat CROP_FORMATS[] = {
+    AV_PIX_FMT_NV12, AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_P010LE,
+    AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P, AV_PIX_FMT_RGB24, AV_PIX_FMT_GRAY8,
+};
+
+std::string Describe(AVPixelFormat format, const CropCase& test) {
+    return std::string(av_get_pix_fmt_name(format)) + " " + std::to_string(test.width) + "x" +
+           std::to_string(test.height) + " crop " + std::to_string(test.cropWidth) + "x" +
+           std::to_string(test.cropHeight);
+}
+
+/**
+ * First pass of the reference: FFmpeg crops a reference to the frame itself
+ */
+AVFrame* CropWithFFmpeg(const AVFrame* frame, int cropWidth, int cropHeight) {
+    AVFrame* cropped = av_frame_clone(frame);
+    if (!cropped) {
+        return nullptr;
+    }
+    cropped->crop_left = (frame->width - cropWidth) / 2;
+    cropped->crop_right = frame->width - cropWidth - cropped->crop_left;
+    cropped->crop_top = (frame->height - cropHeight) / 2;
+    cropped->crop_bottom = frame->height - cropHeight - cropped->crop_top;
+    if (av_frame_apply_cropping(cropped, AV_FRAME_CROP_UNALIGNED) < 0) {
+        av_frame_free(&cropped);
+    }
+    return cropped;
+}
+
+/**
+ * Second pass of the reference: one swscale call over the cropped frame, set
+ * up the way FrameConverter sets up its scalers for BT.709 limited range
+ */
+std::vector<uint8_t> ScaleWithFFmpeg(const AVFrame* cropped, int outputWidth, int outputHeight) {
+    std::vector<uint8_t> output(static_cast<size_t>(outputWidth) * 4 * outputHeight);
+    SwsContext* context = sws_getContext(cropped->width, cropped->height, static_cast<AVPixelFormat>(cropped->format),
+                                         outputWidth, outputHeight, AV_PIX_FMT_BGRA,
+                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!context) {
+        ADD_FAILURE() << "Failed to create swscale context";
+        return output;
+    }
+    sws_setColorspaceDetails(context, sws_getCoefficients(SWS_CS_ITU709), 0,
+                             sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+
+    uint8_t* dst[4] = {output.data(), nullptr, nullptr, nullptr};
+    int dstStride[4] = {outputWidth * 4, 0, 0, 0};
+    sws_scale(context, cropped->data, cropped->linesize, 0, cropped->height, dst, dstStride);
+    sws_freeContext(context);
+    return output;
+}
+
+AVFrame* MakeTaggedFrame(AVPixelFormat format, int width, int height) {
+    AVFrame* frame = MakeNoiseFrame(format, width, height, static_cast<uint32_t>(width * 31 + height));
+    if (frame) {
+        frame->colorspace = AVCOL_SPC_BT709;
+        frame->color_range = AVCOL_RANGE_MPEG;
+    }
+    return frame;
+}
+
+TEST(FrameConverterTest, CroppedPlanesMatchFFmpegCropping) {
+    for (AVPixelFormat format : CROP_FORMATS) {
+        for (const CropCase& test : CROP_CASES) {
+            SCOPED_TRACE(Describe(format, test));
+            AVFrame* frame = MakeTaggedFrame(format, test.width, test.height);
+            ASSERT_NE(frame, nullptr);
+
+            int cropWidth = test.cropWidth;
+            int cropHeight = test.cropHeight;
+            const uint8_t* planes[4];
+            ASSERT_TRUE(FrameConverter::GetCroppedPlanes(frame, cropWidth, cropHeight, planes));
+
+            // Widened to whole chroma samples on both sides, never narrowed
+            const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+            EXPECT_GE(cropWidth, test.cropWidth);
+            EXPECT_GE(cropHeight, test.cropHeight);
+            EXPECT_EQ((test.width - cropWidth) / 2 % (1 << desc->log2_chroma_w), 0);
+            EXPECT_EQ((test.height - cropHeight) / 2 % (1 << desc->log2_chroma_h), 0);
+
+            AVFrame* cropped = CropWithFFmpeg(frame, cropWidth, cropHeight);
+            ASSERT_NE(cropped, nullptr);
+            EXPECT_EQ(cropped->width, cropWidth);
+            EXPECT_EQ(cropped->height, cropHeight);
+            for (int p = 0; p < 4; p++) {
+                EXPECT_EQ(planes[p], cropped->data[p]) << "plane " << p;
+            }
+
+            av_frame_free(&cropped);
+            av_frame_free(&frame);
+        }
+    }
+}
+
+TEST(FrameConverterTest, HardwareFramesAreNotCropped) {
+    AVFrame frame = {};
+    frame.format = AV_PIX_FMT_D3D11;
+    frame.width = 1920;
+    frame.height = 1080;
+    int cropWidth = 1440;
+    int cropHeight = 1080;
+    const uint8_t* planes[4];
+    EXPECT_FALSE(FrameConverter::GetCroppedPlanes(&frame, cropWidth, cropHeight, planes));
+}
+
+TEST(FrameConverterTest, ScaledCropMatchesCropThenScaleReference) {
+    FrameConverter converter;
+    for (AVPixelFormat format : {AV_PIX_FMT_NV12, AV_PIX_FMT_YUV420P, AV_PIX_FMT_P010LE, AV_PIX_FMT_YUV444P}) {
+        for (const CropCase& test : CROP_CASES) {
+            SCOPED_TRACE(Describe(format, test));
+            AVFrame* frame = MakeTaggedFrame(format, test.width, test.height);
+            ASSERT_NE(frame, nullptr);
+
+            int cropWidth = test.cropWidth;
+            int cropHeight = test.cropHeight;
+            const uint8_t* planes[4];
+            ASSERT_TRUE(FrameConverter::GetCroppedPlanes(frame, cropWidth, cropHeight, planes));
+            if (cropWidth < 16 || cropHeight < 16) {
+                av_frame_free(&frame);
+                continue; // Nothing left to scale down meaningfully
+            }
+            int outputWidth = cropWidth * 2 / 3;
+            int outputHeight = cropHeight * 2 / 3;
+
+            AVFrame* cropped = CropWithFFmpeg(frame, cropWidth, cropHeight);
+            ASSERT_NE(cropped, nullptr);
+            std::vector<uint8_t> expected = ScaleWithFFmpeg(cropped, outputWidth, outputHeight);
+
+            // Banding must not change a single pixel
+            for (int bands : {1, 3, 8}) {
+                SCOPED_TRACE(std::to_string(bands) + " bands");
+                std::vector<uint8_t> actual(expected.size());
+                ASSERT_TRUE(converter.Convert(frame, planes, cropWidth, cropHeight, actual.data(), outputWidth * 4,
+                                              outputWidth, outputHeight, bands));
+                ASSERT_EQ(actual, expected);
+            }
+
+            av_frame_free(&cropped);
+            av_frame_free(&frame);
+        }
+    }
+}
+
+TEST(FrameConverterTest, UnscaledCropMatchesCropThenConvertReference) {
+    FrameConverter converter;
+    const struct {
+        AVPixelFormat pixelFormat;
+        ColorConverter::Format format;
+    } formats[] = {
+        {AV_PIX_FMT_NV12, ColorConverter::Format::NV12},
+        {AV_PIX_FMT_YUV420P, ColorConverter::Format::YUV420P},
+        {AV_PIX_FMT_P010LE, ColorConverter::Format::P010},
+    };
+
+    for (const auto& format : formats) {
+        for (const CropCase& test : CROP_CASES) {
+            SCOPED_TRACE(Describe(format.pixelFormat, test));
+            AVFrame* frame = MakeTaggedFrame(format.pixelFormat, test.width, test.height);
+            ASSERT_NE(frame, nullptr);
+
+            int cropWidth = test.cropWidth;
+            int cropHeight = test.cropHeight;
+            const uint8_t* planes[4];
+            ASSERT_TRUE(FrameConverter::GetCroppedPlanes(frame, cropWidth, cropHeight, planes));
+
+            AVFrame* cropped = CropWithFFmpeg(frame, cropWidth, cropHeight);
+            ASSERT_NE(cropped, nullptr);
+            int pitch = cropWidth * 4;
+            std::vector<uint8_t> expected(static_cast<size_t>(pitch) * cropHeight);
+            ASSERT_TRUE(ColorConverter::Convert(ColorConverter::Kernel::Scalar, format.format, cropped->data,
+                                                cropped->linesize, cropWidth, cropHeight, expected.data(), pitch,
+                                                ColorConverter::Matrix::BT709, false));
+
+            for (int bands : {1, 4}) {
+                SCOPED_TRACE(std::to_string(bands) + " bands");
+                std::vector<uint8_t> actual(expected.size());
+                ASSERT_TRUE(converter.Convert(frame, planes, cropWidth, cropHeight, actual.data(), pitch,
+                                              cropWidth, cropHeight, bands));
+                ASSERT_EQ(actual, expected);
+            }
+
+            av_frame_free(&cropped);
+            av_frame_free(&frame);
+        }
+    }
+}
+
+TEST(FrameConverterTest, PolicyBandsMatchSinglePass) {
+    // The band counts the decoder actually picks at common output sizes, scaled and not
+    FrameConverter converter;
+    for (int height : {1080, 1440, 2160}) {
+        int width = height * 16 / 9;
+        for (bool scaled : {false, true}) {
+            SCOPED_TRACE(std::to_string(height) + (scaled ? "p scaled" : "p"));
+            int sourceWidth = scaled ? width * 4 / 3 : width;
+            int sourceHeight = scaled ? height * 4 / 3 : height;
+            AVFrame* frame = MakeTaggedFrame(AV_PIX_FMT_NV12, sourceWidth, sourceHeight);
+            ASSERT_NE(frame, nullptr);
+
+            int pitch = width * 4;
+            std::vector<uint8_t> expected(static_cast<size_t>(pitch) * height);
+            ASSERT_TRUE(converter.Convert(frame, frame->data, sourceWidth, sourceHeight, expected.data(), pitch,
+                                          width, height, 1));
+
+            int bands = ThreadingPolicy::ChooseConversionBands(width, height, 16, false);
+            ASSERT_GT(bands, 1);
+            std::vector<uint8_t> actual(expected.size());
+            ASSERT_TRUE(converter.Convert(frame, frame->data, sourceWidth, sourceHeight, actual.data(), pitch,
+                                          width, height, bands));
+            EXPECT_EQ(actual, expected) << bands << " bands";
+
+            av_frame_free(&frame);
+        }
+    }
+}
+
+} // namespace
+} // namespace PixelMotion
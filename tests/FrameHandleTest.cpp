@@ -0,0 +1,192 @@
+#include "video/FrameHandle.h"
+#include "video/MediaLoader.h"
+#include "video/StillImageCache.h"
+#include "video/VideoDecoder.h"
+#include "support/TestMedia.h"
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+using Microsoft::WRL::ComPtr;
+
+namespace PixelMotion {
+namespace {
+
+constexpr int CLIP_FRAMES = 30;
+constexpr int LOOPS = 3;
+
+// Windows showing the same decoder, each holding the frame it last drew
+constexpr int WINDOWS = 2;
+
+// Shortest step of the virtual clock, as a message loop's timer resolution
+constexpr double MIN_TICK_INTERVAL = 0.001;
+
+/**
+ * A window's hold on the frame it presents, as WallpaperWindow::BindContent
+ * keeps m_presentedFrame until it draws the next one
+ */
+struct PresentingWindow {
+    FrameHandle presentedFrame;
+    uint64_t frameSerial = 0;
+};
+
+/**
+ * Clips decoded in software, so their frames come from the decoder's FramePool
+ */
+class FrameHandleTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ClipSpec spec;
+        spec.frameCount = CLIP_FRAMES;
+        m_path = MakeTempPath("frame_handle.mp4");
+        ASSERT_TRUE(WriteClip(m_path, spec));
+        // Decoded again on every loop rather than replayed from the loop cache
+        DecoderOptions options;
+        options.loopCacheBudget = 0;
+        ASSERT_TRUE(m_decoder.Initialize(std::filesystem::path(m_path).wstring(), nullptr, options));
+        ASSERT_TRUE(m_decoder.DecodeNextFrame());
+        m_liveAtStart = FrameHandle::GetLiveCount();
+    }
+
+    void TearDown() override {
+        m_decoder.Shutdown();
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    /**
+     * Advance playback on a virtual clock by some frames, each window
+     * acquiring every new frame the way it presents them
+     */
+    void Play(std::vector<PresentingWindow>& windows, int frames) {
+        int presented = 0;
+        while (presented < frames) {
+            if (m_decoder.UpdatePlayback(m_now)) {
+                presented++;
+            }
+            for (PresentingWindow& window : windows) {
+                if (window.frameSerial == m_decoder.GetFrameSerial()) {
+                    continue;
+                }
+                window.presentedFrame = m_decoder.AcquireFrame(); // Releases the previous frame
+                window.frameSerial = m_decoder.GetFrameSerial();
+
+                const AVFrame* current = m_decoder.GetCurrentFrame();
+                EXPECT_TRUE(window.presentedFrame);
+                EXPECT_EQ(window.presentedFrame->data[0], current->data[0]) << "frame " << current->pts;
+                EXPECT_EQ(window.presentedFrame->buf[0]->buffer, current->buf[0]->buffer);
+            }
+            m_now += std::max(m_decoder.GetTimeToNextFrame(m_now), MIN_TICK_INTERVAL);
+        }
+    }
+
+    VideoDecoder m_decoder;
+    std::string m_path;
+    int64_t m_liveAtStart = 0;
+    double m_now = 1000.0; // Virtual wall clock (seconds)
+};
+
+TEST_F(FrameHandleTest, PresentedFramesShareDecoderBuffersAndReturnToThePool) {
+    std::vector<PresentingWindow> windows(WINDOWS);
+    ASSERT_GT(m_decoder.GetFrameBufferAllocations(), 0u) << "not decoding into the frame pool";
+
+    // The first loop fills the pool with a buffer per frame in flight
+    Play(windows, CLIP_FRAMES);
+    uint64_t warmAllocations = m_decoder.GetFrameBufferAllocations();
+    EXPECT_LT(warmAllocations, static_cast<uint64_t>(CLIP_FRAMES));
+    EXPECT_EQ(FrameHandle::GetLiveCount() - m_liveAtStart, WINDOWS);
+
+    // Windows letting go of the frames they drew keeps later loops in those buffers
+    for (int loop = 1; loop < LOOPS; loop++) {
+        Play(windows, CLIP_FRAMES);
+        EXPECT_EQ(m_decoder.GetFrameBufferAllocations(), warmAllocations) << "loop " << loop;
+    }
+
+    // A window may still be drawing when the decoder goes away; its frame stays valid
+    const uint8_t* pixels = windows.front().presentedFrame->data[0];
+    m_decoder.Shutdown();
+    EXPECT_EQ(windows.front().presentedFrame->data[0], pixels);
+    EXPECT_EQ(av_buffer_get_ref_count(windows.front().presentedFrame->buf[0]), WINDOWS);
+
+    windows.clear();
+    EXPECT_EQ(FrameHandle::GetLiveCount(), m_liveAtStart);
+}
+
+TEST_F(FrameHandleTest, CopiesShareTheBufferAndReleaseIt) {
+    // The codec and the loop pre-roll may hold references of their own
+    const AVFrame* current = m_decoder.GetCurrentFrame();
+    ASSERT_NE(current->buf[0], nullptr);
+    int baseRefs = av_buffer_get_ref_count(current->buf[0]);
+    {
+        FrameHandle first = m_decoder.AcquireFrame();
+        FrameHandle copy = first;
+        FrameHandle moved = std::move(first);
+        EXPECT_FALSE(first);
+        EXPECT_EQ(copy->data[0], current->data[0]);
+        EXPECT_EQ(moved->data[0], current->data[0]);
+        EXPECT_EQ(av_buffer_get_ref_count(current->buf[0]), baseRefs + 2);
+
+        copy.Reset();
+        EXPECT_EQ(av_buffer_get_ref_count(current->buf[0]), baseRefs + 1);
+    }
+    EXPECT_EQ(av_buffer_get_ref_count(current->buf[0]), baseRefs);
+    EXPECT_EQ(FrameHandle::GetLiveCount(), m_liveAtStart);
+}
+
+TEST(StillImageFrameTest, SourceFrameIsReleasedWithTheCache) {
+    ComPtr<ID3D11Device> device;
+    if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+                                 &device, nullptr, nullptr))) {
+        GTEST_SKIP() << "WARP device not available";
+    }
+    if (!HasEncoder("png")) {
+        GTEST_SKIP() << "png encoder not available";
+    }
+
+    ClipSpec spec;
+    spec.codec = "png";
+    spec.frameCount = 1;
+    std::string path = MakeTempPath("frame_handle.png");
+    ASSERT_TRUE(WriteClip(path, spec));
+
+    StillImageCache& images = StillImageCache::GetInstance();
+    images.ReleaseSources();
+    int64_t liveAtStart = FrameHandle::GetLiveCount();
+
+    MediaLoader::Request request;
+    request.path = std::filesystem::path(path).wstring();
+    request.device = device.Get();
+    request.targetWidth = 1920;
+    request.targetHeight = 1080;
+    LoadedMedia media = MediaLoader::Load(request);
+    ASSERT_NE(media.image, nullptr);
+    EXPECT_EQ(media.decoder, nullptr);
+
+    // The decoder is gone, but its frame is kept to serve other monitors
+    EXPECT_EQ(FrameHandle::GetLiveCount() - liveAtStart, 1);
+    request.targetWidth = 1280;
+    request.targetHeight = 720;
+    EXPECT_NE(images.Acquire(request.path, request.device, request.targetWidth, request.targetHeight, 0), nullptr);
+
+    // Once every wallpaper is set the decoded pixels go, the converted image stays
+    images.ReleaseSources();
+    EXPECT_EQ(FrameHandle::GetLiveCount(), liveAtStart);
+    EXPECT_NE(media.image->GetTexture(), nullptr);
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+} // namespace
+} // namespace PixelMotion
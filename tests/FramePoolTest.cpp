@@ -0,0 +1,258 @@
+#include "video/FramePool.h"
+#include "video/VideoDecoder.h"
+#include "support/TestMedia.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <malloc.h>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+}
+
+// Heap allocations made through C++ new anywhere in the test process. FFmpeg's
+// own av_malloc can't be intercepted in a shared build, so pooled frame
+// buffers are counted by FramePool and everything else the decoder and the
+// playback path allocate is counted here
+static std::atomic<uint64_t> s_heapAllocations{0};
+
+void* operator new(size_t size) {
+    s_heapAllocations++;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    s_heapAllocations++;
+    if (void* memory = _aligned_malloc(size ? size : 1, static_cast<size_t>(alignment))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { _aligned_free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { _aligned_free(memory); }
+
+namespace PixelMotion {
+namespace {
+
+constexpr int LOOPS = 4;
+
+// Frames held after decoding, as the decode-ahead queue and the presented frame do
+constexpr size_t HELD_FRAMES = 6;
+
+// Allocations allowed once per loop: the end-of-file statistics are logged
+// and the demuxer seeks back to the start
+constexpr uint64_t ALLOCATIONS_PER_LOOP = 64;
+
+// Shortest step of the virtual clock, as a message loop's timer resolution
+constexpr double MIN_TICK_INTERVAL = 0.001;
+
+/**
+ * Software decoder drawing its frames from a FramePool, looping over a file
+ */
+class PooledDecoder {
+public:
+    ~PooledDecoder() {
+        for (AVFrame*& frame : m_held) {
+            av_frame_free(&frame);
+        }
+        av_packet_free(&m_packet);
+        avcodec_free_context(&m_decoder);
+        avformat_close_input(&m_input);
+    }
+
+    bool Open(const std::string& path, int threads) {
+        if (avformat_open_input(&m_input, path.c_str(), nullptr, nullptr) < 0 ||
+            avformat_find_stream_info(m_input, nullptr) < 0) {
+            return false;
+        }
+
+        const AVCodec* codec = nullptr;
+        m_streamIndex = av_find_best_stream(m_input, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+        m_decoder = codec ? avcodec_alloc_context3(codec) : nullptr;
+        m_packet = av_packet_alloc();
+        if (m_streamIndex < 0 || !m_decoder || !m_packet ||
+            avcodec_parameters_to_context(m_decoder, m_input->streams[m_streamIndex]->codecpar) < 0) {
+            return false;
+        }
+
+        // Frames are received into the same shells, as the decoder's queue slots are reused
+        m_held.resize(HELD_FRAMES);
+        for (AVFrame*& frame : m_held) {
+            if (!(frame = av_frame_alloc())) {
+                return false;
+            }
+        }
+
+        m_decoder->thread_count = threads;
+        m_pool.Attach(m_decoder);
+        return avcodec_open2(m_decoder, codec, nullptr) >= 0;
+    }
+
+    /**
+     * Decode the whole file once, from the start
+     * @return frames decoded; the addresses of their buffers go into buffers
+     */
+    int DecodeLoop(std::set<const uint8_t*>& buffers) {
+        av_seek_frame(m_input, -1, 0, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(m_decoder);
+
+        int frames = 0;
+        bool draining = false;
+        while (true) {
+            // Receiving into the oldest shell lets go of the frame it held
+            AVFrame* frame = m_held[m_next];
+            av_frame_unref(frame);
+            int ret = avcodec_receive_frame(m_decoder, frame);
+            if (ret >= 0) {
+                buffers.insert(frame->buf[0]->data);
+                frames++;
+                m_next = (m_next + 1) % m_held.size();
+                continue;
+            }
+            if (ret != AVERROR(EAGAIN)) {
+                return frames;
+            }
+
+            if (av_read_frame(m_input, m_packet) < 0) {
+                if (draining) {
+                    return frames;
+                }
+                draining = true;
+                avcodec_send_packet(m_decoder, nullptr);
+                continue;
+            }
+            if (m_packet->stream_index == m_streamIndex) {
+                avcodec_send_packet(m_decoder, m_packet);
+            }
+            av_packet_unref(m_packet);
+        }
+    }
+
+    const FramePool& GetPool() const { return m_pool; }
+
+private:
+    FramePool m_pool; // Outlives the codec, which may free frames on close
+    AVFormatContext* m_input = nullptr;
+    AVCodecContext* m_decoder = nullptr;
+    AVPacket* m_packet = nullptr;
+    int m_streamIndex = -1;
+    std::vector<AVFrame*> m_held;
+    size_t m_next = 0;
+};
+
+class FramePoolTest : public ::testing::TestWithParam<int> {
+protected:
+    void SetUp() override {
+        ClipSpec spec;
+        spec.width = 640;
+        spec.height = 360;
+        spec.frameCount = 90;
+        m_path = MakeTempPath("frame_pool.mp4");
+        ASSERT_TRUE(WriteClip(m_path, spec));
+    }
+
+    void TearDown() override {
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    std::string m_path;
+};
+
+TEST_P(FramePoolTest, NoAllocationsAfterFirstLoop) {
+    PooledDecoder decoder;
+    ASSERT_TRUE(decoder.Open(m_path, GetParam()));
+
+    std::set<const uint8_t*> warmBuffers;
+    int frames = decoder.DecodeLoop(warmBuffers);
+    ASSERT_GT(frames, 0);
+
+    // Warm-up allocates a buffer per frame in flight, not per frame decoded
+    uint64_t warmAllocations = decoder.GetPool().GetAllocationCount();
+    size_t warmBytes = decoder.GetPool().GetAllocatedBytes();
+    EXPECT_GT(warmAllocations, 0u);
+    EXPECT_LT(warmAllocations, static_cast<uint64_t>(frames));
+    EXPECT_EQ(warmBuffers.size(), warmAllocations);
+
+    for (int loop = 1; loop < LOOPS; loop++) {
+        std::set<const uint8_t*> buffers;
+        EXPECT_EQ(decoder.DecodeLoop(buffers), frames) << "loop " << loop;
+        EXPECT_EQ(decoder.GetPool().GetAllocationCount(), warmAllocations) << "loop " << loop;
+        EXPECT_EQ(decoder.GetPool().GetAllocatedBytes(), warmBytes) << "loop " << loop;
+
+        // Every frame was served from a buffer the pool already had
+        for (const uint8_t* buffer : buffers) {
+            EXPECT_EQ(warmBuffers.count(buffer), 1u) << "loop " << loop;
+        }
+    }
+}
+
+// Frame threading keeps a frame in flight per thread
+INSTANTIATE_TEST_SUITE_P(Threads, FramePoolTest, ::testing::Values(1, 4),
+                         [](const ::testing::TestParamInfo<int>& info) {
+                             return std::to_string(info.param) + "Threads";
+                         });
+
+/**
+ * Play a decoder on a virtual clock, decoding inline, until some frames were presented
+ */
+void PlayFrames(VideoDecoder& decoder, double& now, int frames) {
+    for (int presented = 0; presented < frames;) {
+        if (decoder.UpdatePlayback(now)) {
+            presented++;
+        }
+        now += std::max(decoder.GetTimeToNextFrame(now), MIN_TICK_INTERVAL);
+    }
+}
+
+TEST(DecoderAllocationTest, LoopingPlaybackAllocatesNothingPerFrame) {
+    ClipSpec spec;
+    spec.width = 640;
+    spec.height = 360;
+    spec.frameCount = 300;
+    std::string path = MakeTempPath("frame_pool_playback.mp4");
+    ASSERT_TRUE(WriteClip(path, spec));
+
+    // Decoded again on every loop rather than replayed from the loop cache
+    DecoderOptions options;
+    options.loopCacheBudget = 0;
+    VideoDecoder decoder;
+    ASSERT_TRUE(decoder.Initialize(std::filesystem::path(path).wstring(), nullptr, options));
+    ASSERT_TRUE(decoder.DecodeNextFrame());
+
+    double now = 1000.0;
+    PlayFrames(decoder, now, spec.frameCount + 1);
+    uint64_t warmBuffers = decoder.GetFrameBufferAllocations();
+    uint64_t warmHeap = s_heapAllocations.load();
+    ASSERT_GT(warmBuffers, 0u) << "not decoding into the frame pool";
+
+    constexpr int MEASURED_LOOPS = LOOPS - 1;
+    PlayFrames(decoder, now, MEASURED_LOOPS * spec.frameCount);
+
+    // Frames reuse pooled buffers and queue slots; what little is allocated
+    // comes once per loop, not once per frame
+    EXPECT_EQ(decoder.GetFrameBufferAllocations(), warmBuffers);
+    EXPECT_LE(s_heapAllocations.load() - warmHeap, MEASURED_LOOPS * ALLOCATIONS_PER_LOOP);
+
+    decoder.Shutdown();
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,126 @@
+#include "video/MappedFileInput.h"
+#include "support/TestMedia.h"
+
+#include <Windows.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int LOOPS = 4;
+
+// Read syscalls (ReadFile and friends) made by this process so far
+uint64_t GetReadOperationCount() {
+    IO_COUNTERS counters = {};
+    GetProcessIoCounters(GetCurrentProcess(), &counters);
+    return counters.ReadOperationCount;
+}
+
+/**
+ * Demux every packet of the file from the start, as one pass of looping playback
+ * @return read syscalls made during the pass
+ */
+uint64_t DemuxLoop(AVFormatContext* formatContext) {
+    uint64_t startReads = GetReadOperationCount();
+    EXPECT_GE(av_seek_frame(formatContext, -1, 0, AVSEEK_FLAG_BACKWARD), 0);
+
+    AVPacket* packet = av_packet_alloc();
+    int packets = 0;
+    while (av_read_frame(formatContext, packet) >= 0) {
+        av_packet_unref(packet);
+        packets++;
+    }
+    av_packet_free(&packet);
+
+    EXPECT_GT(packets, 0);
+    return GetReadOperationCount() - startReads;
+}
+
+class MappedFileInputTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ClipSpec spec;
+        spec.frameCount = 150;
+        m_path = MakeTempPath("mapped_input.mp4");
+        ASSERT_TRUE(WriteClip(m_path, spec));
+    }
+
+    void TearDown() override {
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    /**
+     * Loop over the file through MappedFileInput; checks the reads it served
+     * per loop and returns the read syscalls per loop
+     */
+    std::vector<uint64_t> DemuxMapped(size_t preloadLimit) {
+        MappedFileInput input;
+        EXPECT_TRUE(input.Open(std::filesystem::path(m_path).wstring(), preloadLimit));
+
+        AVFormatContext* formatContext = avformat_alloc_context();
+        formatContext->pb = input.GetContext();
+        formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        EXPECT_GE(avformat_open_input(&formatContext, m_path.c_str(), nullptr, nullptr), 0);
+        if (!formatContext) {
+            return {};
+        }
+
+        // Served from memory, the same amount every loop
+        std::vector<uint64_t> servedReads;
+        std::vector<uint64_t> syscalls;
+        for (int loop = 0; loop < LOOPS; loop++) {
+            uint64_t startCount = input.GetReadCount();
+            syscalls.push_back(DemuxLoop(formatContext));
+            servedReads.push_back(input.GetReadCount() - startCount);
+        }
+        for (int loop = 1; loop < LOOPS; loop++) {
+            EXPECT_GT(servedReads[loop], 0u) << "loop " << loop;
+            EXPECT_EQ(servedReads[loop], servedReads[1]) << "loop " << loop;
+        }
+
+        avformat_close_input(&formatContext);
+        return syscalls;
+    }
+
+    std::string m_path;
+};
+
+TEST_F(MappedFileInputTest, FileProtocolReadsEveryLoop) {
+    // The path MappedFileInput replaces: the comparison for the tests below
+    AVFormatContext* formatContext = nullptr;
+    ASSERT_GE(avformat_open_input(&formatContext, m_path.c_str(), nullptr, nullptr), 0);
+    for (int loop = 0; loop < LOOPS; loop++) {
+        EXPECT_GT(DemuxLoop(formatContext), 0u) << "loop " << loop;
+    }
+    avformat_close_input(&formatContext);
+}
+
+TEST_F(MappedFileInputTest, MappedLoopsMakeNoReadSyscalls) {
+    std::vector<uint64_t> reads = DemuxMapped(0);
+    ASSERT_EQ(reads.size(), static_cast<size_t>(LOOPS));
+
+    // Pages come in through faults (and the read-ahead thread), never ReadFile
+    for (int loop = 0; loop < LOOPS; loop++) {
+        EXPECT_EQ(reads[loop], 0u) << "loop " << loop;
+    }
+}
+
+TEST_F(MappedFileInputTest, PreloadedLoopsMakeNoReadSyscalls) {
+    std::vector<uint64_t> reads = DemuxMapped(64 * 1024 * 1024);
+    ASSERT_EQ(reads.size(), static_cast<size_t>(LOOPS));
+
+    for (int loop = 0; loop < LOOPS; loop++) {
+        EXPECT_EQ(reads[loop], 0u) << "loop " << loop;
+    }
+}
+
+} // namespace
+} // namespace PixelMotion
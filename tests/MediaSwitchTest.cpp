@@ -0,0 +1,160 @@
+#include "desktop/Playlist.h"
+#include "desktop/WallpaperWindow.h"
+#include "video/PresentationClock.h"
+#include "support/TestMedia.h"
+
+#include <Windows.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace PixelMotion {
+namespace {
+
+// Test clips and the window they play in
+constexpr int CLIP_WIDTH = 1280;
+constexpr int CLIP_HEIGHT = 720;
+constexpr int CLIP_SECONDS = 4;
+
+// Configuration's default crossfade
+constexpr double CROSSFADE_SECONDS = 1.0;
+
+// Time on the first item; shorter than the prefetch lead, so the next one
+// loads from the first tick while the current one plays
+constexpr double ITEM_SECONDS = 1.5;
+
+// Longest sleep between ticks, as DesktopManager's message loop
+constexpr double MAX_TICK_INTERVAL = 0.005;
+
+// Bound on the item interval plus loading the next video on a slow machine
+constexpr double SWITCH_TIMEOUT_SECONDS = 10.0;
+
+/**
+ * What the main loop saw while ticking a window
+ */
+struct TickStats {
+    double longestTick = 0.0; // Update and Render between two sleeps (seconds)
+    int repaints = 0;
+};
+
+/**
+ * A wallpaper window playing a two-item playlist of generated videos, hosted
+ * by a hidden window in place of the desktop's WorkerW
+ */
+class MediaSwitchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ClipSpec spec;
+        spec.width = CLIP_WIDTH;
+        spec.height = CLIP_HEIGHT;
+        spec.frameCount = CLIP_SECONDS * spec.frameRate;
+        m_currentPath = MakeTempPath("switch_current.mp4");
+        m_nextPath = MakeTempPath("switch_next.mp4");
+        ASSERT_TRUE(WriteClip(m_currentPath, spec));
+        ASSERT_TRUE(WriteClip(m_nextPath, spec));
+
+        m_host = CreateWindowEx(0, L"STATIC", L"", WS_POPUP, 0, 0, CLIP_WIDTH, CLIP_HEIGHT, nullptr, nullptr,
+                                GetModuleHandle(nullptr), nullptr);
+        ASSERT_NE(m_host, nullptr);
+
+        MonitorInfo monitor = {};
+        monitor.deviceName = L"\\\\.\\TEST";
+        monitor.bounds = {0, 0, CLIP_WIDTH, CLIP_HEIGHT};
+        monitor.width = CLIP_WIDTH;
+        monitor.height = CLIP_HEIGHT;
+        monitor.refreshRate = 60;
+        monitor.isPrimary = true;
+        if (!m_window.Create(m_host, monitor)) {
+            GTEST_SKIP() << "No D3D11 device to render on";
+        }
+    }
+
+    void TearDown() override {
+        m_window.Destroy();
+        if (m_host) {
+            DestroyWindow(m_host);
+        }
+        std::error_code error;
+        std::filesystem::remove(m_currentPath, error);
+        std::filesystem::remove(m_nextPath, error);
+    }
+
+    /**
+     * Run the window like DesktopManager's message loop until the condition
+     * holds or the time is up
+     * @return false on timeout
+     */
+    template <typename Condition>
+    bool RunUntil(Condition done, double seconds, TickStats& stats) {
+        double startTime = PresentationClock::Now();
+        while (!done()) {
+            if (PresentationClock::Now() - startTime >= seconds) {
+                return false;
+            }
+
+            double tickStart = PresentationClock::Now();
+            m_window.Update();
+            if (m_window.NeedsRepaint()) {
+                m_window.Render();
+                stats.repaints++;
+            }
+            stats.longestTick = std::max(stats.longestTick, PresentationClock::Now() - tickStart);
+
+            double wait = std::clamp(m_window.GetTimeToNextFrame(), 0.0, MAX_TICK_INTERVAL);
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+        return true;
+    }
+
+    std::wstring CurrentPath() const { return std::filesystem::path(m_currentPath).wstring(); }
+    std::wstring NextPath() const { return std::filesystem::path(m_nextPath).wstring(); }
+
+    HWND m_host = nullptr;
+    WallpaperWindow m_window;
+    std::string m_currentPath;
+    std::string m_nextPath;
+};
+
+TEST_F(MediaSwitchTest, PlaylistSwitchCrossfadesWithoutMissingDeadlines) {
+    ASSERT_TRUE(m_window.LoadVideo(CurrentPath()));
+    m_window.SetCrossfadeDuration(CROSSFADE_SECONDS);
+    m_window.SetPlaylist(Playlist({CurrentPath(), NextPath()}), 0, ITEM_SECONDS);
+
+    // The next item loads in the background while the current one plays, and
+    // UpdatePlaylist swaps it in once the interval is up
+    TickStats before;
+    int lateFrames = 0;
+    ASSERT_TRUE(RunUntil(
+        [&] {
+            if (m_window.GetMediaPath() != NextPath()) {
+                lateFrames = m_window.GetLateFrameCount(); // Of the current video, until it is gone
+                return false;
+            }
+            return true;
+        },
+        SWITCH_TIMEOUT_SECONDS, before))
+        << "Playlist never advanced";
+    EXPECT_EQ(lateFrames, 0) << "Loading the next video delayed the current one";
+    EXPECT_GE(before.repaints, static_cast<int>(ITEM_SECONDS * ClipSpec().frameRate) - 2);
+
+    // SwitchTo kept the old picture to fade out from
+    EXPECT_TRUE(m_window.IsCrossfading());
+
+    // UpdateCrossfade fades it out over the configured time while the new video plays on schedule
+    TickStats during;
+    EXPECT_TRUE(RunUntil([&] { return !m_window.IsCrossfading(); }, CROSSFADE_SECONDS + 0.5, during))
+        << "Crossfade never finished";
+    EXPECT_EQ(m_window.GetLateFrameCount(), 0);
+    EXPECT_GE(during.repaints, static_cast<int>(CROSSFADE_SECONDS * ClipSpec().frameRate) - 2);
+
+    // No tick, the one that switched included, held the loop for a frame
+    double frameInterval = 1.0 / ClipSpec().frameRate;
+    EXPECT_LT(before.longestTick, frameInterval);
+    EXPECT_LT(during.longestTick, frameInterval);
+}
+
+} // namespace
+} // namespace PixelMotion
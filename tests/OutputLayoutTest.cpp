@@ -0,0 +1,78 @@
+#include "video/OutputLayout.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <initializer_list>
+
+namespace PixelMotion {
+namespace {
+
+constexpr int SOURCE_WIDTH = 3840;
+constexpr int SOURCE_HEIGHT = 2160;
+
+struct OutputSize {
+    int width = 0;
+    int height = 0;
+};
+
+// What GetFrameTexture converts a 4K frame to for these windows
+OutputSize GetMergedOutput(std::initializer_list<OutputLayout> layouts) {
+    OutputRequest request;
+    for (const OutputLayout& layout : layouts) {
+        request.Add(layout);
+    }
+    OutputSize size;
+    request.GetOutputSize(std::min(request.cropWidth, SOURCE_WIDTH), std::min(request.cropHeight, SOURCE_HEIGHT),
+                          &size.width, &size.height);
+    return size;
+}
+
+OutputLayout Layout(int monitorWidth, int monitorHeight, int scalingMode) {
+    return OutputLayout::Compute(SOURCE_WIDTH, SOURCE_HEIGHT, monitorWidth, monitorHeight, scalingMode, true);
+}
+
+TEST(OutputLayoutTest, StretchScalesEachAxisOnItsOwn) {
+    OutputLayout portrait = Layout(1080, 1920, 2);
+    EXPECT_EQ(portrait.cropWidth, SOURCE_WIDTH);
+    EXPECT_EQ(portrait.cropHeight, SOURCE_HEIGHT);
+    EXPECT_EQ(portrait.width, 1080);
+    EXPECT_EQ(portrait.height, 1920);
+
+    OutputLayout wide = Layout(1920, 1200, 2);
+    EXPECT_EQ(wide.width, 1920);
+    EXPECT_EQ(wide.height, 1200);
+}
+
+TEST(OutputLayoutTest, MergedStretchRequestKeepsEveryRowTheMonitorShows) {
+    // A single scale from the width would give 1080x608 and 1920x1080
+    OutputSize portrait = GetMergedOutput({Layout(1080, 1920, 2)});
+    EXPECT_EQ(portrait.width, 1080);
+    EXPECT_EQ(portrait.height, 1920);
+
+    OutputSize wide = GetMergedOutput({Layout(1920, 1200, 2)});
+    EXPECT_EQ(wide.width, 1920);
+    EXPECT_EQ(wide.height, 1200);
+}
+
+TEST(OutputLayoutTest, MergedRequestCoversEveryWindow) {
+    // Fill on 1080p needs the whole frame at half size, Stretch on the portrait monitor more rows
+    OutputSize size = GetMergedOutput({Layout(1920, 1080, 0), Layout(1080, 1920, 2)});
+    EXPECT_EQ(size.width, 1920);
+    EXPECT_EQ(size.height, 1920);
+
+    // Fill on an ultrawide crops rows; Fit on 1080p still needs them all
+    OutputLayout ultrawide = Layout(2560, 1080, 0);
+    EXPECT_LT(ultrawide.cropHeight, SOURCE_HEIGHT);
+    size = GetMergedOutput({ultrawide, Layout(1920, 1080, 1)});
+    EXPECT_EQ(size.width, 2560);
+    EXPECT_GE(size.height, 1080);
+}
+
+TEST(OutputLayoutTest, MergedRequestNeverUpscales) {
+    OutputSize size = GetMergedOutput({Layout(7680, 4320, 2)});
+    EXPECT_EQ(size.width, SOURCE_WIDTH);
+    EXPECT_EQ(size.height, SOURCE_HEIGHT);
+}
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,183 @@
+#include "video/FrameQueue.h"
+#include "video/PlaybackScheduler.h"
+#include "video/PresentationClock.h"
+#include "support/TestMedia.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+// Same depth as VideoDecoder's decode-ahead queue
+constexpr size_t QUEUE_DEPTH = 5;
+constexpr int FRAME_RATE = 30;
+constexpr int CLIP_FRAMES = FRAME_RATE * 3;
+
+// Longest sleep between ticks, as a wallpaper window's message loop
+constexpr double MAX_TICK_INTERVAL = 0.005;
+
+/**
+ * Software-decodes a clip for the scheduler in place of VideoDecoder, with
+ * the decode thread stalling before every stallEvery-th frame
+ */
+class StallingClipProducer : public FrameProducer {
+public:
+    StallingClipProducer(int stallEvery, int stallMs)
+        : m_stallEvery(stallEvery)
+        , m_stallMs(stallMs)
+        , m_decoded(0)
+    {
+    }
+
+    bool Open(const std::string& path) { return m_reader.Open(path); }
+
+    /**
+     * Decode the first frame synchronously, as VideoDecoder::Initialize does
+     */
+    bool ReadFirstFrame(AVFrame* frame) { return ReadFrame(frame); }
+
+    bool ProduceFrame(FrameQueue& queue) override {
+        if (m_stallEvery > 0 && m_decoded % m_stallEvery == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_stallMs));
+        }
+
+        AVFrame* frame = av_frame_alloc();
+        bool produced = ReadFrame(frame) && queue.Push(frame);
+        av_frame_free(&frame);
+        return produced;
+    }
+
+private:
+    bool ReadFrame(AVFrame* frame) {
+        if (!m_reader.ReadFrame(frame)) {
+            return false; // End of clip
+        }
+
+        // Queued frames carry microsecond timestamps, as on the decoder's timeline
+        frame->pts = static_cast<int64_t>(m_reader.GetFrameTime(frame) * 1.0e6 + 0.5);
+        frame->duration = 1000000 / FRAME_RATE;
+        m_decoded++;
+        return true;
+    }
+
+    ClipReader m_reader;
+    int m_stallEvery;
+    int m_stallMs;
+    int m_decoded;
+};
+
+/**
+ * Producer that never delivers a frame
+ */
+class FailingProducer : public FrameProducer {
+public:
+    bool ProduceFrame(FrameQueue&) override { return false; }
+};
+
+struct PipelineResult {
+    int presented = 0;  // Frames made current, the first one included
+    int lateFrames = 0; // Frames not decoded yet when they were due
+};
+
+/**
+ * Play a clip through PlaybackScheduler's decode thread and presentation
+ * schedule, ticking it like WallpaperWindow::Update until the last frame is
+ * current
+ * @param stallEvery The decode thread stalls before every stallEvery-th frame, 0 = never
+ */
+PipelineResult RunPipeline(const std::string& path, int stallEvery, int stallMs) {
+    PipelineResult result;
+    StallingClipProducer producer(stallEvery, stallMs);
+    AVFrame* current = av_frame_alloc();
+    if (!producer.Open(path) || !producer.ReadFirstFrame(current)) {
+        ADD_FAILURE() << "Failed to open " << path;
+        av_frame_free(&current);
+        return result;
+    }
+    result.presented++;
+
+    PlaybackScheduler scheduler(producer, QUEUE_DEPTH);
+    EXPECT_TRUE(scheduler.StartDecodeThread());
+
+    int64_t lastPts = static_cast<int64_t>(CLIP_FRAMES - 1) * 1000000 / FRAME_RATE;
+    double deadline = PresentationClock::Now() + 2.0 * CLIP_FRAMES / FRAME_RATE;
+    while (current->pts < lastPts - 1 && PresentationClock::Now() < deadline) {
+        double now = PresentationClock::Now();
+        if (scheduler.UpdatePlayback(now, current)) {
+            result.presented++;
+        }
+        double wait = std::min(scheduler.GetTimeToNextFrame(now), MAX_TICK_INTERVAL);
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+
+    result.lateFrames = scheduler.GetLateFrameCount();
+    scheduler.StopDecodeThread();
+    av_frame_free(&current);
+    return result;
+}
+
+class PlaybackPipelineTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        s_clipPath = MakeTempPath("pipeline.mp4");
+        ClipSpec spec;
+        spec.frameCount = CLIP_FRAMES;
+        spec.frameRate = FRAME_RATE;
+        ASSERT_TRUE(WriteClip(s_clipPath, spec));
+    }
+
+    static void TearDownTestSuite() {
+        std::error_code error;
+        std::filesystem::remove(s_clipPath, error);
+    }
+
+    static std::string s_clipPath;
+};
+
+std::string PlaybackPipelineTest::s_clipPath;
+
+TEST_F(PlaybackPipelineTest, PresentsEveryFrameOnTime) {
+    PipelineResult result = RunPipeline(s_clipPath, 0, 0);
+    EXPECT_EQ(result.presented, CLIP_FRAMES);
+    EXPECT_EQ(result.lateFrames, 0);
+}
+
+TEST_F(PlaybackPipelineTest, QueueAbsorbsStallsShorterThanItsDepth) {
+    // 2.5 frame intervals every 20 frames, well inside the 5 queued frames
+    PipelineResult result = RunPipeline(s_clipPath, 20, 83);
+    EXPECT_EQ(result.presented, CLIP_FRAMES);
+    EXPECT_EQ(result.lateFrames, 0);
+}
+
+TEST_F(PlaybackPipelineTest, StallLongerThanQueueMissesDeadlines) {
+    // Sanity check of the measurement: 10 frame intervals can't be hidden by 5 queued frames
+    PipelineResult result = RunPipeline(s_clipPath, 45, 333);
+    EXPECT_GT(result.lateFrames, 0);
+}
+
+TEST_F(PlaybackPipelineTest, InlineDecodingGivesUpAfterRepeatedErrors) {
+    FailingProducer producer;
+    PlaybackScheduler scheduler(producer, QUEUE_DEPTH);
+    AVFrame* current = av_frame_alloc();
+    current->pts = 0;
+    current->duration = 1000000 / FRAME_RATE;
+
+    double now = PresentationClock::Now();
+    for (int tick = 0; tick < 100 && !scheduler.HasDecodeFailed(); tick++) {
+        EXPECT_FALSE(scheduler.UpdatePlayback(now, current));
+    }
+    EXPECT_TRUE(scheduler.HasDecodeFailed());
+    EXPECT_DOUBLE_EQ(scheduler.GetTimeToNextFrame(now), 1.0);
+    av_frame_free(&current);
+}
+
+} // namespace
+} // namespace PixelMotion
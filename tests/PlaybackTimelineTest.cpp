@@ -0,0 +1,56 @@
+#include "video/PlaybackTimeline.h"
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavutil/avutil.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+constexpr int64_t FRAME_DURATION = 40000; // 25 FPS
+
+TEST(PlaybackTimelineTest, PlacesFramesAtTheirStreamTime) {
+    PlaybackTimeline timeline;
+    EXPECT_EQ(timeline.Place(0, FRAME_DURATION), 0);
+    EXPECT_EQ(timeline.Place(FRAME_DURATION, FRAME_DURATION), FRAME_DURATION);
+    // A dropped frame leaves a gap rather than pulling later frames forward
+    EXPECT_EQ(timeline.Place(3 * FRAME_DURATION, FRAME_DURATION), 3 * FRAME_DURATION);
+    EXPECT_EQ(timeline.GetEnd(), 4 * FRAME_DURATION);
+}
+
+TEST(PlaybackTimelineTest, LoopsContinueAfterTheLastFrame) {
+    PlaybackTimeline timeline;
+    for (int frame = 0; frame < 10; frame++) {
+        timeline.Place(frame * FRAME_DURATION, FRAME_DURATION);
+    }
+
+    timeline.StartLoop();
+    EXPECT_EQ(timeline.GetLoopOffset(), 10 * FRAME_DURATION);
+    EXPECT_EQ(timeline.Place(0, FRAME_DURATION), 10 * FRAME_DURATION);
+    EXPECT_EQ(timeline.Place(FRAME_DURATION, FRAME_DURATION), 11 * FRAME_DURATION);
+}
+
+TEST(PlaybackTimelineTest, MissingOrBackwardTimestampsFollowThePreviousFrame) {
+    PlaybackTimeline timeline;
+    timeline.Place(0, FRAME_DURATION);
+    EXPECT_EQ(timeline.Place(AV_NOPTS_VALUE, FRAME_DURATION), FRAME_DURATION);
+    EXPECT_EQ(timeline.Place(0, FRAME_DURATION), 2 * FRAME_DURATION);
+    EXPECT_EQ(timeline.Place(2 * FRAME_DURATION, FRAME_DURATION), 3 * FRAME_DURATION);
+}
+
+TEST(PlaybackTimelineTest, ResetStartsOverAtZero) {
+    PlaybackTimeline timeline;
+    timeline.Place(0, FRAME_DURATION);
+    timeline.StartLoop();
+    timeline.Place(5 * FRAME_DURATION, FRAME_DURATION);
+
+    timeline.Reset();
+    EXPECT_EQ(timeline.GetLoopOffset(), 0);
+    EXPECT_EQ(timeline.GetEnd(), 0);
+    EXPECT_EQ(timeline.Place(2 * FRAME_DURATION, FRAME_DURATION), 2 * FRAME_DURATION);
+}
+
+} // namespace
+} // namespace PixelMotion
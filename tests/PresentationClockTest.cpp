@@ -0,0 +1,206 @@
+#include "video/FrameQueue.h"
+#include "video/PlaybackScheduler.h"
+#include "video/PlaybackTimeline.h"
+#include "video/PresentationClock.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+// NTSC rate: frame times are not whole microseconds, so per-frame rounding could add up
+constexpr AVRational STREAM_TIME_BASE = {1001, 30000};
+constexpr double FRAME_INTERVAL = 1001.0 / 30000.0;
+constexpr int LOOP_FRAMES = 60 * 30000 / 1001; // A one minute clip...
+constexpr int CLIP_FRAMES = 10 * LOOP_FRAMES;  // ...looped for ten minutes
+constexpr size_t QUEUE_DEPTH = 5;
+
+TEST(PresentationClockTest, MapsStreamTimeToWallTime) {
+    PresentationClock clock;
+    EXPECT_FALSE(clock.IsStarted());
+
+    clock.Start(100.0, 2.0);
+    EXPECT_TRUE(clock.IsStarted());
+    EXPECT_DOUBLE_EQ(clock.GetDueTime(2.0), 100.0);
+    EXPECT_DOUBLE_EQ(clock.GetDueTime(2.5), 100.5);
+    EXPECT_DOUBLE_EQ(clock.GetStreamTime(101.0), 3.0);
+
+    clock.Stop();
+    EXPECT_FALSE(clock.IsStarted());
+}
+
+/**
+ * Synthetic looping clip, timestamped the way VideoDecoder::TimestampFrame and
+ * LoopPlayback do: stream times rescaled per frame to microseconds and placed
+ * on a PlaybackTimeline that restarts the stream at every loop
+ */
+class VirtualClip : public FrameProducer {
+public:
+    VirtualClip() : m_position(0) {}
+
+    void ReadFrame(AVFrame* frame) {
+        if (m_position == LOOP_FRAMES) {
+            m_timeline.StartLoop();
+            m_position = 0;
+        }
+
+        int64_t relativePts = av_rescale_q(m_position, STREAM_TIME_BASE, AVRational{1, AV_TIME_BASE});
+        int64_t duration = av_rescale_q(1, STREAM_TIME_BASE, AVRational{1, AV_TIME_BASE});
+        frame->pts = m_timeline.Place(relativePts, duration);
+        frame->duration = duration;
+        m_position++;
+    }
+
+    bool ProduceFrame(FrameQueue& queue) override {
+        AVFrame* frame = av_frame_alloc();
+        ReadFrame(frame);
+        bool pushed = queue.Push(frame);
+        av_frame_free(&frame);
+        return pushed;
+    }
+
+private:
+    PlaybackTimeline m_timeline;
+    int m_position;
+};
+
+/**
+ * Plays a VirtualClip through PlaybackScheduler (decoding inline, as without
+ * a decode thread) on a virtual wall clock ticking at the display refresh rate
+ */
+class VirtualPlayback {
+public:
+    explicit VirtualPlayback(double refreshRate)
+        : m_scheduler(m_clip, QUEUE_DEPTH)
+        , m_current(av_frame_alloc())
+        , m_refreshRate(refreshRate)
+        , m_now(1000.0)
+    {
+        m_clip.ReadFrame(m_current); // The first frame, decoded when the file opens
+    }
+
+    ~VirtualPlayback() { av_frame_free(&m_current); }
+
+    /**
+     * Advance to the next vsync
+     * @return true if a new frame became current
+     */
+    bool Tick() {
+        bool presented = m_scheduler.UpdatePlayback(m_now, m_current);
+        m_now += 1.0 / m_refreshRate;
+        return presented;
+    }
+
+    void Stall(double seconds) { m_now += seconds; }
+
+    double GetPresentTime() const { return m_now - 1.0 / m_refreshRate; } // Of the last tick
+    int64_t GetCurrentPts() const { return m_current->pts; }
+    const PlaybackScheduler& GetScheduler() const { return m_scheduler; }
+
+private:
+    VirtualClip m_clip;
+    PlaybackScheduler m_scheduler;
+    AVFrame* m_current;
+    double m_refreshRate;
+    double m_now; // Seconds
+};
+
+struct DriftResult {
+    int presented = 0;
+    int nonIncreasing = 0;   // Frames whose timeline pts did not follow their predecessor's
+    double maxError = 0.0;   // Largest |shown - ideal| of any frame (seconds)
+    double firstMinute = 0.0; // Mean error over the first and the last minute
+    double lastMinute = 0.0;
+};
+
+DriftResult PlayVirtualClip(double refreshRate) {
+    DriftResult result;
+    VirtualPlayback playback(refreshRate);
+    double firstSum = 0.0;
+    double lastSum = 0.0;
+
+    // The first frame is on screen from the first tick
+    playback.Tick();
+    double startTime = playback.GetPresentTime();
+    int64_t lastPts = playback.GetCurrentPts();
+    result.presented = 1;
+
+    while (result.presented < CLIP_FRAMES) {
+        if (!playback.Tick()) {
+            continue;
+        }
+
+        if (playback.GetCurrentPts() <= lastPts) {
+            result.nonIncreasing++;
+        }
+        lastPts = playback.GetCurrentPts();
+
+        // Where an ideal display would put this frame, independent of the clock
+        double ideal = startTime + result.presented * FRAME_INTERVAL;
+        double error = playback.GetPresentTime() - ideal;
+        result.maxError = std::max(result.maxError, std::abs(error));
+        if (result.presented < LOOP_FRAMES) {
+            firstSum += error;
+        } else if (result.presented >= CLIP_FRAMES - LOOP_FRAMES) {
+            lastSum += error;
+        }
+        result.presented++;
+    }
+
+    EXPECT_EQ(playback.GetScheduler().GetLateFrameCount(), 0);
+    result.firstMinute = firstSum / LOOP_FRAMES;
+    result.lastMinute = lastSum / LOOP_FRAMES;
+    return result;
+}
+
+TEST(PresentationClockTest, TenMinutesOfLoopsDoNotDrift) {
+    for (double refreshRate : {60.0, 59.94, 144.0}) {
+        SCOPED_TRACE(refreshRate);
+        DriftResult result = PlayVirtualClip(refreshRate);
+
+        EXPECT_EQ(result.presented, CLIP_FRAMES);
+        EXPECT_EQ(result.nonIncreasing, 0);
+        // Each frame shows at the first vsync after it is due, never a frame late
+        EXPECT_LT(result.maxError, FRAME_INTERVAL);
+        EXPECT_LE(result.maxError, 1.0 / refreshRate + 1.0e-6);
+        // and the offset at the end of the clip is the offset it started with
+        EXPECT_LT(std::abs(result.lastMinute - result.firstMinute), FRAME_INTERVAL);
+    }
+}
+
+TEST(PresentationClockTest, StallResyncsInsteadOfFastForwarding) {
+    constexpr double REFRESH_RATE = 60.0;
+    VirtualPlayback playback(REFRESH_RATE);
+    for (int tick = 0; tick < 2 * REFRESH_RATE; tick++) {
+        playback.Tick();
+    }
+
+    // Longer than the resync threshold, as when the display wakes from sleep
+    playback.Stall(1.0);
+
+    std::vector<double> presentTimes;
+    while (presentTimes.size() < 30) {
+        if (playback.Tick()) {
+            presentTimes.push_back(playback.GetPresentTime());
+        }
+    }
+
+    // Playback picks up from the overdue frame at its normal rate instead of
+    // presenting the frames it missed on consecutive vsyncs
+    for (size_t i = 1; i < presentTimes.size(); i++) {
+        EXPECT_GT(presentTimes[i] - presentTimes[i - 1], FRAME_INTERVAL - 1.0 / REFRESH_RATE) << "frame " << i;
+    }
+    EXPECT_EQ(playback.GetScheduler().GetLateFrameCount(), 0);
+}
+
+} // namespace
+} // namespace PixelMotion
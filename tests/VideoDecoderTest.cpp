@@ -0,0 +1,153 @@
+#include "video/VideoDecoder.h"
+#include "support/TestMedia.h"
+
+#include <Windows.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/frame.h>
+}
+
+namespace PixelMotion {
+namespace {
+
+std::wstring ToWide(const std::string& path) {
+    return std::filesystem::path(path).wstring();
+}
+
+// CPU time of the whole process, including FFmpeg's decoder threads (seconds)
+double GetProcessCpuTime() {
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0.0;
+    }
+
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return static_cast<double>(kernel.QuadPart + user.QuadPart) / 1.0e7; // 100ns units
+}
+
+/**
+ * Generated clips removed again at the end of each test
+ */
+class VideoDecoderTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        std::error_code error;
+        for (const std::string& path : m_paths) {
+            std::filesystem::remove(path, error);
+        }
+    }
+
+    std::string MakeClip(const std::string& name, const ClipSpec& spec) {
+        std::string path = MakeTempPath(name);
+        m_paths.push_back(path);
+        EXPECT_TRUE(WriteClip(path, spec)) << "Failed to write " << name;
+        return path;
+    }
+
+private:
+    std::vector<std::string> m_paths;
+};
+
+class BFrameDecodeTest : public VideoDecoderTest, public ::testing::WithParamInterface<const char*> {};
+
+TEST_P(BFrameDecodeTest, DecodesEveryFrameInTheContainer) {
+    const char* codec = GetParam();
+    if (!HasEncoder(codec)) {
+        GTEST_SKIP() << codec << " encoder not available";
+    }
+
+    // Reordered frames are held by the decoder until the flush at end of file
+    ClipSpec spec;
+    spec.codec = codec;
+    spec.frameCount = 75;
+    spec.gopSize = 25;
+    spec.maxBFrames = 3;
+    std::string path = MakeClip(std::string("bframes_") + codec + ".mp4", spec);
+
+    ClipReader reader;
+    ASSERT_TRUE(reader.Open(path));
+    ASSERT_EQ(reader.GetContainerFrameCount(), spec.frameCount);
+
+    VideoDecoder decoder;
+    ASSERT_TRUE(decoder.Initialize(ToWide(path), nullptr));
+    int decoded = 0;
+    int64_t lastPts = -1;
+    while (decoder.DecodeNextFrame()) {
+        // Presentation order, as the container stores them
+        EXPECT_GT(decoder.GetCurrentFrame()->pts, lastPts);
+        lastPts = decoder.GetCurrentFrame()->pts;
+        decoded++;
+    }
+
+    EXPECT_TRUE(decoder.IsEndOfFile());
+    EXPECT_EQ(decoded, reader.GetContainerFrameCount());
+    EXPECT_DOUBLE_EQ(decoder.GetFramesPerPacket(), 1.0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, BFrameDecodeTest, ::testing::Values("libx264", "mpeg4"),
+                         [](const ::testing::TestParamInfo<const char*>& info) {
+                             return std::string(info.param);
+                         });
+
+/**
+ * Frames decoded from a whole clip in one decode mode, and the CPU time it took
+ */
+struct ModePass {
+    int frames = 0;
+    double cpuTime = 0.0;
+    std::vector<int64_t> durations; // Playback timeline, microseconds
+};
+
+ModePass DecodeClip(const std::string& path, DecodeMode mode) {
+    ModePass pass;
+    VideoDecoder decoder;
+    decoder.SetDecodeMode(mode);
+    EXPECT_TRUE(decoder.Initialize(ToWide(path), nullptr));
+
+    double cpuStartTime = GetProcessCpuTime();
+    while (decoder.DecodeNextFrame()) {
+        pass.frames++;
+        pass.durations.push_back(decoder.GetCurrentFrame()->duration);
+    }
+    pass.cpuTime = GetProcessCpuTime() - cpuStartTime;
+    EXPECT_TRUE(decoder.IsEndOfFile());
+    return pass;
+}
+
+TEST_F(VideoDecoderTest, KeyframesOnlyDecodesOneFramePerGop) {
+    // Large enough that decoding every frame takes well over the CPU clock's 15.6 ms tick
+    ClipSpec spec;
+    spec.width = 1280;
+    spec.height = 720;
+    spec.frameCount = 300;
+    spec.gopSize = 60;
+    std::string path = MakeClip("keyframes_only.mp4", spec);
+
+    ModePass normal = DecodeClip(path, DecodeMode::Normal);
+    ModePass keyframes = DecodeClip(path, DecodeMode::KeyframesOnly);
+
+    EXPECT_EQ(normal.frames, spec.frameCount);
+    EXPECT_EQ(keyframes.frames, spec.frameCount / spec.gopSize);
+
+    // Each keyframe stays up for its whole GOP, so the clip keeps its length
+    int64_t gopDuration = static_cast<int64_t>(spec.gopSize) * AV_TIME_BASE / spec.frameRate;
+    for (int64_t duration : keyframes.durations) {
+        EXPECT_NEAR(duration, gopDuration, AV_TIME_BASE / spec.frameRate);
+    }
+
+    EXPECT_GT(normal.cpuTime, 0.0);
+    EXPECT_LT(keyframes.cpuTime, normal.cpuTime / 4.0)
+        << "normal " << normal.cpuTime * 1000.0 << " ms, keyframes only " << keyframes.cpuTime * 1000.0 << " ms";
+}
+
+} // namespace
+} // namespace PixelMotion
@@ -0,0 +1,326 @@
+#include "TestMedia.h"
+
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <string>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace PixelMotion {
+
+/**
+ * FFmpeg objects of one clip being written, freed together
+ */
+struct ClipWriter {
+    AVFormatContext* output = nullptr;
+    AVCodecContext* encoder = nullptr;
+    SwsContext* scaler = nullptr;
+    AVFrame* pattern = nullptr; // Drawn in YUV 4:2:0
+    AVFrame* encoded = nullptr; // Converted to the encoder's format
+    AVPacket* packet = nullptr;
+    AVStream* stream = nullptr;
+
+    ~ClipWriter() {
+        av_packet_free(&packet);
+        av_frame_free(&encoded);
+        av_frame_free(&pattern);
+        sws_freeContext(scaler);
+        avcodec_free_context(&encoder);
+        if (output) {
+            if (output->pb && !(output->oformat->flags & AVFMT_NOFILE)) {
+                avio_closep(&output->pb);
+            }
+            avformat_free_context(output);
+        }
+    }
+
+    bool Encode(const AVFrame* frame) {
+        if (avcodec_send_frame(encoder, frame) < 0) {
+            return false;
+        }
+
+        while (true) {
+            int ret = avcodec_receive_packet(encoder, packet);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+                return true;
+            }
+            if (ret < 0) {
+                return false;
+            }
+
+            av_packet_rescale_ts(packet, encoder->time_base, stream->time_base);
+            packet->stream_index = stream->index;
+            if (av_interleaved_write_frame(output, packet) < 0) {
+                return false;
+            }
+        }
+    }
+};
+
+// Diagonal gradient with a bright box that moves across the picture
+static void DrawPattern(AVFrame* frame, int index) {
+    for (int y = 0; y < frame->height; y++) {
+        uint8_t* row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+        for (int x = 0; x < frame->width; x++) {
+            row[x] = static_cast<uint8_t>(16 + (x + y + index * 4) % 200);
+        }
+    }
+
+    int boxSize = frame->height / 4;
+    int boxX = (index * 8) % (frame->width - boxSize);
+    for (int y = boxSize; y < 2 * boxSize; y++) {
+        uint8_t* row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+        for (int x = boxX; x < boxX + boxSize; x++) {
+            row[x] = 235;
+        }
+    }
+
+    for (int plane = 1; plane < 3; plane++) {
+        for (int y = 0; y < frame->height / 2; y++) {
+            uint8_t* row = frame->data[plane] + static_cast<ptrdiff_t>(y) * frame->linesize[plane];
+            for (int x = 0; x < frame->width / 2; x++) {
+                row[x] = static_cast<uint8_t>(plane == 1 ? 64 + (x + index) % 128 : 64 + (y + index) % 128);
+            }
+        }
+    }
+}
+
+bool WriteClip(const std::string& path, const ClipSpec& spec) {
+    const AVCodec* codec = avcodec_find_encoder_by_name(spec.codec);
+    if (!codec) {
+        return false;
+    }
+
+    ClipWriter writer;
+    if (avformat_alloc_output_context2(&writer.output, nullptr, nullptr, path.c_str()) < 0) {
+        return false;
+    }
+
+    // Images with per-frame delays are timed in milliseconds
+    bool timed = !spec.frameDurationsMs.empty();
+    AVRational timeBase = timed ? AVRational{1, 1000} : AVRational{1, spec.frameRate};
+
+    writer.encoder = avcodec_alloc_context3(codec);
+    writer.stream = avformat_new_stream(writer.output, nullptr);
+    writer.packet = av_packet_alloc();
+    if (!writer.encoder || !writer.stream || !writer.packet) {
+        return false;
+    }
+
+    AVCodecContext* encoder = writer.encoder;
+    encoder->width = spec.width;
+    encoder->height = spec.height;
+    encoder->time_base = timeBase;
+    encoder->framerate = AVRational{spec.frameRate, 1};
+    encoder->gop_size = spec.gopSize;
+    encoder->max_b_frames = spec.maxBFrames;
+    encoder->pix_fmt = (codec->pix_fmts && codec->pix_fmts[0] != AV_PIX_FMT_NONE) ? codec->pix_fmts[0]
+                                                                                 : AV_PIX_FMT_YUV420P;
+    if (writer.output->oformat->flags & AVFMT_GLOBALHEADER) {
+        encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if (avcodec_open2(encoder, codec, nullptr) < 0 ||
+        avcodec_parameters_from_context(writer.stream->codecpar, encoder) < 0) {
+        return false;
+    }
+    writer.stream->time_base = timeBase;
+
+    if (!(writer.output->oformat->flags & AVFMT_NOFILE) &&
+        avio_open(&writer.output->pb, path.c_str(), AVIO_FLAG_WRITE) < 0) {
+        return false;
+    }
+    if (avformat_write_header(writer.output, nullptr) < 0) {
+        return false;
+    }
+
+    writer.pattern = av_frame_alloc();
+    writer.encoded = av_frame_alloc();
+    if (!writer.pattern || !writer.encoded) {
+        return false;
+    }
+    writer.pattern->format = AV_PIX_FMT_YUV420P;
+    writer.pattern->width = spec.width;
+    writer.pattern->height = spec.height;
+    if (av_frame_get_buffer(writer.pattern, 0) < 0) {
+        return false;
+    }
+
+    AVFrame* source = writer.pattern;
+    if (encoder->pix_fmt != AV_PIX_FMT_YUV420P) {
+        writer.scaler = sws_getContext(spec.width, spec.height, AV_PIX_FMT_YUV420P,
+                                       spec.width, spec.height, encoder->pix_fmt,
+                                       SWS_POINT, nullptr, nullptr, nullptr);
+        writer.encoded->format = encoder->pix_fmt;
+        writer.encoded->width = spec.width;
+        writer.encoded->height = spec.height;
+        if (!writer.scaler || av_frame_get_buffer(writer.encoded, 0) < 0) {
+            return false;
+        }
+        source = writer.encoded;
+    }
+
+    int64_t pts = 0;
+    for (int i = 0; i < spec.frameCount; i++) {
+        // The encoder may still reference the previous frame's buffers
+        if (av_frame_make_writable(writer.pattern) < 0) {
+            return false;
+        }
+
+        DrawPattern(writer.pattern, i);
+        if (writer.scaler) {
+            if (av_frame_make_writable(writer.encoded) < 0) {
+                return false;
+            }
+            sws_scale(writer.scaler, writer.pattern->data, writer.pattern->linesize, 0, spec.height,
+                      writer.encoded->data, writer.encoded->linesize);
+        }
+
+        int64_t duration = timed ? spec.frameDurationsMs[i % spec.frameDurationsMs.size()] : 1;
+        source->pts = pts;
+        source->duration = duration;
+        pts += duration;
+
+        if (!writer.Encode(source)) {
+            return false;
+        }
+    }
+
+    // Flush frames held back for reordering
+    return writer.Encode(nullptr) && av_write_trailer(writer.output) >= 0;
+}
+
+bool HasEncoder(const char* name) {
+    return avcodec_find_encoder_by_name(name) != nullptr;
+}
+
+AVFrame* MakeNoiseFrame(int pixelFormat, int width, int height, uint32_t seed) {
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        return nullptr;
+    }
+    frame->format = pixelFormat;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    std::mt19937 random(seed);
+    for (AVBufferRef* buffer : frame->buf) {
+        if (!buffer) {
+            break;
+        }
+        for (size_t i = 0; i < buffer->size; i++) {
+            buffer->data[i] = static_cast<uint8_t>(random());
+        }
+    }
+    return frame;
+}
+
+std::string MakeTempPath(const std::string& name) {
+    // ctest may run several test processes at once
+    static const unsigned int processTag = std::random_device{}();
+    static std::atomic<int> counter{0};
+    std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                 ("PixelMotionTest_" + std::to_string(processTag) + "_" +
+                                  std::to_string(counter++) + "_" + name);
+    return path.string();
+}
+
+ClipReader::ClipReader()
+    : m_input(nullptr)
+    , m_decoder(nullptr)
+    , m_packet(nullptr)
+    , m_streamIndex(-1)
+    , m_draining(false)
+{
+}
+
+ClipReader::~ClipReader() {
+    av_packet_free(&m_packet);
+    avcodec_free_context(&m_decoder);
+    avformat_close_input(&m_input);
+}
+
+bool ClipReader::Open(const std::string& path, int threads, int threadType) {
+    if (avformat_open_input(&m_input, path.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(m_input, nullptr) < 0) {
+        return false;
+    }
+
+    const AVCodec* codec = nullptr;
+    m_streamIndex = av_find_best_stream(m_input, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (m_streamIndex < 0 || !codec) {
+        return false;
+    }
+
+    m_decoder = avcodec_alloc_context3(codec);
+    m_packet = av_packet_alloc();
+    if (!m_decoder || !m_packet ||
+        avcodec_parameters_to_context(m_decoder, m_input->streams[m_streamIndex]->codecpar) < 0) {
+        return false;
+    }
+
+    m_decoder->thread_count = threads;
+    if (threadType != 0) {
+        m_decoder->thread_type = threadType;
+    }
+    return avcodec_open2(m_decoder, codec, nullptr) >= 0;
+}
+
+bool ClipReader::ReadFrame(AVFrame* frame) {
+    while (true) {
+        int ret = avcodec_receive_frame(m_decoder, frame);
+        if (ret >= 0) {
+            return true;
+        }
+        if (ret != AVERROR(EAGAIN)) {
+            return false; // Drained, or a decode error
+        }
+
+        ret = av_read_frame(m_input, m_packet);
+        if (ret < 0) {
+            if (m_draining) {
+                return false;
+            }
+            m_draining = true;
+            avcodec_send_packet(m_decoder, nullptr);
+            continue;
+        }
+
+        if (m_packet->stream_index == m_streamIndex) {
+            avcodec_send_packet(m_decoder, m_packet);
+        }
+        av_packet_unref(m_packet);
+    }
+}
+
+double ClipReader::GetFrameTime(const AVFrame* frame) const {
+    const AVStream* stream = m_input->streams[m_streamIndex];
+    int64_t pts = (frame->best_effort_timestamp != AV_NOPTS_VALUE) ? frame->best_effort_timestamp : frame->pts;
+    int64_t start = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+    return static_cast<double>(pts - start) * av_q2d(stream->time_base);
+}
+
+int64_t ClipReader::GetContainerFrameCount() const {
+    return m_input->streams[m_streamIndex]->nb_frames;
+}
+
+double ClipReader::GetFrameRate() const {
+    AVRational rate = m_input->streams[m_streamIndex]->avg_frame_rate;
+    return (rate.num > 0 && rate.den > 0) ? av_q2d(rate) : 0.0;
+}
+
+const AVCodec* ClipReader::GetCodec() const {
+    return m_decoder ? m_decoder->codec : nullptr;
+}
+
+} // namespace PixelMotion
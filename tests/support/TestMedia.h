@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AVCodec;
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+
+namespace PixelMotion {
+
+/**
+ * Description of a generated test clip
+ * Frames show a test pattern that moves by one step per frame
+ */
+struct ClipSpec {
+    int width = 320;
+    int height = 180;
+    int frameCount = 60;
+    int frameRate = 30;
+    int gopSize = 30;
+    int maxBFrames = 0;
+    const char* codec = "mpeg4"; // Encoder name; FFmpeg's native MPEG-4 is always available
+    std::vector<int> frameDurationsMs; // Per-frame display time (animated images), frameRate if empty
+};
+
+/**
+ * Encode a clip into a file; the container is picked from the extension
+ * @return false if FFmpeg lacks the encoder or writing failed
+ */
+bool WriteClip(const std::string& path, const ClipSpec& spec);
+
+/**
+ * Whether FFmpeg was built with the named encoder
+ */
+bool HasEncoder(const char* name);
+
+/**
+ * Software frame of random samples in any pixel format, allocated the way
+ * decoders allocate theirs (padded, aligned rows)
+ * @return nullptr if the format can't be allocated; free with av_frame_free
+ */
+AVFrame* MakeNoiseFrame(int pixelFormat, int width, int height, uint32_t seed);
+
+/**
+ * Unique path in the system temp directory
+ */
+std::string MakeTempPath(const std::string& name);
+
+/**
+ * Plain FFmpeg software decoding of a file, as a reference for the decoder under test
+ */
+class ClipReader {
+public:
+    ClipReader();
+    ~ClipReader();
+
+    ClipReader(const ClipReader&) = delete;
+    ClipReader& operator=(const ClipReader&) = delete;
+
+    /**
+     * @param threads Decoder threads, 0 lets FFmpeg choose
+     * @param threadType FF_THREAD_FRAME and/or FF_THREAD_SLICE, 0 keeps FFmpeg's default
+     */
+    bool Open(const std::string& path, int threads = 1, int threadType = 0);
+
+    /**
+     * Decode the next frame in presentation order, draining the decoder at end of file
+     * @return false at end of stream or on error
+     */
+    bool ReadFrame(AVFrame* frame);
+
+    /**
+     * Frame timestamp in seconds from the start of the stream
+     */
+    double GetFrameTime(const AVFrame* frame) const;
+
+    int64_t GetContainerFrameCount() const; // From the stream header, 0 if unknown
+    double GetFrameRate() const;
+    const AVCodec* GetCodec() const; // Decoder opened for the stream
+
+private:
+    AVFormatContext* m_input;
+    AVCodecContext* m_decoder;
+    AVPacket* m_packet;
+    int m_streamIndex;
+    bool m_draining;
+};
+
+} // namespace PixelMotion